@@ -0,0 +1,99 @@
+// CSV import throughput in MB/s: CsvReader record scanning with the scalar
+// and SSE2 scanners, and the full FileHandler::importFromCsv path that also
+// builds Contacts.
+//
+// Usage: bench_csv_reader [rows]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "core/CsvReader.h"
+#include "core/FileHandler.h"
+
+namespace {
+    // Mostly plain rows; every tenth has a quoted name with a comma and a
+    // doubled quote, as exportToCsv writes them
+    bool writeCsv(const QString& path, int rows) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray chunk = "ID,Name,Phone,Email\n";
+        for (int i = 0; i < rows; ++i) {
+            const QByteArray n = QByteArray::number(i);
+            if (i % 10 == 0) {
+                chunk += n + ",\"Contact, \"\"" + n + "\"\"\",555-" + n + ",contact" + n + "@example.com\n";
+            } else {
+                chunk += n + ",Contact " + n + ",555-" + n + ",contact" + n + "@example.com\n";
+            }
+            if (chunk.size() > (1 << 20)) {
+                file.write(chunk);
+                chunk.clear();
+            }
+        }
+        file.write(chunk);
+        return true;
+    }
+
+    double bestMBps(qint64 bytes, const std::function<void()>& run) {
+        qint64 best = -1;
+        for (int i = 0; i < 3; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            run();
+            const qint64 ns = timer.nsecsElapsed();
+            best = best < 0 ? ns : std::min(best, ns);
+        }
+        return bytes / 1e6 / (std::max<qint64>(best, 1) / 1e9);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int rows = std::max(argc > 1 ? QString(argv[1]).toInt() : 1000000, 1);
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("contacts.csv");
+    if (!dir.isValid() || !writeCsv(path, rows)) {
+        std::printf("Could not write the benchmark file\n");
+        return 1;
+    }
+    const qint64 bytes = QFile(path).size();
+    std::printf("%d rows, %.1f MB\n\n", rows, bytes / 1e6);
+
+    auto scan = [&path](bool simd) {
+        return [&path, simd]() {
+            CsvReader::Options options;
+            options.useSimd = simd;
+            CsvReader reader(path, options);
+            qint64 fields = 0;
+            while (reader.readRecord()) {
+                fields += reader.fieldCount();
+            }
+            if (fields == 0) {
+                std::printf("No fields read\n");
+            }
+        };
+    };
+
+    std::printf("%-20s %10s\n", "stage", "MB/s");
+    std::printf("%-20s %10.1f\n", "scan, scalar", bestMBps(bytes, scan(false)));
+    if (CsvReader::simdAvailable()) {
+        std::printf("%-20s %10.1f\n", "scan, SSE2", bestMBps(bytes, scan(true)));
+    }
+    std::printf("%-20s %10.1f\n", "import to Contacts", bestMBps(bytes, [&path]() {
+        FileHandler handler;
+        qint64 imported = 0;
+        handler.importFromCsv(path, [&imported](const QList<Contact>& batch) {
+            imported += batch.size();
+            return true;
+        });
+    }));
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Insert and read throughput of Database under the durable and fast
+// performance profiles.
+//
+// Usage: bench_db_profiles [bulk-rows]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include "db/Database.h"
+
+namespace {
+    const int SINGLE_INSERTS = 2000;
+    const int READ_ROUNDS = 20;
+
+    QList<Contact> makeContacts(int count, int offset) {
+        QList<Contact> contacts;
+        contacts.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            contacts.append(Contact(QString("Contact %1").arg(offset + i),
+                                    QString("555-%1").arg(offset + i, 7, 10, QChar('0')),
+                                    QString("contact%1@example.com").arg(offset + i)));
+        }
+        return contacts;
+    }
+
+    double perSecond(qint64 count, qint64 elapsedMs) {
+        return count * 1000.0 / std::max<qint64>(elapsedMs, 1);
+    }
+
+    void run(const char* label, const PerformanceProfile& profile, const QString& path, int bulkRows) {
+        Database database;
+        database.setPerformanceProfile(profile);
+        if (!database.initialize(path)) {
+            std::printf("%-10s failed to open %s\n", label, qPrintable(path));
+            return;
+        }
+
+        // Autocommit inserts pay one sync per row
+        QElapsedTimer timer;
+        timer.start();
+        for (const Contact& contact : makeContacts(SINGLE_INSERTS, 0)) {
+            database.saveContact(contact);
+        }
+        const double singleRate = perSecond(SINGLE_INSERTS, timer.elapsed());
+
+        const BulkWriteResult bulk = database.saveContacts(makeContacts(bulkRows, SINGLE_INSERTS));
+
+        timer.restart();
+        qint64 rowsRead = 0;
+        for (int round = 0; round < READ_ROUNDS; ++round) {
+            rowsRead += database.getAllContacts().size();
+        }
+        const double readRate = perSecond(rowsRead, timer.elapsed());
+
+        timer.restart();
+        for (int round = 0; round < READ_ROUNDS; ++round) {
+            database.searchContacts(QString::number(round * 37));
+        }
+        const double searchRate = perSecond(READ_ROUNDS, timer.elapsed());
+
+        std::printf("%-10s %16.0f %16.0f %16.0f %16.1f\n", label, singleRate, bulk.rowsPerSecond(), readRate, searchRate);
+        database.close();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int bulkRows = argc > 1 ? QString(argv[1]).toInt() : 100000;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::printf("Could not create a temporary directory\n");
+        return 1;
+    }
+
+    std::printf("%-10s %16s %16s %16s %16s\n", "profile", "single ins/s", "bulk ins/s", "rows read/s", "searches/s");
+    run("durable", PerformanceProfile::durable(), dir.filePath("durable.db"), bulkRows);
+    run("fast", PerformanceProfile::fast(), dir.filePath("fast.db"), bulkRows);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Read throughput of Database against the number of reader threads. Each
+// thread gets its own connection; WAL lets them read concurrently.
+//
+// Usage: bench_db_readers [contacts] [reads-per-thread]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "db/Database.h"
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int contactCount = argc > 1 ? QString(argv[1]).toInt() : 100000;
+    const int readsPerThread = argc > 2 ? QString(argv[2]).toInt() : 500;
+    const int maxThreads = std::max(QThread::idealThreadCount(), 1);
+
+    QTemporaryDir dir;
+    Database database;
+    database.setPerformanceProfile(PerformanceProfile::fast());
+    if (!dir.isValid() || !database.initialize(dir.filePath("readers.db"))) {
+        std::printf("Could not create the benchmark database\n");
+        return 1;
+    }
+
+    QList<Contact> contacts;
+    contacts.reserve(contactCount);
+    for (int i = 0; i < contactCount; ++i) {
+        contacts.append(Contact(QString("Contact %1").arg(i, 7, 10, QChar('0')),
+                                QString("555-%1").arg(i, 7, 10, QChar('0'))));
+    }
+    database.saveContacts(contacts);
+
+    std::printf("%-8s %14s %14s\n", "threads", "reads/s", "speedup");
+
+    double baseline = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<QThread*> workers;
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(QThread::create([&database, readsPerThread, contactCount, t]() {
+                // Mix of point-ish searches and keyset pages
+                for (int i = 0; i < readsPerThread; ++i) {
+                    int key = (t * 7919 + i * 104729) % std::max(contactCount, 1);
+                    if (i % 2 == 0) {
+                        database.searchContacts(QString::number(key).rightJustified(7, '0'));
+                    } else {
+                        database.getContactsPage(PageKey{QString("Contact %1").arg(key, 7, 10, QChar('0')), 0}, 50);
+                    }
+                }
+            }));
+            workers.back()->start();
+        }
+
+        for (QThread* worker : workers) {
+            worker->wait();
+            delete worker;
+        }
+
+        double rate = static_cast<double>(threads) * readsPerThread * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+        if (threads == 1) {
+            baseline = rate;
+        }
+        std::printf("%-8d %14.0f %13.2fx\n", threads, rate, rate / std::max(baseline, 1.0));
+    }
+
+    return 0;
+}
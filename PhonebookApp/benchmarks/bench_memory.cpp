@@ -0,0 +1,54 @@
+// Memory footprint of ContactManager for synthetic books of increasing size.
+//
+// Usage: bench_memory [max-contacts]
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <cstdio>
+#include "core/ContactManager.h"
+
+namespace {
+    QList<Contact> makeBook(int count) {
+        QRandomGenerator rng(42);
+        QList<Contact> contacts;
+        contacts.reserve(count);
+
+        for (int i = 0; i < count; ++i) {
+            QString name;
+            for (int c = 0; c < 10; ++c) {
+                name.append(QChar('a' + rng.bounded(26)));
+            }
+            name += QString(" %1").arg(i);
+            QString phone = QString("555-%1").arg(rng.bounded(10000000), 7, 10, QChar('0'));
+            // Roughly a third of real books have no email
+            QString email = rng.bounded(3) == 0 ? QString() : name.left(8) + "@example.com";
+            contacts.append(Contact(name, phone, email));
+        }
+        return contacts;
+    }
+
+    double kib(qint64 bytes) {
+        return bytes / 1024.0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int maxContacts = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+
+    std::printf("%-10s %12s %12s %12s %12s %12s %12s %10s\n",
+                "contacts", "tree KiB", "string KiB", "shared KiB", "index KiB", "cache KiB", "total KiB", "B/contact");
+
+    for (int count = 1000; count <= maxContacts; count *= 10) {
+        ContactManager manager;
+        manager.importContactsBatch(makeBook(count));
+
+        const MemoryStats stats = manager.memoryStats();
+        std::printf("%-10d %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f %10.1f\n",
+                    stats.contacts, kib(stats.treeBytes), kib(stats.stringBytes), kib(stats.sharedStringBytes),
+                    kib(stats.indexBytes), kib(stats.cacheBytes), kib(stats.totalBytes()), stats.bytesPerContact());
+    }
+
+    return 0;
+}
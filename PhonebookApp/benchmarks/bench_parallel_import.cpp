@@ -0,0 +1,142 @@
+// Parallel import scaling: FileHandler::importFromCsv/importFromJson against
+// FileHandler::importParallel with the thread pool capped at 1, 2, 4, ... up
+// to the ideal thread count, on a generated file of the given row count.
+//
+// Usage: bench_parallel_import [rows]
+//        (default 10000000 rows, about 0.5 GB of CSV and 0.8 GB of JSON)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "core/FileHandler.h"
+#include "core/ThreadPool.h"
+
+namespace {
+    // Every tenth name is quoted and holds a comma, a doubled quote and a
+    // line break, so chunk cuts have quote state to resolve
+    bool writeCsv(const QString& path, int rows) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray chunk = "ID,Name,Phone,Email\n";
+        for (int i = 0; i < rows; ++i) {
+            const QByteArray n = QByteArray::number(i);
+            if (i % 10 == 0) {
+                chunk += n + ",\"Contact, \"\"" + n + "\"\"\nsecond line\",555-" + n + ",contact" + n + "@example.com\n";
+            } else {
+                chunk += n + ",Contact " + n + ",555-" + n + ",contact" + n + "@example.com\n";
+            }
+            if (chunk.size() > (1 << 20)) {
+                file.write(chunk);
+                chunk.clear();
+            }
+        }
+        file.write(chunk);
+        return true;
+    }
+
+    // One contact per line, as exportToJson writes them
+    bool writeJson(const QString& path, int rows) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray chunk = "[\n";
+        for (int i = 0; i < rows; ++i) {
+            const QByteArray n = QByteArray::number(i);
+            chunk += "{\"id\":" + n + ",\"name\":\"Contact \\\"" + n + "\\\"\",\"phone\":\"555-" + n
+                   + "\",\"email\":\"contact" + n + "@example.com\",\"address\":\"\",\"notes\":\"\"}";
+            chunk += i + 1 < rows ? ",\n" : "\n";
+            if (chunk.size() > (1 << 20)) {
+                file.write(chunk);
+                chunk.clear();
+            }
+        }
+        chunk += "]\n";
+        file.write(chunk);
+        return true;
+    }
+
+    double bestSeconds(const std::function<qint64()>& run, int rows) {
+        qint64 best = -1;
+        for (int i = 0; i < 3; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            const qint64 imported = run();
+            const qint64 ns = timer.nsecsElapsed();
+            if (imported != rows) {
+                std::printf("Imported %lld of %d rows\n", static_cast<long long>(imported), rows);
+            }
+            best = best < 0 ? ns : std::min(best, ns);
+        }
+        return std::max<qint64>(best, 1) / 1e9;
+    }
+
+    void runFormat(const char* label, const QString& path, FileHandler::FileFormat format, int rows) {
+        const qint64 bytes = QFile(path).size();
+        std::printf("%s: %d rows, %.1f MB\n", label, rows, bytes / 1e6);
+        std::printf("%-14s %10s %10s\n", "mode", "MB/s", "speedup");
+
+        auto countInto = [](qint64& imported) {
+            return [&imported](const QList<Contact>& batch) {
+                imported += batch.size();
+                return true;
+            };
+        };
+
+        const double serial = bestSeconds([&]() {
+            FileHandler handler;
+            qint64 imported = 0;
+            if (format == FileHandler::CSV) {
+                handler.importFromCsv(path, countInto(imported));
+            } else {
+                handler.importFromJson(path, countInto(imported));
+            }
+            return imported;
+        }, rows);
+        std::printf("%-14s %10.1f %10.2f\n", "serial", bytes / 1e6 / serial, 1.0);
+
+        const int ideal = std::max(QThread::idealThreadCount(), 1);
+        for (int threads = 1;; threads = std::min(threads * 2, ideal)) {
+            ThreadPool::instance().setMaxThreadCount(threads);
+            const double parallel = bestSeconds([&]() {
+                FileHandler handler;
+                qint64 imported = 0;
+                handler.importParallel(path, format, countInto(imported));
+                return imported;
+            }, rows);
+            const QByteArray mode = "parallel x" + QByteArray::number(threads);
+            std::printf("%-14s %10.1f %10.2f\n", mode.constData(), bytes / 1e6 / parallel, serial / parallel);
+            if (threads == ideal) {
+                break;
+            }
+        }
+        ThreadPool::instance().setMaxThreadCount(ideal);
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int rows = std::max(argc > 1 ? QString(argv[1]).toInt() : 10000000, 1);
+
+    QTemporaryDir dir;
+    const QString csvPath = dir.filePath("contacts.csv");
+    const QString jsonPath = dir.filePath("contacts.json");
+    if (!dir.isValid() || !writeCsv(csvPath, rows) || !writeJson(jsonPath, rows)) {
+        std::printf("Could not write the benchmark files\n");
+        return 1;
+    }
+
+    runFormat("CSV", csvPath, FileHandler::CSV, rows);
+    runFormat("JSON", jsonPath, FileHandler::JSON, rows);
+
+    return 0;
+}
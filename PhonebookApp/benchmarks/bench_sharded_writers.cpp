@@ -0,0 +1,99 @@
+// Multi-writer insert throughput of ShardedContactManager with one shard (a
+// single lock) against its default shard count, so only the sharding
+// differs. ContactManager is listed for reference; it also keeps phone and
+// email views and change tracking up to date on every insert, so it is
+// slower at any writer count for reasons unrelated to locking.
+//
+// Usage: bench_sharded_writers [contacts-per-writer]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "core/ContactManager.h"
+#include "core/ShardedContactManager.h"
+
+namespace {
+    // Random names keep the unbalanced BST close to logarithmic depth
+    QList<Contact> makeContacts(int writer, int count) {
+        QRandomGenerator rng(static_cast<quint32>(writer + 1));
+        QList<Contact> contacts;
+        contacts.reserve(count);
+
+        for (int i = 0; i < count; ++i) {
+            QString name;
+            for (int c = 0; c < 12; ++c) {
+                name.append(QChar('a' + rng.bounded(26)));
+            }
+            name += QString(" w%1").arg(writer);
+            QString phone = QString("555-%1").arg(rng.bounded(10000000), 7, 10, QChar('0'));
+            contacts.append(Contact(name, phone, name.left(8) + "@example.com"));
+        }
+        return contacts;
+    }
+
+    double run(int writers, const std::vector<QList<Contact>>& input, const std::function<void(const Contact&)>& add) {
+        std::vector<QThread*> threads;
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int w = 0; w < writers; ++w) {
+            threads.push_back(QThread::create([&input, &add, w]() {
+                for (const Contact& contact : input[w]) {
+                    add(contact);
+                }
+            }));
+            threads.back()->start();
+        }
+
+        for (QThread* thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+
+        qint64 total = 0;
+        for (int w = 0; w < writers; ++w) {
+            total += input[w].size();
+        }
+        return total * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int perWriter = argc > 1 ? QString(argv[1]).toInt() : 50000;
+    const int maxWriters = 8;
+
+    std::vector<QList<Contact>> input;
+    for (int w = 0; w < maxWriters; ++w) {
+        input.push_back(makeContacts(w, perWriter));
+    }
+
+    std::printf("%-8s %18s %18s %18s\n", "writers", "1 shard op/s", "sharded op/s", "ContactManager");
+
+    for (int writers = 1; writers <= maxWriters; writers *= 2) {
+        ShardedContactManager single(1);
+        double singleRate = run(writers, input, [&single](const Contact& contact) {
+            single.addContact(contact);
+        });
+
+        ShardedContactManager sharded;
+        double shardedRate = run(writers, input, [&sharded](const Contact& contact) {
+            sharded.addContact(contact);
+        });
+
+        ContactManager reference;
+        double referenceRate = run(writers, input, [&reference](const Contact& contact) {
+            reference.addContact(contact);
+        });
+
+        std::printf("%-8d %18.0f %18.0f %18.0f\n", writers, singleRate, shardedRate, referenceRate);
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Single-row get, update and delete latency with Database's prepared
+// statement cache, against the previous prepare-on-every-call code run on a
+// second connection to the same file.
+//
+// Usage: bench_statement_cache [operations]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "db/Database.h"
+
+namespace {
+    double microsPerOp(int operations, const std::function<void(int)>& op) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < operations; ++i) {
+            op(i);
+        }
+        return timer.nsecsElapsed() / 1000.0 / std::max(operations, 1);
+    }
+
+    void print(const char* label, double uncachedUs, double cachedUs) {
+        std::printf("%-8s %14.2f %14.2f %11.2fx\n", label, uncachedUs, cachedUs, uncachedUs / std::max(cachedUs, 0.001));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int operations = std::max(argc > 1 ? QString(argv[1]).toInt() : 20000, 1);
+    const PerformanceProfile profile = PerformanceProfile::fast();  // Keep fsync out of the numbers
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("statements.db");
+    Database database;
+    database.setPerformanceProfile(profile);
+    if (!dir.isValid() || !database.initialize(path)) {
+        std::printf("Could not create the benchmark database\n");
+        return 1;
+    }
+
+    // Twice the rows: each side deletes its own half
+    QList<Contact> seed;
+    for (int i = 0; i < 2 * operations; ++i) {
+        seed.append(Contact(QString("Contact %1").arg(i), QString("555-%1").arg(i, 7, 10, QChar('0'))));
+    }
+    database.saveContacts(seed);
+    const QList<Contact> stored = database.getAllContacts();
+
+    {
+        QSqlDatabase baseline = QSqlDatabase::addDatabase("QSQLITE", "bench-uncached");
+        baseline.setDatabaseName(path);
+        if (!baseline.open()) {
+            std::printf("Could not open the baseline connection\n");
+            return 1;
+        }
+        QSqlQuery pragmas(baseline);
+        for (const QString& pragma : profile.connectionPragmas()) {
+            pragmas.exec(pragma);
+        }
+
+        auto uncachedGet = [&](int i) {
+            QSqlQuery query(baseline);
+            query.prepare("SELECT id, name, phone, email FROM contacts WHERE id = ?");
+            query.addBindValue(stored[i % stored.size()].getId());
+            query.exec();
+            query.next();
+        };
+        auto uncachedUpdate = [&](int i) {
+            const Contact& contact = stored[i % stored.size()];
+            QSqlQuery query(baseline);
+            query.prepare("UPDATE contacts SET name = ?, phone = ?, email = ?, "
+                          "updated_at = CURRENT_TIMESTAMP WHERE id = ?");
+            query.addBindValue(contact.getName());
+            query.addBindValue(contact.getPhone());
+            query.addBindValue(QString("u%1@example.com").arg(i));
+            query.addBindValue(contact.getId());
+            query.exec();
+        };
+        auto uncachedDelete = [&](int i) {
+            QSqlQuery query(baseline);
+            query.prepare("DELETE FROM contacts WHERE id = ?");
+            query.addBindValue(stored[i].getId());
+            query.exec();
+        };
+
+        auto cachedGet = [&](int i) {
+            database.getContact(stored[i % stored.size()].getId());
+        };
+        auto cachedUpdate = [&](int i) {
+            Contact contact = stored[i % stored.size()];
+            contact.setEmail(QString("c%1@example.com").arg(i));
+            database.updateContact(contact);
+        };
+        auto cachedDelete = [&](int i) {
+            database.deleteContact(stored[operations + i].getId());
+        };
+
+        std::printf("%-8s %14s %14s %12s\n", "op", "uncached us", "cached us", "speedup");
+        print("get", microsPerOp(operations, uncachedGet), microsPerOp(operations, cachedGet));
+        print("update", microsPerOp(operations, uncachedUpdate), microsPerOp(operations, cachedUpdate));
+        print("delete", microsPerOp(operations, uncachedDelete), microsPerOp(operations, cachedDelete));
+
+        baseline.close();
+    }
+    QSqlDatabase::removeDatabase("bench-uncached");
+
+    return 0;
+}
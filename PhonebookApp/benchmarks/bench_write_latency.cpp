@@ -0,0 +1,105 @@
+// Calling-thread latency under a write storm: synchronous Database writes
+// against the DatabaseWriter write-behind queue.
+//
+// Usage: bench_write_latency [writes] [distinct-ids]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "db/Database.h"
+#include "db/DatabaseWriter.h"
+
+namespace {
+    struct Latency {
+        double p50Us = 0;
+        double p99Us = 0;
+        double maxUs = 0;
+        qint64 totalMs = 0;
+    };
+
+    Latency measure(int writes, const std::function<void(int)>& write, const std::function<void()>& finish) {
+        std::vector<qint64> samples;
+        samples.reserve(writes);
+
+        QElapsedTimer total;
+        total.start();
+        QElapsedTimer call;
+        for (int i = 0; i < writes; ++i) {
+            call.start();
+            write(i);
+            samples.push_back(call.nsecsElapsed());
+        }
+        finish();
+
+        std::sort(samples.begin(), samples.end());
+        Latency latency;
+        latency.p50Us = samples[samples.size() / 2] / 1000.0;
+        latency.p99Us = samples[samples.size() * 99 / 100] / 1000.0;
+        latency.maxUs = samples.back() / 1000.0;
+        latency.totalMs = total.elapsed();
+        return latency;
+    }
+
+    void print(const char* label, const Latency& latency) {
+        std::printf("%-14s %12.1f %12.1f %12.1f %12lld\n", label, latency.p50Us, latency.p99Us,
+                    latency.maxUs, static_cast<long long>(latency.totalMs));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const int writes = std::max(argc > 1 ? QString(argv[1]).toInt() : 20000, 1);
+    const int distinctIds = std::max(argc > 2 ? QString(argv[2]).toInt() : 1000, 1);
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("latency.db");
+    Database database;
+    if (!dir.isValid() || !database.initialize(path)) {
+        std::printf("Could not create the benchmark database\n");
+        return 1;
+    }
+
+    QList<Contact> seed;
+    for (int i = 0; i < distinctIds; ++i) {
+        seed.append(Contact(QString("Contact %1").arg(i), QString("555-%1").arg(i, 7, 10, QChar('0'))));
+    }
+    database.saveContacts(seed);
+    const QList<Contact> stored = database.getAllContacts();
+
+    auto updated = [&stored](int i) {
+        Contact contact = stored[i % stored.size()];
+        contact.setEmail(QString("write%1@example.com").arg(i));
+        return contact;
+    };
+
+    std::printf("%-14s %12s %12s %12s %12s\n", "mode", "p50 us", "p99 us", "max us", "total ms");
+
+    print("synchronous", measure(writes, [&](int i) {
+        database.updateContact(updated(i));
+    }, []() {}));
+
+    DatabaseWriter writer;
+    if (!writer.start(path)) {
+        std::printf("Could not start the writer\n");
+        return 1;
+    }
+
+    print("write-behind", measure(writes, [&](int i) {
+        writer.updateContact(updated(i));
+    }, [&writer]() {
+        writer.flush();
+    }));
+
+    const DatabaseWriter::Stats stats = writer.stats();
+    std::printf("\nwrite-behind: %llu batches, %llu of %llu updates coalesced\n",
+                static_cast<unsigned long long>(stats.batches),
+                static_cast<unsigned long long>(stats.coalesced),
+                static_cast<unsigned long long>(stats.enqueued));
+
+    return 0;
+}
@@ -64,10 +64,12 @@ private:
     };
     
     std::unique_ptr<Node> root;
+    size_t count = 0;
     
     void insertHelper(std::unique_ptr<Node>& node, const T& value) {
         if (!node) {
             node = std::make_unique<Node>(value);
+            count++;
             return;
         }
         
@@ -102,8 +104,22 @@ public:
     bool isEmpty() const {
         return root == nullptr;
     }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    size_t nodeBytes() const {
+        return count * sizeof(Node);
+    }
 };
 
+// Heap bytes owned by a string; short strings live inside the object
+size_t stringHeapBytes(const std::string& text) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
 // Demo application
 int main() {
     std::cout << "=== Modern Phonebook Console Demo ===" << std::endl;
@@ -165,6 +181,24 @@ int main() {
     std::cout << "Contacts with email: " << withEmail << std::endl;
     std::cout << "Contacts without email: " << (contacts.size() - withEmail) << std::endl;
     
+    // Memory footprint
+    std::cout << "\nMemory footprint:" << std::endl;
+    std::cout << "----------------" << std::endl;
+    
+    size_t stringBytes = 0;
+    for (const auto& contact : contacts) {
+        stringBytes += stringHeapBytes(contact.getName()) +
+                       stringHeapBytes(contact.getPhone()) +
+                       stringHeapBytes(contact.getEmail());
+    }
+    size_t totalBytes = contactTree.nodeBytes() + stringBytes;
+    
+    std::cout << "Tree nodes: " << contactTree.size() << " x " << (contactTree.nodeBytes() / std::max<size_t>(contactTree.size(), 1))
+              << " bytes = " << contactTree.nodeBytes() << " bytes" << std::endl;
+    std::cout << "String payloads (beyond inline storage): " << stringBytes << " bytes" << std::endl;
+    std::cout << "Total: " << totalBytes << " bytes, "
+              << (totalBytes / std::max<size_t>(contactTree.size(), 1)) << " bytes per contact" << std::endl;
+    
     // Demonstrate contact validation
     std::cout << "\nContact validation demonstration:" << std::endl;
     std::cout << "--------------------------------" << std::endl;
@@ -0,0 +1,14 @@
+-- Covering indexes: name order matches Contact::operator< (ASCII case
+-- folding) and both carry every selected column, so ordered scans and
+-- phone lookups never touch the table. They replace the plain indexes of
+-- older databases.
+DROP INDEX IF EXISTS idx_contacts_name;
+DROP INDEX IF EXISTS idx_contacts_phone;
+
+CREATE INDEX IF NOT EXISTS idx_contacts_name_nocase
+    ON contacts (name COLLATE NOCASE, id, phone, email);
+CREATE INDEX IF NOT EXISTS idx_contacts_phone_covering
+    ON contacts (phone, name COLLATE NOCASE, email);
+
+-- Incremental reloads by ContactSync
+CREATE INDEX IF NOT EXISTS idx_contacts_updated_at ON contacts (updated_at);
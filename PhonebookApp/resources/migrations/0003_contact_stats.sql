@@ -0,0 +1,56 @@
+-- Counters kept by triggers so counts never scan contacts. Keys:
+--   'total'
+--   'letter:<first letter of name, uppercased>'
+--   'domain:<email domain, lowercased>'
+-- upper() and lower() only fold ASCII, matching what SQLite can index.
+CREATE TABLE IF NOT EXISTS contact_stats (
+    key TEXT PRIMARY KEY,
+    count INTEGER NOT NULL
+) WITHOUT ROWID;
+
+CREATE TRIGGER IF NOT EXISTS contact_stats_insert AFTER INSERT ON contacts BEGIN
+    INSERT INTO contact_stats (key, count)
+    SELECT k, 1 FROM (
+        SELECT 'total' AS k
+        UNION ALL SELECT 'letter:' || upper(substr(new.name, 1, 1))
+        UNION ALL SELECT CASE WHEN instr(new.email, '@') > 0
+                              THEN 'domain:' || lower(substr(new.email, instr(new.email, '@') + 1)) END
+    ) WHERE k IS NOT NULL
+    ON CONFLICT(key) DO UPDATE SET count = count + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS contact_stats_delete AFTER DELETE ON contacts BEGIN
+    UPDATE contact_stats SET count = count - 1
+    WHERE key IN ('total',
+                  'letter:' || upper(substr(old.name, 1, 1)),
+                  CASE WHEN instr(old.email, '@') > 0
+                       THEN 'domain:' || lower(substr(old.email, instr(old.email, '@') + 1)) END);
+    DELETE FROM contact_stats WHERE count <= 0 AND key <> 'total';
+END;
+
+CREATE TRIGGER IF NOT EXISTS contact_stats_update AFTER UPDATE OF name, email ON contacts BEGIN
+    UPDATE contact_stats SET count = count - 1
+    WHERE key IN ('letter:' || upper(substr(old.name, 1, 1)),
+                  CASE WHEN instr(old.email, '@') > 0
+                       THEN 'domain:' || lower(substr(old.email, instr(old.email, '@') + 1)) END);
+    DELETE FROM contact_stats WHERE count <= 0 AND key <> 'total';
+    INSERT INTO contact_stats (key, count)
+    SELECT k, 1 FROM (
+        SELECT 'letter:' || upper(substr(new.name, 1, 1)) AS k
+        UNION ALL SELECT CASE WHEN instr(new.email, '@') > 0
+                              THEN 'domain:' || lower(substr(new.email, instr(new.email, '@') + 1)) END
+    ) WHERE k IS NOT NULL
+    ON CONFLICT(key) DO UPDATE SET count = count + 1;
+END;
+
+-- Seed from whatever the table already holds
+DELETE FROM contact_stats;
+INSERT INTO contact_stats (key, count) SELECT 'total', COUNT(*) FROM contacts;
+INSERT INTO contact_stats (key, count)
+    SELECT 'letter:' || upper(substr(name, 1, 1)), COUNT(*) FROM contacts GROUP BY 1;
+INSERT INTO contact_stats (key, count)
+    SELECT k, COUNT(*) FROM (
+        SELECT CASE WHEN instr(email, '@') > 0
+                    THEN 'domain:' || lower(substr(email, instr(email, '@') + 1)) END AS k
+        FROM contacts
+    ) WHERE k IS NOT NULL GROUP BY k;
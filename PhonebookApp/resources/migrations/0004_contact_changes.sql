@@ -0,0 +1,32 @@
+-- Change-data-capture log: one row per insert, update or delete of a
+-- contact, in commit order. Consumers remember the last seq they applied
+-- and ask for everything after it. The payload is the row as JSON (the
+-- old row for deletes).
+CREATE TABLE IF NOT EXISTS contact_changes (
+    seq INTEGER PRIMARY KEY AUTOINCREMENT,
+    op TEXT NOT NULL CHECK (op IN ('insert', 'update', 'delete')),
+    contact_id INTEGER NOT NULL,
+    payload TEXT NOT NULL,
+    changed_at DATETIME DEFAULT CURRENT_TIMESTAMP
+);
+
+-- Finds superseded entries per contact during compaction
+CREATE INDEX IF NOT EXISTS idx_contact_changes_contact ON contact_changes (contact_id, seq);
+
+CREATE TRIGGER IF NOT EXISTS contact_changes_insert AFTER INSERT ON contacts BEGIN
+    INSERT INTO contact_changes (op, contact_id, payload)
+    VALUES ('insert', new.id,
+            json_object('id', new.id, 'name', new.name, 'phone', new.phone, 'email', new.email));
+END;
+
+CREATE TRIGGER IF NOT EXISTS contact_changes_update AFTER UPDATE OF name, phone, email ON contacts BEGIN
+    INSERT INTO contact_changes (op, contact_id, payload)
+    VALUES ('update', new.id,
+            json_object('id', new.id, 'name', new.name, 'phone', new.phone, 'email', new.email));
+END;
+
+CREATE TRIGGER IF NOT EXISTS contact_changes_delete AFTER DELETE ON contacts BEGIN
+    INSERT INTO contact_changes (op, contact_id, payload)
+    VALUES ('delete', old.id,
+            json_object('id', old.id, 'name', old.name, 'phone', old.phone, 'email', old.email));
+END;
@@ -3,88 +3,124 @@
 
 #include "Contact.h"
 #include <QList>
+#include <functional>
 #include <memory>
 
-template<typename T>
+// Binary search tree ordered by Compare (operator< by default). Nodes track
+// subtree sizes, so positional lookups take O(height).
+template<typename T, typename Compare = std::less<T>>
 class BST {
 private:
     struct Node {
         T data;
         std::unique_ptr<Node> left;
         std::unique_ptr<Node> right;
+        size_t count;  // Nodes in this subtree, for positional lookups
         
-        Node(const T& value) : data(value), left(nullptr), right(nullptr) {}
+        Node(const T& value) : data(value), left(nullptr), right(nullptr), count(1) {}
     };
     
     std::unique_ptr<Node> root;
+    Compare compare;
     
-    void insertHelper(std::unique_ptr<Node>& node, const T& value);
+    bool insertHelper(std::unique_ptr<Node>& node, const T& value);
     bool removeHelper(std::unique_ptr<Node>& node, const T& value);
     Node* findHelper(Node* node, const T& value) const;
+    Node* findEquivalentHelper(const T& value) const;
     void inorderHelper(Node* node, QList<T>& result) const;
+    void rangeHelper(Node* node, size_t& skip, size_t limit, QList<T>& result) const;
+    bool forEachHelper(Node* node, const std::function<bool(const T&)>& visit) const;
     void clearHelper(std::unique_ptr<Node>& node);
     
 public:
     BST();
     ~BST() = default;
     
-    void insert(const T& value);
+    bool insert(const T& value);
     bool remove(const T& value);
     bool contains(const T& value) const;
     T* find(const T& value);
     const T* find(const T& value) const;
+    // Element that orders equal to value under Compare (the same match
+    // remove() uses), whether or not it is operator== to value
+    T* findEquivalent(const T& value);
+    const T* findEquivalent(const T& value) const;
+    
+    // Positional access in sorted order
+    int indexOf(const T& value) const;
+    size_t rank(const T& value) const;
+    const T* at(size_t index) const;
     
     QList<T> inorderTraversal() const;
+    QList<T> range(size_t offset, size_t limit) const;
     QList<T> search(const QString& query) const;
     
+    // In-order visit without copying; stops early when visit returns false
+    bool forEach(const std::function<bool(const T&)>& visit) const;
+    
     void clear();
     bool isEmpty() const;
     size_t size() const;
+    size_t nodeBytes() const { return size() * sizeof(Node); }
     
 private:
-    size_t sizeHelper(Node* node) const;
+    static size_t countOf(const Node* node) { return node ? node->count : 0; }
 };
 
 // Template implementation must be in header file
-template<typename T>
-BST<T>::BST() : root(nullptr) {
+template<typename T, typename Compare>
+BST<T, Compare>::BST() : root(nullptr) {
 }
 
-template<typename T>
-void BST<T>::insert(const T& value) {
-    insertHelper(root, value);
+template<typename T, typename Compare>
+bool BST<T, Compare>::insert(const T& value) {
+    return insertHelper(root, value);
 }
 
-template<typename T>
-void BST<T>::insertHelper(std::unique_ptr<Node>& node, const T& value) {
+template<typename T, typename Compare>
+bool BST<T, Compare>::insertHelper(std::unique_ptr<Node>& node, const T& value) {
     if (!node) {
         node = std::make_unique<Node>(value);
-        return;
+        return true;
     }
     
-    if (value < node->data) {
-        insertHelper(node->left, value);
-    } else if (value > node->data) {
-        insertHelper(node->right, value);
+    bool inserted = false;
+    if (compare(value, node->data)) {
+        inserted = insertHelper(node->left, value);
+    } else if (compare(node->data, value)) {
+        inserted = insertHelper(node->right, value);
     }
     // If equal, don't insert (no duplicates)
+    
+    if (inserted) {
+        node->count++;
+    }
+    return inserted;
 }
 
-template<typename T>
-bool BST<T>::remove(const T& value) {
+template<typename T, typename Compare>
+bool BST<T, Compare>::remove(const T& value) {
     return removeHelper(root, value);
 }
 
-template<typename T>
-bool BST<T>::removeHelper(std::unique_ptr<Node>& node, const T& value) {
+template<typename T, typename Compare>
+bool BST<T, Compare>::removeHelper(std::unique_ptr<Node>& node, const T& value) {
     if (!node) {
         return false;
     }
     
-    if (value < node->data) {
-        return removeHelper(node->left, value);
-    } else if (value > node->data) {
-        return removeHelper(node->right, value);
+    if (compare(value, node->data)) {
+        bool removed = removeHelper(node->left, value);
+        if (removed) {
+            node->count--;
+        }
+        return removed;
+    } else if (compare(node->data, value)) {
+        bool removed = removeHelper(node->right, value);
+        if (removed) {
+            node->count--;
+        }
+        return removed;
     } else {
         // Found the node to remove
         if (!node->left) {
@@ -99,52 +135,127 @@ bool BST<T>::removeHelper(std::unique_ptr<Node>& node, const T& value) {
             }
             node->data = successor->data;
             removeHelper(node->right, successor->data);
+            node->count--;
         }
         return true;
     }
 }
 
-template<typename T>
-bool BST<T>::contains(const T& value) const {
+template<typename T, typename Compare>
+bool BST<T, Compare>::contains(const T& value) const {
     return findHelper(root.get(), value) != nullptr;
 }
 
-template<typename T>
-T* BST<T>::find(const T& value) {
+template<typename T, typename Compare>
+T* BST<T, Compare>::find(const T& value) {
     Node* node = findHelper(root.get(), value);
     return node ? &(node->data) : nullptr;
 }
 
-template<typename T>
-const T* BST<T>::find(const T& value) const {
+template<typename T, typename Compare>
+const T* BST<T, Compare>::find(const T& value) const {
     Node* node = findHelper(root.get(), value);
     return node ? &(node->data) : nullptr;
 }
 
-template<typename T>
-typename BST<T>::Node* BST<T>::findHelper(Node* node, const T& value) const {
+template<typename T, typename Compare>
+typename BST<T, Compare>::Node* BST<T, Compare>::findHelper(Node* node, const T& value) const {
     if (!node) {
         return nullptr;
     }
     
     if (value == node->data) {
         return node;
-    } else if (value < node->data) {
+    } else if (compare(value, node->data)) {
         return findHelper(node->left.get(), value);
     } else {
         return findHelper(node->right.get(), value);
     }
 }
 
-template<typename T>
-QList<T> BST<T>::inorderTraversal() const {
+template<typename T, typename Compare>
+T* BST<T, Compare>::findEquivalent(const T& value) {
+    Node* node = findEquivalentHelper(value);
+    return node ? &(node->data) : nullptr;
+}
+
+template<typename T, typename Compare>
+const T* BST<T, Compare>::findEquivalent(const T& value) const {
+    Node* node = findEquivalentHelper(value);
+    return node ? &(node->data) : nullptr;
+}
+
+template<typename T, typename Compare>
+typename BST<T, Compare>::Node* BST<T, Compare>::findEquivalentHelper(const T& value) const {
+    Node* node = root.get();
+    
+    while (node) {
+        if (compare(value, node->data)) {
+            node = node->left.get();
+        } else if (compare(node->data, value)) {
+            node = node->right.get();
+        } else {
+            return node;
+        }
+    }
+    
+    return nullptr;
+}
+
+template<typename T, typename Compare>
+int BST<T, Compare>::indexOf(const T& value) const {
+    return contains(value) ? static_cast<int>(rank(value)) : -1;
+}
+
+template<typename T, typename Compare>
+size_t BST<T, Compare>::rank(const T& value) const {
+    // Number of elements ordered before value
+    size_t result = 0;
+    Node* node = root.get();
+    
+    while (node) {
+        if (compare(value, node->data)) {
+            node = node->left.get();
+        } else if (compare(node->data, value)) {
+            result += countOf(node->left.get()) + 1;
+            node = node->right.get();
+        } else {
+            result += countOf(node->left.get());
+            break;
+        }
+    }
+    
+    return result;
+}
+
+template<typename T, typename Compare>
+const T* BST<T, Compare>::at(size_t index) const {
+    Node* node = root.get();
+    
+    while (node) {
+        size_t leftCount = countOf(node->left.get());
+        if (index < leftCount) {
+            node = node->left.get();
+        } else if (index == leftCount) {
+            return &(node->data);
+        } else {
+            index -= leftCount + 1;
+            node = node->right.get();
+        }
+    }
+    
+    return nullptr;
+}
+
+template<typename T, typename Compare>
+QList<T> BST<T, Compare>::inorderTraversal() const {
     QList<T> result;
     inorderHelper(root.get(), result);
     return result;
 }
 
-template<typename T>
-void BST<T>::inorderHelper(Node* node, QList<T>& result) const {
+template<typename T, typename Compare>
+void BST<T, Compare>::inorderHelper(Node* node, QList<T>& result) const {
     if (node) {
         inorderHelper(node->left.get(), result);
         result.append(node->data);
@@ -152,8 +263,57 @@ void BST<T>::inorderHelper(Node* node, QList<T>& result) const {
     }
 }
 
-template<typename T>
-QList<T> BST<T>::search(const QString& query) const {
+template<typename T, typename Compare>
+bool BST<T, Compare>::forEach(const std::function<bool(const T&)>& visit) const {
+    return forEachHelper(root.get(), visit);
+}
+
+template<typename T, typename Compare>
+bool BST<T, Compare>::forEachHelper(Node* node, const std::function<bool(const T&)>& visit) const {
+    if (!node) {
+        return true;
+    }
+    return forEachHelper(node->left.get(), visit) &&
+           visit(node->data) &&
+           forEachHelper(node->right.get(), visit);
+}
+
+template<typename T, typename Compare>
+QList<T> BST<T, Compare>::range(size_t offset, size_t limit) const {
+    QList<T> result;
+    rangeHelper(root.get(), offset, limit, result);
+    return result;
+}
+
+template<typename T, typename Compare>
+void BST<T, Compare>::rangeHelper(Node* node, size_t& skip, size_t limit, QList<T>& result) const {
+    if (!node || static_cast<size_t>(result.size()) >= limit) {
+        return;
+    }
+    
+    // Whole subtrees before the offset are skipped using their sizes
+    size_t leftCount = countOf(node->left.get());
+    if (skip >= leftCount) {
+        skip -= leftCount;
+    } else {
+        rangeHelper(node->left.get(), skip, limit, result);
+    }
+    
+    if (static_cast<size_t>(result.size()) >= limit) {
+        return;
+    }
+    
+    if (skip > 0) {
+        skip--;
+    } else {
+        result.append(node->data);
+    }
+    
+    rangeHelper(node->right.get(), skip, limit, result);
+}
+
+template<typename T, typename Compare>
+QList<T> BST<T, Compare>::search(const QString& query) const {
     QList<T> results;
     QList<T> allItems = inorderTraversal();
     
@@ -171,13 +331,13 @@ QList<T> BST<T>::search(const QString& query) const {
     return results;
 }
 
-template<typename T>
-void BST<T>::clear() {
+template<typename T, typename Compare>
+void BST<T, Compare>::clear() {
     clearHelper(root);
 }
 
-template<typename T>
-void BST<T>::clearHelper(std::unique_ptr<Node>& node) {
+template<typename T, typename Compare>
+void BST<T, Compare>::clearHelper(std::unique_ptr<Node>& node) {
     if (node) {
         clearHelper(node->left);
         clearHelper(node->right);
@@ -185,22 +345,14 @@ void BST<T>::clearHelper(std::unique_ptr<Node>& node) {
     }
 }
 
-template<typename T>
-bool BST<T>::isEmpty() const {
+template<typename T, typename Compare>
+bool BST<T, Compare>::isEmpty() const {
     return root == nullptr;
 }
 
-template<typename T>
-size_t BST<T>::size() const {
-    return sizeHelper(root.get());
-}
-
-template<typename T>
-size_t BST<T>::sizeHelper(Node* node) const {
-    if (!node) {
-        return 0;
-    }
-    return 1 + sizeHelper(node->left.get()) + sizeHelper(node->right.get());
+template<typename T, typename Compare>
+size_t BST<T, Compare>::size() const {
+    return countOf(root.get());
 }
 
 #endif // BST_H
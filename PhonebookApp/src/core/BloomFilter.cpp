@@ -0,0 +1,73 @@
+#include "BloomFilter.h"
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+
+BloomFilter::BloomFilter(qsizetype expectedKeys, double falsePositiveRate) {
+    const double n = static_cast<double>(std::max<qsizetype>(expectedKeys, 1));
+    const double p = std::clamp(falsePositiveRate, 1e-9, 0.5);
+    const double ln2 = std::log(2.0);
+
+    // Optimal size m = -n ln p / (ln 2)^2 and probe count k = (m / n) ln 2
+    double bits = std::ceil(-n * std::log(p) / (ln2 * ln2));
+    m_bits = std::max<quint64>(64, static_cast<quint64>(bits));
+    m_hashes = std::clamp(static_cast<int>(std::round(m_bits / n * ln2)), 1, 16);
+    m_words.assign((m_bits + 63) / 64, 0);
+}
+
+void BloomFilter::add(const QString& key) {
+    const Probe probe = probeFor(key);
+    for (int i = 0; i < m_hashes; ++i) {
+        const quint64 bit = bitFor(probe, i);
+        m_words[bit / 64] |= quint64(1) << (bit % 64);
+    }
+}
+
+bool BloomFilter::mightContain(const QString& key) const {
+    const Probe probe = probeFor(key);
+    for (int i = 0; i < m_hashes; ++i) {
+        const quint64 bit = bitFor(probe, i);
+        if (!(m_words[bit / 64] & (quint64(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::testAndAdd(const QString& key) {
+    const Probe probe = probeFor(key);
+    bool present = true;
+    for (int i = 0; i < m_hashes; ++i) {
+        const quint64 bit = bitFor(probe, i);
+        const quint64 mask = quint64(1) << (bit % 64);
+        if (!(m_words[bit / 64] & mask)) {
+            present = false;
+            m_words[bit / 64] |= mask;
+        }
+    }
+    return present;
+}
+
+void BloomFilter::clear() {
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+qsizetype BloomFilter::bitCount() const {
+    return static_cast<qsizetype>(m_bits);
+}
+
+int BloomFilter::hashCount() const {
+    return m_hashes;
+}
+
+BloomFilter::Probe BloomFilter::probeFor(const QString& key) const {
+    // Two independent seeds; h2 is forced odd so the probe sequence never stalls
+    Probe probe;
+    probe.h1 = qHash(key, 0x5bd1e995u);
+    probe.h2 = qHash(key, 0x9e3779b9u) | 1;
+    return probe;
+}
+
+quint64 BloomFilter::bitFor(const Probe& probe, int i) const {
+    return (probe.h1 + static_cast<quint64>(i) * probe.h2) % m_bits;
+}
@@ -0,0 +1,39 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+// Fixed-size Bloom filter over string keys. Sized from the expected number of
+// keys and the target false-positive rate; probes use double hashing, so each
+// key costs two string hashes regardless of the number of probes.
+class BloomFilter {
+public:
+    explicit BloomFilter(qsizetype expectedKeys, double falsePositiveRate = 0.01);
+
+    void add(const QString& key);
+    bool mightContain(const QString& key) const;
+
+    // Adds the key and reports whether it may have been present already
+    bool testAndAdd(const QString& key);
+
+    void clear();
+    qsizetype bitCount() const;
+    int hashCount() const;
+
+private:
+    struct Probe {
+        quint64 h1;
+        quint64 h2;
+    };
+
+    Probe probeFor(const QString& key) const;
+    quint64 bitFor(const Probe& probe, int i) const;
+
+    std::vector<quint64> m_words;
+    quint64 m_bits;
+    int m_hashes;
+};
+
+#endif // BLOOMFILTER_H
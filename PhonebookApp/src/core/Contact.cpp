@@ -1,13 +1,30 @@
 #include "Contact.h"
 #include <QRegularExpression>
 
-int Contact::s_nextId = 1;
+// Contacts are built on pool threads during parallel imports
+std::atomic<int> Contact::s_nextId{1};
 
-Contact::Contact() : m_id(s_nextId++), m_name(""), m_phone(""), m_email("") {
+Contact::Contact() : m_id(allocateId()), m_name(""), m_phone(""), m_email("") {
 }
 
 Contact::Contact(const QString& name, const QString& phone, const QString& email)
-    : m_id(s_nextId++), m_name(name.trimmed()), m_phone(phone.trimmed()), m_email(email.trimmed()) {
+    : m_id(allocateId()), m_name(name.trimmed()), m_phone(phone.trimmed()), m_email(email.trimmed()) {
+}
+
+void Contact::setId(int id) {
+    m_id = id;
+    // Ids loaded from storage must never be handed out again
+    reserveId(id);
+}
+
+int Contact::allocateId() {
+    return s_nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Contact::reserveId(int id) {
+    int next = s_nextId.load(std::memory_order_relaxed);
+    while (id >= next && !s_nextId.compare_exchange_weak(next, id + 1, std::memory_order_relaxed)) {
+    }
 }
 
 bool Contact::operator<(const Contact& other) const {
@@ -29,26 +46,41 @@ QDataStream& operator<<(QDataStream& stream, const Contact& contact) {
 
 QDataStream& operator>>(QDataStream& stream, Contact& contact) {
     stream >> contact.m_id >> contact.m_name >> contact.m_phone >> contact.m_email;
-    if (contact.m_id >= Contact::s_nextId) {
-        Contact::s_nextId = contact.m_id + 1;
-    }
+    Contact::reserveId(contact.m_id);
     return stream;
 }
 
+bool ContactPhoneOrder::operator()(const Contact& a, const Contact& b) const {
+    int order = QString::compare(a.getPhone(), b.getPhone());
+    if (order != 0) {
+        return order < 0;
+    }
+    return a < b;
+}
+
+bool ContactEmailOrder::operator()(const Contact& a, const Contact& b) const {
+    int order = QString::compare(a.getEmail(), b.getEmail(), Qt::CaseInsensitive);
+    if (order != 0) {
+        return order < 0;
+    }
+    return a < b;
+}
+
 bool Contact::isValid() const {
     if (m_name.isEmpty() || m_phone.isEmpty()) {
         return false;
     }
     
     // Basic phone number validation (digits, spaces, hyphens, parentheses, plus sign)
-    QRegularExpression phoneRegex("^[\\d\\s\\-\\(\\)\\+]+$");
+    // Patterns are compiled once and shared; matching is thread-safe
+    static const QRegularExpression phoneRegex("^[\\d\\s\\-\\(\\)\\+]+$");
     if (!phoneRegex.match(m_phone).hasMatch()) {
         return false;
     }
     
     // Basic email validation if provided
     if (!m_email.isEmpty()) {
-        QRegularExpression emailRegex("^[\\w\\._%+-]+@[\\w\\.-]+\\.[A-Za-z]{2,}$");
+        static const QRegularExpression emailRegex("^[\\w\\._%+-]+@[\\w\\.-]+\\.[A-Za-z]{2,}$");
         if (!emailRegex.match(m_email).hasMatch()) {
             return false;
         }
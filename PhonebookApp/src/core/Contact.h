@@ -4,6 +4,7 @@
 #include <QString>
 #include <QDataStream>
 #include <QMetaType>
+#include <atomic>
 
 class Contact {
 public:
@@ -20,7 +21,11 @@ public:
     void setName(const QString& name) { m_name = name; }
     void setPhone(const QString& phone) { m_phone = phone; }
     void setEmail(const QString& email) { m_email = email; }
-    void setId(int id) { m_id = id; }
+    void setId(int id);
+    
+    // A new id, distinct from every id created or set so far. Safe to call
+    // from any thread, as are the constructors and setId().
+    static int allocateId();
     
     // Operators for BST comparison
     bool operator<(const Contact& other) const;
@@ -40,7 +45,19 @@ private:
     QString m_phone;
     QString m_email;
     
-    static int s_nextId;
+    static void reserveId(int id);
+    
+    static std::atomic<int> s_nextId;
+};
+
+// Orderings for secondary sorted views. Ties fall back to the name so every
+// contact keeps a distinct position.
+struct ContactPhoneOrder {
+    bool operator()(const Contact& a, const Contact& b) const;
+};
+
+struct ContactEmailOrder {
+    bool operator()(const Contact& a, const Contact& b) const;
 };
 
 Q_DECLARE_METATYPE(Contact)
@@ -0,0 +1,449 @@
+#include "ContactIndex.h"
+#include <algorithm>
+
+namespace {
+    // std::map node: colour plus parent/left/right links ahead of the value
+    const qint64 MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    qint64 multiMapBytes(const QMultiMap<QString, int>& map, StringFootprint& keys) {
+        qint64 bytes = map.size() * (MAP_NODE_OVERHEAD + sizeof(QString) + sizeof(int));
+        for (auto it = map.keyBegin(); it != map.keyEnd(); ++it) {
+            bytes += keys.add(*it);
+        }
+        return bytes;
+    }
+
+    // QHash keeps one offset byte per bucket plus entry storage
+    template<typename Key, typename T>
+    qint64 hashTableBytes(const QHash<Key, T>& hash) {
+        return hash.capacity() * static_cast<qint64>(1 + sizeof(Key) + sizeof(T));
+    }
+}
+
+void ContactIndex::insert(const Contact& contact) {
+    const QString key = keyOf(contact);
+    if (m_slotByKey.contains(key)) {
+        return;
+    }
+
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+        m_slots[slot] = contact;
+    } else {
+        slot = static_cast<int>(m_slots.size());
+        m_slots.push_back(contact);
+    }
+    m_slotByKey.insert(key, slot);
+
+    const QString phoneDigits = ContactQuery::digitsOf(contact.getPhone());
+    const QString email = contact.getEmail().toLower();
+
+    m_byName.insert(key, slot);
+    m_byPhone.insert(phoneDigits, slot);
+    if (!email.isEmpty()) {
+        m_byEmail.insert(email, slot);
+        m_byEmailReversed.insert(reversed(email), slot);
+    }
+
+    addTrigrams(NameTrigrams, key, slot);
+    addTrigrams(PhoneTrigrams, phoneDigits, slot);
+    addTrigrams(EmailTrigrams, email, slot);
+}
+
+bool ContactIndex::remove(const Contact& contact) {
+    auto it = m_slotByKey.find(keyOf(contact));
+    if (it == m_slotByKey.end()) {
+        return false;
+    }
+
+    const int slot = it.value();
+    const Contact stored = *m_slots[slot];
+    m_slotByKey.erase(it);
+
+    const QString key = keyOf(stored);
+    const QString phoneDigits = ContactQuery::digitsOf(stored.getPhone());
+    const QString email = stored.getEmail().toLower();
+
+    m_byName.remove(key, slot);
+    m_byPhone.remove(phoneDigits, slot);
+    if (!email.isEmpty()) {
+        m_byEmail.remove(email, slot);
+        m_byEmailReversed.remove(reversed(email), slot);
+    }
+
+    removeTrigrams(NameTrigrams, key, slot);
+    removeTrigrams(PhoneTrigrams, phoneDigits, slot);
+    removeTrigrams(EmailTrigrams, email, slot);
+
+    m_slots[slot].reset();
+    m_freeSlots.append(slot);
+    return true;
+}
+
+void ContactIndex::clear() {
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_slotByKey.clear();
+    m_byName.clear();
+    m_byPhone.clear();
+    m_byEmail.clear();
+    m_byEmailReversed.clear();
+    for (auto& trigrams : m_trigrams) {
+        trigrams.clear();
+    }
+}
+
+int ContactIndex::size() const {
+    return m_slotByKey.size();
+}
+
+qint64 ContactIndex::memoryUsage(StringFootprint& contactStrings) const {
+    StringFootprint keys;
+    qint64 bytes = static_cast<qint64>(m_slots.capacity() * sizeof(std::optional<Contact>));
+    bytes += m_freeSlots.capacity() * static_cast<qint64>(sizeof(int));
+
+    // Slot copies share their payloads with the tree; charge them there
+    for (const std::optional<Contact>& slot : m_slots) {
+        if (slot) {
+            contactStrings.add(slot->getName());
+            contactStrings.add(slot->getPhone());
+            contactStrings.add(slot->getEmail());
+        }
+    }
+
+    bytes += hashTableBytes(m_slotByKey);
+    for (auto it = m_slotByKey.keyBegin(); it != m_slotByKey.keyEnd(); ++it) {
+        bytes += keys.add(*it);
+    }
+
+    bytes += multiMapBytes(m_byName, keys);
+    bytes += multiMapBytes(m_byPhone, keys);
+    bytes += multiMapBytes(m_byEmail, keys);
+    bytes += multiMapBytes(m_byEmailReversed, keys);
+
+    for (const auto& trigrams : m_trigrams) {
+        bytes += hashTableBytes(trigrams);
+        for (auto it = trigrams.cbegin(); it != trigrams.cend(); ++it) {
+            bytes += keys.add(it.key());
+            bytes += it.value().capacity() * static_cast<qint64>(1 + sizeof(int));
+        }
+    }
+
+    return bytes;
+}
+
+ContactIndex::QueryPlan ContactIndex::plan(const ContactQuery& query) const {
+    QueryPlan best;
+    best.totalRows = size();
+    best.estimatedRows = best.totalRows;
+
+    if (!query.isValid()) {
+        best.estimatedRows = 0;
+        return best;
+    }
+
+    const QList<ContactQuery::Term>& terms = query.terms();
+    for (int i = 0; i < terms.size(); ++i) {
+        for (AccessPath path : pathsFor(terms[i])) {
+            // Counting stops as soon as a path is no better than the current best
+            int rows = estimate(terms[i], path, best.estimatedRows);
+            if (rows < best.estimatedRows || (best.path == FullScan && rows <= best.estimatedRows)) {
+                best.path = path;
+                best.termIndex = i;
+                best.estimatedRows = rows;
+            }
+        }
+    }
+
+    return best;
+}
+
+QList<Contact> ContactIndex::execute(const ContactQuery& query, const QueryPlan& plan) const {
+    QList<Contact> results;
+
+    if (!query.isValid()) {
+        return results;
+    }
+
+    if (plan.path == FullScan || plan.termIndex < 0 || plan.termIndex >= query.terms().size()) {
+        // The name index is ordered, so a full scan already yields name order
+        for (auto it = m_byName.cbegin(); it != m_byName.cend(); ++it) {
+            const Contact& contact = *m_slots[it.value()];
+            if (query.matches(contact)) {
+                results.append(contact);
+            }
+        }
+        return results;
+    }
+
+    const QList<int> slots = lookup(query.terms()[plan.termIndex], plan.path);
+    for (int slot : slots) {
+        const Contact& contact = *m_slots[slot];
+        if (query.matches(contact)) {
+            results.append(contact);
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+QList<Contact> ContactIndex::execute(const ContactQuery& query) const {
+    return execute(query, plan(query));
+}
+
+QString ContactIndex::accessPathName(AccessPath path) {
+    switch (path) {
+        case NamePrefixIndex: return "name prefix index";
+        case PhoneIndex: return "phone index";
+        case EmailIndex: return "email index";
+        case EmailSuffixIndex: return "email suffix index";
+        case TrigramIndex: return "trigram index";
+        default: return "full scan";
+    }
+}
+
+QString ContactIndex::QueryPlan::describe(const ContactQuery& query) const {
+    if (!query.isValid()) {
+        return QString("Invalid query: %1").arg(query.errorString());
+    }
+
+    QString description;
+    if (path == FullScan || termIndex < 0) {
+        description = QString("Full scan");
+    } else {
+        const ContactQuery::Term& term = query.terms()[termIndex];
+        description = QString("Lookup via %1 on %2 (%3 '%4')")
+                          .arg(accessPathName(path))
+                          .arg(ContactQuery::fieldName(term.field))
+                          .arg(ContactQuery::modeName(term.mode))
+                          .arg(term.value);
+    }
+
+    description += QString(", estimated %1 of %2 rows").arg(estimatedRows).arg(totalRows);
+
+    int residualTerms = query.terms().size() - (termIndex >= 0 ? 1 : 0);
+    if (residualTerms > 0) {
+        description += QString(", filter on %1 term(s)").arg(residualTerms);
+    }
+
+    return description;
+}
+
+QString ContactIndex::keyOf(const Contact& contact) {
+    return contact.getName().toLower();
+}
+
+QString ContactIndex::reversed(const QString& text) {
+    QString result(text);
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+QStringList ContactIndex::trigramsOf(const QString& text) {
+    QStringList trigrams;
+    for (int i = 0; i + 3 <= text.size(); ++i) {
+        trigrams.append(text.mid(i, 3));
+    }
+    trigrams.removeDuplicates();
+    return trigrams;
+}
+
+QList<ContactIndex::AccessPath> ContactIndex::pathsFor(const ContactQuery::Term& term) const {
+    QList<AccessPath> paths;
+
+    if (term.mode == ContactQuery::Prefix) {
+        switch (term.field) {
+            case ContactQuery::NameField: paths.append(NamePrefixIndex); break;
+            case ContactQuery::PhoneField: paths.append(PhoneIndex); break;
+            case ContactQuery::EmailField: paths.append(EmailIndex); break;
+            default: break;
+        }
+    } else if (term.mode == ContactQuery::Suffix && term.field == ContactQuery::EmailField) {
+        paths.append(EmailSuffixIndex);
+    }
+
+    if (!trigramFieldsFor(term).isEmpty()) {
+        paths.append(TrigramIndex);
+    }
+
+    return paths;
+}
+
+QList<ContactIndex::TrigramField> ContactIndex::trigramFieldsFor(const ContactQuery::Term& term) const {
+    QList<TrigramField> fields;
+
+    if (term.value.size() < 3) {
+        return fields;
+    }
+
+    switch (term.field) {
+        case ContactQuery::NameField:
+            fields.append(NameTrigrams);
+            break;
+        case ContactQuery::PhoneField:
+            fields.append(PhoneTrigrams);
+            break;
+        case ContactQuery::EmailField:
+            fields.append(EmailTrigrams);
+            break;
+        case ContactQuery::AnyField: {
+            // Phone trigrams are built over digits, so they only cover plain
+            // words that are all digits or cannot occur in a phone number
+            bool allDigits = true;
+            bool phoneCharsOnly = true;
+            for (QChar ch : term.value) {
+                if (!ch.isDigit()) {
+                    allDigits = false;
+                    if (!QString(" -()+").contains(ch)) {
+                        phoneCharsOnly = false;
+                    }
+                }
+            }
+
+            if (phoneCharsOnly && !allDigits) {
+                break;
+            }
+
+            fields.append(NameTrigrams);
+            fields.append(EmailTrigrams);
+            if (allDigits) {
+                fields.append(PhoneTrigrams);
+            }
+            break;
+        }
+    }
+
+    return fields;
+}
+
+int ContactIndex::estimate(const ContactQuery::Term& term, AccessPath path, int cap) const {
+    switch (path) {
+        case NamePrefixIndex:
+            return countPrefix(m_byName, term.value, cap);
+        case PhoneIndex:
+            return countPrefix(m_byPhone, term.value, cap);
+        case EmailIndex:
+            return countPrefix(m_byEmail, term.value, cap);
+        case EmailSuffixIndex:
+            return countPrefix(m_byEmailReversed, reversed(term.value), cap);
+        case TrigramIndex: {
+            int rows = 0;
+            for (TrigramField field : trigramFieldsFor(term)) {
+                rows += trigramEstimate(field, term.value);
+            }
+            return std::min(rows, size());
+        }
+        default:
+            return size();
+    }
+}
+
+QList<int> ContactIndex::lookup(const ContactQuery::Term& term, AccessPath path) const {
+    QList<int> slots;
+
+    switch (path) {
+        case NamePrefixIndex:
+            collectPrefix(m_byName, term.value, slots);
+            break;
+        case PhoneIndex:
+            collectPrefix(m_byPhone, term.value, slots);
+            break;
+        case EmailIndex:
+            collectPrefix(m_byEmail, term.value, slots);
+            break;
+        case EmailSuffixIndex:
+            collectPrefix(m_byEmailReversed, reversed(term.value), slots);
+            break;
+        case TrigramIndex: {
+            QSet<int> matches;
+            for (TrigramField field : trigramFieldsFor(term)) {
+                matches.unite(trigramLookup(field, term.value));
+            }
+            slots = matches.values();
+            break;
+        }
+        default:
+            break;
+    }
+
+    return slots;
+}
+
+int ContactIndex::countPrefix(const QMultiMap<QString, int>& map, const QString& prefix, int cap) {
+    int count = 0;
+    for (auto it = map.lowerBound(prefix); it != map.cend() && count < cap; ++it) {
+        if (!it.key().startsWith(prefix)) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+void ContactIndex::collectPrefix(const QMultiMap<QString, int>& map, const QString& prefix, QList<int>& slots) {
+    for (auto it = map.lowerBound(prefix); it != map.cend(); ++it) {
+        if (!it.key().startsWith(prefix)) {
+            break;
+        }
+        slots.append(it.value());
+    }
+}
+
+int ContactIndex::trigramEstimate(TrigramField field, const QString& value) const {
+    // The rarest trigram bounds the size of the intersection
+    int rows = size();
+    for (const QString& trigram : trigramsOf(value)) {
+        auto it = m_trigrams[field].constFind(trigram);
+        if (it == m_trigrams[field].cend()) {
+            return 0;
+        }
+        rows = std::min(rows, static_cast<int>(it->size()));
+    }
+    return rows;
+}
+
+QSet<int> ContactIndex::trigramLookup(TrigramField field, const QString& value) const {
+    QList<const QSet<int>*> postings;
+    for (const QString& trigram : trigramsOf(value)) {
+        auto it = m_trigrams[field].constFind(trigram);
+        if (it == m_trigrams[field].cend()) {
+            return QSet<int>();
+        }
+        postings.append(&it.value());
+    }
+
+    if (postings.isEmpty()) {
+        return QSet<int>();
+    }
+
+    // Intersect starting from the smallest posting list
+    std::sort(postings.begin(), postings.end(), [](const QSet<int>* a, const QSet<int>* b) {
+        return a->size() < b->size();
+    });
+
+    QSet<int> result = *postings.first();
+    for (int i = 1; i < postings.size() && !result.isEmpty(); ++i) {
+        result.intersect(*postings[i]);
+    }
+    return result;
+}
+
+void ContactIndex::addTrigrams(TrigramField field, const QString& text, int slot) {
+    for (const QString& trigram : trigramsOf(text)) {
+        m_trigrams[field][trigram].insert(slot);
+    }
+}
+
+void ContactIndex::removeTrigrams(TrigramField field, const QString& text, int slot) {
+    for (const QString& trigram : trigramsOf(text)) {
+        auto it = m_trigrams[field].find(trigram);
+        if (it != m_trigrams[field].end()) {
+            it->remove(slot);
+            if (it->isEmpty()) {
+                m_trigrams[field].erase(it);
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef CONTACTINDEX_H
+#define CONTACTINDEX_H
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QString>
+#include <optional>
+#include <vector>
+#include "Contact.h"
+#include "ContactQuery.h"
+#include "MemoryStats.h"
+
+// Secondary indexes over the contacts held by ContactManager. Each contact is
+// stored once in a slot; the indexes map keys to slot numbers. The planner
+// picks the access path with the smallest estimated cardinality for a query
+// and the remaining terms are applied as a residual filter.
+class ContactIndex {
+public:
+    enum AccessPath {
+        FullScan,
+        NamePrefixIndex,
+        PhoneIndex,
+        EmailIndex,
+        EmailSuffixIndex,
+        TrigramIndex
+    };
+
+    struct QueryPlan {
+        AccessPath path = FullScan;
+        int termIndex = -1;     // Term driving the index lookup, -1 for a full scan
+        int estimatedRows = 0;
+        int totalRows = 0;
+
+        QString describe(const ContactQuery& query) const;
+    };
+
+    ContactIndex() = default;
+
+    // Maintenance (contacts are keyed by lowercased name, like BST<Contact>)
+    void insert(const Contact& contact);
+    bool remove(const Contact& contact);
+    void clear();
+    int size() const;
+
+    // Bytes held by slots and indexes, including key strings. Payloads of the
+    // stored contacts are charged to contactStrings instead.
+    qint64 memoryUsage(StringFootprint& contactStrings) const;
+
+    // Planning and execution
+    QueryPlan plan(const ContactQuery& query) const;
+    QList<Contact> execute(const ContactQuery& query, const QueryPlan& plan) const;
+    QList<Contact> execute(const ContactQuery& query) const;
+
+    static QString accessPathName(AccessPath path);
+
+private:
+    enum TrigramField {
+        NameTrigrams,
+        PhoneTrigrams,
+        EmailTrigrams,
+        TrigramFieldCount
+    };
+
+    static QString keyOf(const Contact& contact);
+    static QString reversed(const QString& text);
+    static QStringList trigramsOf(const QString& text);
+
+    QList<AccessPath> pathsFor(const ContactQuery::Term& term) const;
+    QList<TrigramField> trigramFieldsFor(const ContactQuery::Term& term) const;
+    int estimate(const ContactQuery::Term& term, AccessPath path, int cap) const;
+    QList<int> lookup(const ContactQuery::Term& term, AccessPath path) const;
+
+    static int countPrefix(const QMultiMap<QString, int>& map, const QString& prefix, int cap);
+    static void collectPrefix(const QMultiMap<QString, int>& map, const QString& prefix, QList<int>& slots);
+    int trigramEstimate(TrigramField field, const QString& value) const;
+    QSet<int> trigramLookup(TrigramField field, const QString& value) const;
+
+    void addTrigrams(TrigramField field, const QString& text, int slot);
+    void removeTrigrams(TrigramField field, const QString& text, int slot);
+
+    std::vector<std::optional<Contact>> m_slots;
+    QList<int> m_freeSlots;
+    QHash<QString, int> m_slotByKey;
+
+    QMultiMap<QString, int> m_byName;           // Lowercased name (also gives name order)
+    QMultiMap<QString, int> m_byPhone;          // Phone digits
+    QMultiMap<QString, int> m_byEmail;          // Lowercased email
+    QMultiMap<QString, int> m_byEmailReversed;  // Reversed lowercased email, for suffix lookups
+    QHash<QString, QSet<int>> m_trigrams[TrigramFieldCount];
+};
+
+#endif // CONTACTINDEX_H
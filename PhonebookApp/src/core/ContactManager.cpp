@@ -1,7 +1,22 @@
 #include "ContactManager.h"
+#include "ThreadPool.h"
 #include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QPromise>
+#include <algorithm>
 #include <QDebug>
 
+namespace {
+    // Below this size validating on the calling thread is cheaper than dispatching
+    const int PARALLEL_VALIDATION_THRESHOLD = 1024;
+    
+    // Bursts larger than this are collapsed into a single Reset change
+    const int MAX_PENDING_CHANGES = 512;
+    
+    // Work unit for asynchronous operations, between progress and cancel checks
+    const int ASYNC_CHUNK_SIZE = 4096;
+}
+
 ContactManager::ContactManager(QObject* parent) : QObject(parent) {
 }
 
@@ -18,20 +33,34 @@ bool ContactManager::addContact(const Contact& contact) {
         return false;
     }
     
-    m_contacts.insert(contact);
-    emit contactAdded(contact);
+    const Contact added = withUnusedId(contact);
+    if (!storeContact(added)) {
+        qWarning() << "Contact name already in use:" << contact.getName();
+        return false;
+    }
+    
+    recordChange({ContactChange::Inserted, viewRow(added), -1, added});
+    emit contactAdded(added);
     return true;
 }
 
 bool ContactManager::removeContact(const Contact& contact) {
     QMutexLocker locker(&m_mutex);
     
-    if (m_contacts.remove(contact)) {
-        emit contactRemoved(contact);
-        return true;
+    // Matched by name alone, as BST::remove() does; the phone may differ
+    const Contact* stored = m_contacts.findEquivalent(contact);
+    if (!stored) {
+        return false;
     }
     
-    return false;
+    // Views are keyed on phone and email, so remove the stored copy
+    Contact previous = *stored;
+    int row = viewRow(previous);
+    unstoreContact(previous);
+    
+    recordChange({ContactChange::Removed, row, -1, previous});
+    emit contactRemoved(previous);
+    return true;
 }
 
 bool ContactManager::updateContact(const Contact& oldContact, const Contact& newContact) {
@@ -48,13 +77,30 @@ bool ContactManager::updateContact(const Contact& oldContact, const Contact& new
         return false;
     }
     
-    if (m_contacts.remove(oldContact)) {
-        m_contacts.insert(newContact);
-        emit contactUpdated(oldContact, newContact);
-        return true;
+    // Matched by name alone, as the baseline's BST::remove() did
+    const Contact* stored = m_contacts.findEquivalent(oldContact);
+    if (!stored) {
+        return false;
     }
     
-    return false;
+    Contact previous = *stored;
+    int row = viewRow(previous);
+    unstoreContact(previous);
+    
+    // An edit keeps the identity of the stored contact
+    Contact updated = newContact;
+    updated.setId(previous.getId());
+    
+    if (!storeContact(updated)) {
+        // The new name belongs to another contact; keep the original
+        storeContact(previous);
+        qWarning() << "Updated contact name already in use:" << newContact.getName();
+        return false;
+    }
+    
+    recordChange({ContactChange::Moved, row, viewRow(updated), updated});
+    emit contactUpdated(previous, updated);
+    return true;
 }
 
 QList<Contact> ContactManager::getAllContacts() const {
@@ -62,6 +108,44 @@ QList<Contact> ContactManager::getAllContacts() const {
     return m_contacts.inorderTraversal();
 }
 
+QList<Contact> ContactManager::getSortedContacts() const {
+    QMutexLocker locker(&m_mutex);
+    switch (m_sortKey) {
+        case SortByPhone: return m_byPhone.inorderTraversal();
+        case SortByEmail: return m_byEmail.inorderTraversal();
+        default: return m_contacts.inorderTraversal();
+    }
+}
+
+QList<Contact> ContactManager::resyncSortedContacts() {
+    QMutexLocker locker(&m_mutex);
+    m_pendingChanges.clear();
+    switch (m_sortKey) {
+        case SortByPhone: return m_byPhone.inorderTraversal();
+        case SortByEmail: return m_byEmail.inorderTraversal();
+        default: return m_contacts.inorderTraversal();
+    }
+}
+
+QList<Contact> ContactManager::getContactsPage(int offset, int limit) const {
+    if (offset < 0 || limit <= 0) {
+        return QList<Contact>();
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    switch (m_sortKey) {
+        case SortByPhone: return m_byPhone.range(offset, limit);
+        case SortByEmail: return m_byEmail.range(offset, limit);
+        default: return m_contacts.range(offset, limit);
+    }
+}
+
+int ContactManager::rowOf(const Contact& contact) const {
+    QMutexLocker locker(&m_mutex);
+    const Contact* stored = m_contacts.find(contact);
+    return stored ? viewRow(*stored) : -1;
+}
+
 QList<Contact> ContactManager::searchContacts(const QString& query) const {
     if (query.isEmpty()) {
         return getAllContacts();
@@ -83,17 +167,225 @@ const Contact* ContactManager::findContact(const QString& name, const QString& p
     return m_contacts.find(searchContact);
 }
 
+const Contact* ContactManager::findContactById(int id) const {
+    QMutexLocker locker(&m_mutex);
+    return storedById(id);
+}
+
+QList<Contact> ContactManager::query(const ContactQuery& query) const {
+    if (query.isValid() && query.isEmpty()) {
+        return getAllContacts();
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    return m_index.execute(query);
+}
+
+ContactIndex::QueryPlan ContactManager::planQuery(const ContactQuery& query) const {
+    QMutexLocker locker(&m_mutex);
+    return m_index.plan(query);
+}
+
+QString ContactManager::explain(const ContactQuery& query) const {
+    return planQuery(query).describe(query);
+}
+
 void ContactManager::clearAllContacts() {
     QMutexLocker locker(&m_mutex);
+    m_contacts.forEach([this](const Contact& contact) {
+        if (m_storedIds.contains(contact.getId())) {
+            m_removedIds.insert(contact.getId());
+        }
+        return true;
+    });
+    m_dirty.clear();
+    m_nameById.clear();
     m_contacts.clear();
+    m_index.clear();
+    m_byPhone.clear();
+    m_byEmail.clear();
+    recordReset();
     emit contactsCleared();
 }
 
+ContactManager::DirtySet ContactManager::takeDirty() {
+    QMutexLocker locker(&m_mutex);
+    DirtySet dirty;
+    for (const Contact& contact : m_dirty) {
+        if (m_storedIds.contains(contact.getId())) {
+            dirty.updated.append(contact);
+        } else {
+            dirty.inserted.append(contact);
+        }
+    }
+    dirty.removedIds = m_removedIds.values();
+    m_dirty.clear();
+    m_removedIds.clear();
+    return dirty;
+}
+
+void ContactManager::restoreDirty(const DirtySet& dirty) {
+    QMutexLocker locker(&m_mutex);
+    
+    // Anything changed again since takeDirty() is newer; keep that. Unsaved
+    // contacts removed since then have nothing left to write.
+    for (const Contact& contact : dirty.inserted) {
+        if (!m_dirty.contains(contact.getId()) && m_nameById.contains(contact.getId())) {
+            m_dirty.insert(contact.getId(), contact);
+        }
+    }
+    for (const Contact& contact : dirty.updated) {
+        if (!m_dirty.contains(contact.getId()) && !m_removedIds.contains(contact.getId())) {
+            m_dirty.insert(contact.getId(), contact);
+        }
+    }
+    for (int id : dirty.removedIds) {
+        if (!m_dirty.contains(id)) {
+            m_removedIds.insert(id);
+        }
+    }
+}
+
+bool ContactManager::hasUnsavedChanges() const {
+    QMutexLocker locker(&m_mutex);
+    return !m_dirty.isEmpty() || !m_removedIds.isEmpty();
+}
+
+void ContactManager::adoptStoredIds(const QList<Contact>& inserted, const QList<int>& storedIds) {
+    QMutexLocker locker(&m_mutex);
+    
+    // Current id of every contact still waiting for its stored id
+    QList<int> currentIds;
+    QHash<int, int> waiting;
+    for (int i = 0; i < inserted.size(); ++i) {
+        currentIds.append(inserted[i].getId());
+        waiting.insert(inserted[i].getId(), i);
+    }
+    
+    for (int i = 0; i < inserted.size() && i < storedIds.size(); ++i) {
+        const int fromId = currentIds[i];
+        const int toId = storedIds[i];
+        waiting.remove(fromId);
+        
+        const bool present = m_nameById.contains(fromId) && !m_storedIds.contains(fromId);
+        m_storedIds.insert(toId);
+        if (!present) {
+            // Removed since it was written; the row has to go too
+            m_removedIds.insert(toId);
+            continue;
+        }
+        if (fromId == toId) {
+            continue;
+        }
+        
+        if (m_nameById.contains(toId)) {
+            // Another unsaved contact holds the id storage handed out
+            const int freshId = Contact::allocateId();
+            auto it = waiting.find(toId);
+            if (it != waiting.end()) {
+                currentIds[it.value()] = freshId;
+                waiting.insert(freshId, it.value());
+                waiting.erase(it);
+            }
+            renumberContact(toId, freshId);
+        }
+        renumberContact(fromId, toId);
+    }
+}
+
+int ContactManager::mergeStoredContacts(const QList<Contact>& contacts) {
+    QMutexLocker locker(&m_mutex);
+    m_tracking = false;
+    int merged = 0;
+    
+    for (const Contact& contact : contacts) {
+        const int id = contact.getId();
+        if (m_nameById.contains(id) && !m_storedIds.contains(id)) {
+            // An unsaved contact was given this id locally; the row wins it
+            renumberContact(id, Contact::allocateId());
+        }
+        m_storedIds.insert(id);
+        
+        if (m_dirty.contains(id) || m_removedIds.contains(id)) {
+            continue;    // Local edits win until they are persisted
+        }
+        
+        const Contact* stored = storedById(id);
+        if (!stored) {
+            if (!storeContact(contact)) {
+                qWarning() << "Stored contact" << id << "conflicts with name" << contact.getName();
+                continue;
+            }
+            recordChange({ContactChange::Inserted, viewRow(contact), -1, contact});
+            merged++;
+            continue;
+        }
+        if (stored->getName() == contact.getName() && stored->getPhone() == contact.getPhone() &&
+            stored->getEmail() == contact.getEmail()) {
+            continue;    // Already current
+        }
+        
+        Contact previous = *stored;
+        int row = viewRow(previous);
+        unstoreContact(previous);
+        if (!storeContact(contact)) {
+            storeContact(previous);
+            qWarning() << "Stored contact" << id << "conflicts with name" << contact.getName();
+            continue;
+        }
+        recordChange({ContactChange::Moved, row, viewRow(contact), contact});
+        merged++;
+    }
+    
+    m_tracking = true;
+    return merged;
+}
+
 int ContactManager::getContactCount() const {
     QMutexLocker locker(&m_mutex);
     return static_cast<int>(m_contacts.size());
 }
 
+MemoryStats ContactManager::memoryStats() const {
+    QMutexLocker locker(&m_mutex);
+    
+    MemoryStats stats;
+    stats.contacts = static_cast<int>(m_contacts.size());
+    stats.treeBytes = static_cast<qint64>(m_contacts.nodeBytes() + m_byPhone.nodeBytes() + m_byEmail.nodeBytes());
+    
+    // Every view holds copies of the same contacts; shared payloads count once
+    StringFootprint strings;
+    auto charge = [&strings](const Contact& contact) {
+        strings.add(contact.getName());
+        strings.add(contact.getPhone());
+        strings.add(contact.getEmail());
+        return true;
+    };
+    m_contacts.forEach(charge);
+    m_byPhone.forEach(charge);
+    m_byEmail.forEach(charge);
+    
+    stats.indexBytes = m_index.memoryUsage(strings);
+    stats.indexBytes += m_nameById.capacity() * static_cast<qint64>(sizeof(int) + sizeof(QString));
+    stats.indexBytes += m_storedIds.capacity() * static_cast<qint64>(sizeof(int));
+    for (const QString& name : m_nameById) {
+        strings.add(name);
+    }
+    
+    stats.cacheBytes = m_pendingChanges.capacity() * static_cast<qint64>(sizeof(ContactChange));
+    for (const ContactChange& change : m_pendingChanges) {
+        charge(change.contact);
+    }
+    stats.cacheBytes += m_dirty.capacity() * static_cast<qint64>(sizeof(int) + sizeof(Contact));
+    for (const Contact& contact : m_dirty) {
+        charge(contact);
+    }
+    
+    stats.stringBytes = strings.bytes();
+    stats.sharedStringBytes = strings.sharedBytes();
+    return stats;
+}
+
 bool ContactManager::isEmpty() const {
     QMutexLocker locker(&m_mutex);
     return m_contacts.isEmpty();
@@ -103,38 +395,392 @@ QList<Contact> ContactManager::getContactsForExport() const {
     return getAllContacts();
 }
 
+bool ContactManager::forEachContact(const std::function<bool(const Contact&)>& visit) const {
+    QMutexLocker locker(&m_mutex);
+    m_contacts.forEach(visit);
+    return true;
+}
+
 bool ContactManager::importContacts(const QList<Contact>& contacts) {
-    int successCount = 0;
+    return importContactsBatch(contacts).added > 0;
+}
+
+ImportReport ContactManager::importContactsBatch(const QList<Contact>& contacts) {
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Validation needs no lock, so it runs before the tree is touched
+    const QList<bool> valid = validateContacts(contacts);
+    ImportReport report = insertValidated(contacts, valid, 0);
+    report.total = contacts.size();
+    report.elapsedMs = timer.elapsed();
+    
+    if (report.skipped() > 0) {
+        qWarning() << "Import skipped" << report.invalid << "invalid and"
+                   << report.duplicates << "duplicate contact(s)";
+    }
+    
+    emit contactsImported(report.added, report.skipped());
+    return report;
+}
+
+MergePlan ContactManager::planImport(const QList<Contact>& contacts, const Deduplicator::Options& options) const {
+    return Deduplicator(options).plan(contacts, getAllContacts());
+}
+
+ImportReport ContactManager::applyMergePlan(const QList<Contact>& contacts, const MergePlan& plan) {
+    for (const MergePlan::Group& group : plan.groups) {
+        if (group.updatesExisting && !group.needsReview()) {
+            updateContact(group.merged, group.merged);
+        }
+    }
+    
+    ImportReport report = importContactsBatch(plan.contactsToImport(contacts));
+    report.total = contacts.size();
+    report.duplicates += plan.duplicateRows();
+    
+    // Rejections refer to the survivors; report them by incoming row, along
+    // with the rows the plan merged away
+    const QList<int> rows = plan.rowsToImport();
+    for (ImportReport::Rejection& rejection : report.rejections) {
+        rejection.row = rows[rejection.row];
+    }
+    for (const MergePlan::Group& group : plan.groups) {
+        if (group.needsReview()) {
+            continue;
+        }
+        for (int i = group.existingIndex < 0 ? 1 : 0; i < group.rows.size(); ++i) {
+            report.rejections.append(ImportReport::Rejection{group.rows[i], ImportReport::DuplicateContact});
+        }
+    }
+    std::sort(report.rejections.begin(), report.rejections.end(),
+              [](const ImportReport::Rejection& a, const ImportReport::Rejection& b) { return a.row < b.row; });
+    return report;
+}
+
+QFuture<QList<Contact>> ContactManager::getAllContactsAsync() const {
+    return ThreadPool::instance().executeWithPromise<QList<Contact>>([this](QPromise<QList<Contact>>& promise) {
+        promise.setProgressRange(0, 1);
+        if (promise.isCanceled()) {
+            return;
+        }
+        
+        promise.addResult(getAllContacts());
+        promise.setProgressValue(1);
+    });
+}
+
+QFuture<QList<Contact>> ContactManager::searchContactsAsync(const QString& query) const {
+    return ThreadPool::instance().executeWithPromise<QList<Contact>>([this, query](QPromise<QList<Contact>>& promise) {
+        // Filter a snapshot so the lock is not held while matching
+        const QList<Contact> contacts = getAllContacts();
+        promise.setProgressRange(0, contacts.size());
+        
+        if (query.isEmpty()) {
+            promise.addResult(contacts);
+            promise.setProgressValue(contacts.size());
+            return;
+        }
+        
+        QList<Contact> results;
+        for (int start = 0; start < contacts.size(); start += ASYNC_CHUNK_SIZE) {
+            if (promise.isCanceled()) {
+                return;
+            }
+            
+            int end = std::min<int>(start + ASYNC_CHUNK_SIZE, contacts.size());
+            for (int i = start; i < end; ++i) {
+                const Contact& contact = contacts[i];
+                if (contact.getName().contains(query, Qt::CaseInsensitive) ||
+                    contact.getPhone().contains(query) ||
+                    contact.getEmail().contains(query, Qt::CaseInsensitive)) {
+                    results.append(contact);
+                }
+            }
+            promise.setProgressValue(end);
+        }
+        
+        promise.addResult(results);
+    });
+}
+
+QFuture<ImportReport> ContactManager::importContactsAsync(const QList<Contact>& contacts) {
+    return ThreadPool::instance().executeWithPromise<ImportReport>([this, contacts](QPromise<ImportReport>& promise) {
+        QElapsedTimer timer;
+        timer.start();
+        
+        ImportReport report;
+        report.total = contacts.size();
+        promise.setProgressRange(0, contacts.size());
+        
+        // Contacts imported before a cancellation are kept
+        for (int start = 0; start < contacts.size(); start += ASYNC_CHUNK_SIZE) {
+            if (promise.isCanceled()) {
+                break;
+            }
+            
+            const QList<Contact> chunk = contacts.mid(start, ASYNC_CHUNK_SIZE);
+            ImportReport partial = insertValidated(chunk, validateContacts(chunk), start);
+            
+            report.added += partial.added;
+            report.invalid += partial.invalid;
+            report.duplicates += partial.duplicates;
+            report.rejections.append(partial.rejections);
+            
+            promise.setProgressValue(start + chunk.size());
+        }
+        
+        report.elapsedMs = timer.elapsed();
+        notifyImported(report);
+        promise.addResult(report);
+    });
+}
+
+QFuture<ImportReport> ContactManager::importStreamAsync(const StreamReader& reader) {
+    return ThreadPool::instance().executeWithPromise<ImportReport>([this, reader](QPromise<ImportReport>& promise) {
+        QElapsedTimer timer;
+        timer.start();
+        
+        ImportReport report;
+        promise.setProgressRange(0, STREAM_PROGRESS_STEPS);
+        
+        const bool complete = reader([this, &promise, &report](const QList<Contact>& batch) {
+            if (promise.isCanceled()) {
+                return false;
+            }
+            
+            ImportReport partial = insertValidated(batch, validateContacts(batch), report.total);
+            report.total += batch.size();
+            report.added += partial.added;
+            report.invalid += partial.invalid;
+            report.duplicates += partial.duplicates;
+            report.rejections.append(partial.rejections);
+            return true;
+        }, [&promise](qint64 done, qint64 total) {
+            if (total > 0) {
+                promise.setProgressValue(static_cast<int>(qMin(done, total) * STREAM_PROGRESS_STEPS / total));
+            }
+        });
+        
+        if (!complete && !promise.isCanceled()) {
+            report.error = "The source could not be read completely";
+        }
+        report.elapsedMs = timer.elapsed();
+        notifyImported(report);
+        promise.addResult(report);
+    });
+}
+
+void ContactManager::notifyImported(const ImportReport& report) {
+    // Called on a pool thread; delivered from the manager's event loop like
+    // contactsChanged, so receivers need not be thread-safe
+    QMetaObject::invokeMethod(this, [this, added = report.added, skipped = report.skipped()]() {
+        emit contactsImported(added, skipped);
+    }, Qt::QueuedConnection);
+}
+
+QList<bool> ContactManager::validateContacts(const QList<Contact>& contacts) {
+    if (contacts.size() >= PARALLEL_VALIDATION_THRESHOLD) {
+        return ThreadPool::instance().blockingMapped(contacts, [](const Contact& contact) {
+            return contact.isValid();
+        });
+    }
     
+    QList<bool> valid;
+    valid.reserve(contacts.size());
     for (const Contact& contact : contacts) {
-        if (addContact(contact)) {
-            successCount++;
+        valid.append(contact.isValid());
+    }
+    return valid;
+}
+
+ContactManager::SortKey ContactManager::sortKey() const {
+    QMutexLocker locker(&m_mutex);
+    return m_sortKey;
+}
+
+void ContactManager::setSortKey(SortKey key) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_sortKey == key) {
+            return;
         }
+        
+        // Every view is kept up to date, so switching order is O(1); rows
+        // reported by earlier changes refer to the old order
+        m_sortKey = key;
+        recordReset();
     }
     
-    return successCount > 0;
+    emit sortOrderChanged(key);
 }
 
 void ContactManager::sortContactsByName() {
-    // BST automatically keeps contacts sorted by name
-    // This method exists for interface compatibility
-    emit contactsCleared(); // Trigger UI refresh
+    setSortKey(SortByName);
 }
 
 void ContactManager::sortContactsByPhone() {
-    QMutexLocker locker(&m_mutex);
-    QList<Contact> contacts = m_contacts.inorderTraversal();
-    
-    // Sort by phone number
-    std::sort(contacts.begin(), contacts.end(), [](const Contact& a, const Contact& b) {
-        return a.getPhone() < b.getPhone();
-    });
-    
-    // This is for display purposes only - the BST structure remains unchanged
-    // In a real implementation, you might want to emit a sorted list
+    setSortKey(SortByPhone);
+}
+
+void ContactManager::sortContactsByEmail() {
+    setSortKey(SortByEmail);
 }
 
 bool ContactManager::isContactDuplicate(const Contact& contact) const {
     // Check for exact match (name and phone)
     return m_contacts.contains(contact);
 }
+
+bool ContactManager::storeContact(const Contact& contact) {
+    if (!m_contacts.insert(contact)) {
+        return false;
+    }
+    
+    m_index.insert(contact);
+    m_byPhone.insert(contact);
+    m_byEmail.insert(contact);
+    m_nameById.insert(contact.getId(), contact.getName());
+    
+    if (m_tracking) {
+        m_dirty.insert(contact.getId(), contact);
+        m_removedIds.remove(contact.getId());
+    }
+    return true;
+}
+
+void ContactManager::unstoreContact(const Contact& stored) {
+    m_contacts.remove(stored);
+    m_index.remove(stored);
+    m_byPhone.remove(stored);
+    m_byEmail.remove(stored);
+    m_nameById.remove(stored.getId());
+    
+    if (m_tracking) {
+        m_dirty.remove(stored.getId());
+        if (m_storedIds.contains(stored.getId())) {
+            m_removedIds.insert(stored.getId());
+        }
+    }
+}
+
+Contact ContactManager::withUnusedId(const Contact& contact) const {
+    // Imported files carry their own ids; one that names another contact or
+    // a stored row would be persisted over it
+    if (!m_nameById.contains(contact.getId()) && !m_storedIds.contains(contact.getId())) {
+        return contact;
+    }
+    Contact renumbered = contact;
+    renumbered.setId(Contact::allocateId());
+    return renumbered;
+}
+
+const Contact* ContactManager::storedById(int id) const {
+    auto it = m_nameById.constFind(id);
+    if (it == m_nameById.constEnd()) {
+        return nullptr;
+    }
+    // Names are the tree's key; the phone is not known here
+    return m_contacts.findEquivalent(Contact(it.value(), QString()));
+}
+
+void ContactManager::renumberContact(int fromId, int toId) {
+    const Contact* stored = storedById(fromId);
+    if (!stored) {
+        return;
+    }
+    
+    Contact previous = *stored;
+    Contact renumbered = previous;
+    renumbered.setId(toId);
+    int row = viewRow(previous);
+    
+    // Same contact under another id: not a change to persist in itself
+    const bool tracking = m_tracking;
+    m_tracking = false;
+    unstoreContact(previous);
+    storeContact(renumbered);
+    m_tracking = tracking;
+    
+    if (m_dirty.remove(fromId)) {
+        m_dirty.insert(toId, renumbered);
+    }
+    recordChange({ContactChange::Moved, row, viewRow(renumbered), renumbered});
+}
+
+int ContactManager::viewRow(const Contact& contact) const {
+    switch (m_sortKey) {
+        case SortByPhone: return static_cast<int>(m_byPhone.rank(contact));
+        case SortByEmail: return static_cast<int>(m_byEmail.rank(contact));
+        default: return static_cast<int>(m_contacts.rank(contact));
+    }
+}
+
+ImportReport ContactManager::insertValidated(const QList<Contact>& contacts, const QList<bool>& valid, int firstRow) {
+    ImportReport report;
+    QMutexLocker locker(&m_mutex);
+    
+    for (int i = 0; i < contacts.size(); ++i) {
+        const int row = firstRow + i;
+        
+        if (!valid[i]) {
+            report.invalid++;
+            report.rejections.append(ImportReport::Rejection{row, ImportReport::InvalidContact});
+            continue;
+        }
+        
+        const Contact added = withUnusedId(contacts[i]);
+        if (!storeContact(added)) {
+            report.duplicates++;
+            report.rejections.append(ImportReport::Rejection{row, ImportReport::DuplicateContact});
+            continue;
+        }
+        
+        recordChange({ContactChange::Inserted, viewRow(added), -1, added});
+        report.added++;
+    }
+    
+    return report;
+}
+
+void ContactManager::recordChange(const ContactChange& change) {
+    if (m_pendingChanges.size() == 1 && m_pendingChanges.first().type == ContactChange::Reset) {
+        return;  // A pending reset already covers this change
+    }
+    
+    if (m_pendingChanges.size() >= MAX_PENDING_CHANGES) {
+        recordReset();
+        return;
+    }
+    
+    m_pendingChanges.append(change);
+    scheduleFlush();
+}
+
+void ContactManager::recordReset() {
+    m_pendingChanges.clear();
+    m_pendingChanges.append(ContactChange());
+    scheduleFlush();
+}
+
+void ContactManager::scheduleFlush() {
+    if (!m_flushScheduled) {
+        // Delivered from the manager's event loop, whichever thread mutated
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, [this]() { flushChanges(); }, Qt::QueuedConnection);
+    }
+}
+
+void ContactManager::flushChanges() {
+    QList<ContactChange> changes;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        changes.swap(m_pendingChanges);
+        m_flushScheduled = false;
+    }
+    
+    if (!changes.isEmpty()) {
+        emit contactsChanged(changes);
+    }
+}
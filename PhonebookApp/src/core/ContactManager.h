@@ -3,15 +3,72 @@
 
 #include "Contact.h"
 #include "BST.h"
+#include "ContactIndex.h"
+#include "ContactQuery.h"
+#include "Deduplicator.h"
+#include "MemoryStats.h"
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QFuture>
+#include <functional>
 #include <memory>
 #include <QMutex>
 
+// Outcome of a batch import; row numbers index into the imported list
+struct ImportReport {
+    enum Reason {
+        InvalidContact,
+        DuplicateContact
+    };
+    
+    struct Rejection {
+        int row;
+        Reason reason;
+    };
+    
+    int total = 0;
+    int added = 0;
+    int invalid = 0;
+    int duplicates = 0;
+    QList<Rejection> rejections;
+    qint64 elapsedMs = 0;
+    QString error;    // Set when a streamed import could not read its whole source
+    
+    int skipped() const { return invalid + duplicates; }
+};
+
+// Positional change to the contact list in the active sort order. Changes are delivered
+// in batches and must be applied in order; each row refers to the list as it
+// stands after the previous change in the batch.
+struct ContactChange {
+    enum Type {
+        Inserted,   // contact now sits at row
+        Removed,    // contact at row was removed
+        Moved,      // contact at row was replaced and now sits at toRow
+        Reset       // too many changes to describe; reload everything
+    };
+    
+    Type type = Reset;
+    int row = -1;
+    int toRow = -1;
+    Contact contact;
+};
+
+Q_DECLARE_METATYPE(ContactChange)
+
 class ContactManager : public QObject {
     Q_OBJECT
     
 public:
+    enum SortKey {
+        SortByName,
+        SortByPhone,
+        SortByEmail
+    };
+    Q_ENUM(SortKey)
+    
     explicit ContactManager(QObject* parent = nullptr);
     ~ContactManager() = default;
     
@@ -25,31 +82,143 @@ public:
     QList<Contact> searchContacts(const QString& query) const;
     Contact* findContact(const QString& name, const QString& phone);
     const Contact* findContact(const QString& name, const QString& phone) const;
+    const Contact* findContactById(int id) const;
+    
+    // Ordered access in the active sort order; every order is maintained
+    // incrementally, so switching order and fetching a page never resorts
+    SortKey sortKey() const;
+    void setSortKey(SortKey key);
+    QList<Contact> getSortedContacts() const;
+    // For views kept in step through contactsChanged(): the sorted contacts,
+    // dropping the changes not yet delivered since the list already has them
+    QList<Contact> resyncSortedContacts();
+    QList<Contact> getContactsPage(int offset, int limit) const;
+    int rowOf(const Contact& contact) const;
+    
+    // Asynchronous variants run on ThreadPool::instance() and report progress
+    // in contacts processed. Use QFuture::then(context, ...) or a QFutureWatcher
+    // to receive results on the calling thread. The manager must outlive them.
+    // The async imports emit contactsImported() from the manager's thread
+    // once its event loop runs, not from the pool thread.
+    QFuture<QList<Contact>> getAllContactsAsync() const;
+    QFuture<QList<Contact>> searchContactsAsync(const QString& query) const;
+    QFuture<ImportReport> importContactsAsync(const QList<Contact>& contacts);
+    
+    // Streamed bulk import: reader feeds batches to the sink it is given and
+    // reports how far it has got, e.g. bytes of a file. Each batch is
+    // imported as it arrives, so memory stays at one batch whatever the
+    // source size. Progress runs 0..STREAM_PROGRESS_STEPS; cancelling stops
+    // the reader at the next batch. The reader returns false on failure.
+    using BatchSink = std::function<bool(const QList<Contact>&)>;
+    using StreamReader = std::function<bool(const BatchSink& sink,
+                                            const std::function<void(qint64 done, qint64 total)>& progress)>;
+    static constexpr int STREAM_PROGRESS_STEPS = 1000;
+    QFuture<ImportReport> importStreamAsync(const StreamReader& reader);
+    
+    // Field-aware queries (see ContactQuery for the syntax)
+    QList<Contact> query(const ContactQuery& query) const;
+    ContactIndex::QueryPlan planQuery(const ContactQuery& query) const;
+    QString explain(const ContactQuery& query) const;
     
     // Bulk operations
     void clearAllContacts();
     int getContactCount() const;
     bool isEmpty() const;
+    MemoryStats memoryStats() const;
+    
+    // Change tracking for persistence, keyed by contact id. takeDirty()
+    // hands over everything changed since the last call; restoreDirty()
+    // puts it back if writing it out failed. Contacts storage has not seen
+    // yet carry client-side ids that another writer may hold by now, so
+    // they must be inserted without one and renumbered by adoptStoredIds().
+    struct DirtySet {
+        QList<Contact> inserted;    // Not in storage yet
+        QList<Contact> updated;     // Loaded from or written to storage before
+        QList<int> removedIds;      // Only ids storage holds
+        
+        bool isEmpty() const { return inserted.isEmpty() && updated.isEmpty() && removedIds.isEmpty(); }
+    };
+    
+    DirtySet takeDirty();
+    void restoreDirty(const DirtySet& dirty);
+    bool hasUnsavedChanges() const;
+    // After dirty.inserted was written, storedIds[i] being the id storage
+    // gave dirty.inserted[i]: moves each contact to its stored id
+    void adoptStoredIds(const QList<Contact>& inserted, const QList<int>& storedIds);
+    
+    // Applies rows read back from storage without marking them dirty;
+    // contacts with unsaved local changes are left alone, and an unsaved
+    // contact whose id a stored row turns out to hold is renumbered.
+    // Returns the number of contacts inserted or changed.
+    int mergeStoredContacts(const QList<Contact>& contacts);
     
     // Import/Export support
     QList<Contact> getContactsForExport() const;
+    // Visits contacts in name order without copying them, holding the lock
+    // throughout, so writers wait until it returns. Suits FileHandler's
+    // streaming export.
+    bool forEachContact(const std::function<bool(const Contact&)>& visit) const;
     bool importContacts(const QList<Contact>& contacts);
+    ImportReport importContactsBatch(const QList<Contact>& contacts);
+    
+    // Dedup stage: plan against a snapshot of the stored contacts, then
+    // import the survivors and fill gaps in matched existing contacts
+    MergePlan planImport(const QList<Contact>& contacts,
+                         const Deduplicator::Options& options = Deduplicator::Options()) const;
+    ImportReport applyMergePlan(const QList<Contact>& contacts, const MergePlan& plan);
+    static QList<bool> validateContacts(const QList<Contact>& contacts);
     
 public slots:
     void sortContactsByName();
     void sortContactsByPhone();
+    void sortContactsByEmail();
     
 signals:
     void contactAdded(const Contact& contact);
     void contactRemoved(const Contact& contact);
     void contactUpdated(const Contact& oldContact, const Contact& newContact);
     void contactsCleared();
+    void contactsImported(int count, int skipped);
+    void contactsChanged(const QList<ContactChange>& changes);
+    // Followed by a Reset through contactsChanged(); views rebuild on that
+    void sortOrderChanged(ContactManager::SortKey key);
     
 private:
     BST<Contact> m_contacts;
+    ContactIndex m_index;    // Secondary indexes for query planning
+    BST<Contact, ContactPhoneOrder> m_byPhone;  // Secondary sorted views
+    BST<Contact, ContactEmailOrder> m_byEmail;
+    SortKey m_sortKey = SortByName;
     mutable QMutex m_mutex;  // Thread safety
     
     bool isContactDuplicate(const Contact& contact) const;
+    
+    // Storage helpers; must be called with m_mutex held
+    bool storeContact(const Contact& contact);
+    void unstoreContact(const Contact& stored);
+    Contact withUnusedId(const Contact& contact) const;
+    const Contact* storedById(int id) const;
+    void renumberContact(int fromId, int toId);
+    int viewRow(const Contact& contact) const;
+
+    void notifyImported(const ImportReport& report);
+    ImportReport insertValidated(const QList<Contact>& contacts, const QList<bool>& valid, int firstRow);
+    
+    // Change coalescing; record*() must be called with m_mutex held
+    void recordChange(const ContactChange& change);
+    void recordReset();
+    void scheduleFlush();
+    void flushChanges();
+    
+    QList<ContactChange> m_pendingChanges;
+    bool m_flushScheduled = false;
+    
+    // Persistence tracking
+    QHash<int, QString> m_nameById;
+    QHash<int, Contact> m_dirty;
+    QSet<int> m_removedIds;
+    QSet<int> m_storedIds;    // Ids storage holds rows for
+    bool m_tracking = true;
 };
 
 #endif // CONTACTMANAGER_H
@@ -0,0 +1,152 @@
+#include "ContactQuery.h"
+#include <QStringList>
+
+ContactQuery ContactQuery::compile(const QString& text) {
+    ContactQuery query;
+    query.m_text = text;
+
+    const QStringList tokens = tokenize(text);
+    for (const QString& token : tokens) {
+        Term term;
+        QString value = token;
+
+        int colon = token.indexOf(':');
+        if (colon > 0) {
+            QString field = token.left(colon).toLower();
+            if (field == "name") {
+                term.field = NameField;
+            } else if (field == "phone" || field == "tel") {
+                term.field = PhoneField;
+            } else if (field == "email" || field == "mail") {
+                term.field = EmailField;
+            }
+
+            // Unknown prefixes are kept as part of a plain word
+            if (term.field != AnyField) {
+                value = token.mid(colon + 1);
+            }
+        }
+
+        bool prefix = value.endsWith('*');
+        bool suffix = value.startsWith('*');
+        value.remove(QChar('*'));
+
+        if (prefix && !suffix) {
+            term.mode = Prefix;
+        } else if (suffix && !prefix) {
+            term.mode = Suffix;
+        }
+
+        if (term.field == PhoneField) {
+            term.value = digitsOf(value);
+            if (term.value.isEmpty() && !value.isEmpty()) {
+                query.m_error = QString("Phone term '%1' contains no digits").arg(value);
+                query.m_terms.clear();
+                return query;
+            }
+        } else {
+            term.value = value.toLower();
+        }
+
+        // A bare '*' or an empty field value constrains nothing
+        if (!term.value.isEmpty()) {
+            query.m_terms.append(term);
+        }
+    }
+
+    return query;
+}
+
+bool ContactQuery::matches(const Contact& contact) const {
+    if (!isValid()) {
+        return false;
+    }
+
+    for (const Term& term : m_terms) {
+        if (!matchesTerm(term, contact)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ContactQuery::matchesTerm(const Term& term, const Contact& contact) {
+    switch (term.field) {
+        case NameField:
+            return matchText(contact.getName(), term);
+        case PhoneField:
+            return matchText(digitsOf(contact.getPhone()), term);
+        case EmailField:
+            return matchText(contact.getEmail(), term);
+        case AnyField:
+            return matchText(contact.getName(), term) ||
+                   matchText(contact.getPhone(), term) ||
+                   matchText(contact.getEmail(), term);
+    }
+    return false;
+}
+
+QString ContactQuery::fieldName(Field field) {
+    switch (field) {
+        case NameField: return "name";
+        case PhoneField: return "phone";
+        case EmailField: return "email";
+        default: return "any";
+    }
+}
+
+QString ContactQuery::modeName(MatchMode mode) {
+    switch (mode) {
+        case Prefix: return "prefix";
+        case Suffix: return "suffix";
+        default: return "contains";
+    }
+}
+
+QString ContactQuery::digitsOf(const QString& text) {
+    QString digits;
+    digits.reserve(text.size());
+    for (QChar ch : text) {
+        if (ch.isDigit()) {
+            digits.append(ch);
+        }
+    }
+    return digits;
+}
+
+QStringList ContactQuery::tokenize(const QString& text) {
+    QStringList tokens;
+    QString current;
+    bool inQuotes = false;
+
+    for (QChar ch : text) {
+        if (ch == '"') {
+            inQuotes = !inQuotes;
+        } else if (ch.isSpace() && !inQuotes) {
+            if (!current.isEmpty()) {
+                tokens.append(current);
+                current.clear();
+            }
+        } else {
+            current.append(ch);
+        }
+    }
+
+    if (!current.isEmpty()) {
+        tokens.append(current);
+    }
+
+    return tokens;
+}
+
+bool ContactQuery::matchText(const QString& text, const Term& term) {
+    switch (term.mode) {
+        case Prefix:
+            return text.startsWith(term.value, Qt::CaseInsensitive);
+        case Suffix:
+            return text.endsWith(term.value, Qt::CaseInsensitive);
+        case Contains:
+            return text.contains(term.value, Qt::CaseInsensitive);
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#ifndef CONTACTQUERY_H
+#define CONTACTQUERY_H
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include "Contact.h"
+
+// Compiled field-aware query, e.g. "name:ali phone:555* email:@corp.com".
+// All terms must match. A trailing '*' makes a term a prefix match and a
+// leading '*' a suffix match; otherwise the term is a substring match.
+// Words without a known field prefix are matched against every field.
+// A compiled query can be reused across calls.
+class ContactQuery {
+public:
+    enum Field {
+        AnyField,
+        NameField,
+        PhoneField,
+        EmailField
+    };
+
+    enum MatchMode {
+        Contains,
+        Prefix,
+        Suffix
+    };
+
+    struct Term {
+        Field field = AnyField;
+        MatchMode mode = Contains;
+        QString value;  // Lowercased; digits only for PhoneField
+    };
+
+    ContactQuery() = default;
+
+    static ContactQuery compile(const QString& text);
+
+    QString text() const { return m_text; }
+    const QList<Term>& terms() const { return m_terms; }
+    bool isEmpty() const { return m_terms.isEmpty(); }
+    bool isValid() const { return m_error.isEmpty(); }
+    QString errorString() const { return m_error; }
+
+    // Evaluation
+    bool matches(const Contact& contact) const;
+    static bool matchesTerm(const Term& term, const Contact& contact);
+
+    // Utility methods
+    static QString fieldName(Field field);
+    static QString modeName(MatchMode mode);
+    static QString digitsOf(const QString& text);
+
+private:
+    static QStringList tokenize(const QString& text);
+    static bool matchText(const QString& text, const Term& term);
+
+    QString m_text;
+    QList<Term> m_terms;
+    QString m_error;
+};
+
+#endif // CONTACTQUERY_H
@@ -0,0 +1,275 @@
+#include "CsvReader.h"
+#include <QtAlgorithms>
+#include <QDebug>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHONEBOOK_CSV_SSE2
+#include <emmintrin.h>
+#endif
+
+QString CsvField::toString() const {
+    if (!escapedQuotes) {
+        return QString::fromUtf8(data, size);
+    }
+
+    QByteArray unescaped;
+    unescaped.reserve(size);
+    for (qsizetype i = 0; i < size; ++i) {
+        unescaped.append(data[i]);
+        if (data[i] == '"' && i + 1 < size && data[i + 1] == '"') {
+            ++i;
+        }
+    }
+    return QString::fromUtf8(unescaped);
+}
+
+CsvReader::CsvReader(const QString& filePath)
+    : CsvReader(filePath, Options()) {
+}
+
+CsvReader::CsvReader(const QString& filePath, const Options& options)
+    : m_options(options)
+    , m_file(filePath)
+    , m_mapped(nullptr)
+    , m_begin(nullptr)
+    , m_pos(nullptr)
+    , m_end(nullptr)
+    , m_open(false)
+    , m_simd(options.useSimd && simdAvailable())
+    , m_malformed(0) {
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open file for reading:" << filePath;
+        return;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize > 0) {
+        m_mapped = m_file.map(0, fileSize);
+    }
+    if (m_mapped) {
+        setInput(reinterpret_cast<const char*>(m_mapped), fileSize);
+    } else {
+        // Empty files and devices that cannot be mapped
+        m_fallback = m_file.readAll();
+        setInput(m_fallback.constData(), m_fallback.size());
+    }
+    m_open = true;
+}
+
+CsvReader::CsvReader(QByteArrayView data)
+    : CsvReader(data, Options()) {
+}
+
+CsvReader::CsvReader(QByteArrayView data, const Options& options)
+    : m_options(options)
+    , m_mapped(nullptr)
+    , m_begin(nullptr)
+    , m_pos(nullptr)
+    , m_end(nullptr)
+    , m_open(true)
+    , m_simd(options.useSimd && simdAvailable())
+    , m_malformed(0) {
+    setInput(data.data(), data.size());
+}
+
+CsvReader::~CsvReader() {
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+    }
+}
+
+bool CsvReader::isOpen() const {
+    return m_open;
+}
+
+bool CsvReader::simdAvailable() {
+#ifdef PHONEBOOK_CSV_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+qsizetype CsvReader::countQuotes(QByteArrayView data, bool useSimd) {
+    const char* p = data.data();
+    const char* end = p + data.size();
+    qsizetype count = 0;
+#ifdef PHONEBOOK_CSV_SSE2
+    if (useSimd) {
+        const __m128i quotes = _mm_set1_epi8('"');
+        while (end - p >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            count += qPopulationCount(static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quotes))));
+            p += 16;
+        }
+    }
+#else
+    Q_UNUSED(useSimd);
+#endif
+    for (; p < end; ++p) {
+        count += *p == '"';
+    }
+    return count;
+}
+
+qsizetype CsvReader::nextRecordStart(QByteArrayView data, qsizetype from, bool inQuotes) {
+    for (qsizetype i = from; i < data.size(); ++i) {
+        if (data[i] == '"') {
+            inQuotes = !inQuotes;
+        } else if (data[i] == '\n' && !inQuotes) {
+            return i + 1;
+        }
+    }
+    return data.size();
+}
+
+void CsvReader::setInput(const char* data, qsizetype size) {
+    m_begin = data;
+    m_pos = data;
+    m_end = data + size;
+
+    if (m_options.skipBom && size >= 3 && qstrncmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        m_pos += 3;
+    }
+}
+
+bool CsvReader::readRecord() {
+    while (m_pos < m_end) {
+        parseRecord();
+
+        // Blank lines carry no record
+        if (m_fields.size() > 1 || !m_fields[0].isEmpty() || m_fields[0].quoted) {
+            return true;
+        }
+    }
+    m_fields.clear();
+    return false;
+}
+
+int CsvReader::fieldCount() const {
+    return m_fields.size();
+}
+
+const CsvField& CsvReader::field(int index) const {
+    return m_fields[index];
+}
+
+QByteArrayView CsvReader::data() const {
+    return QByteArrayView(m_begin, m_end - m_begin);
+}
+
+qsizetype CsvReader::position() const {
+    return m_pos - m_begin;
+}
+
+qsizetype CsvReader::size() const {
+    return m_end - m_begin;
+}
+
+qint64 CsvReader::malformedRecords() const {
+    return m_malformed;
+}
+
+void CsvReader::parseRecord() {
+    m_fields.clear();
+    bool malformed = false;
+    const char* p = m_pos;
+
+    for (;;) {
+        CsvField field;
+
+        if (p < m_end && *p == '"') {
+            // Quoted: runs to the first quote that is not doubled, across
+            // delimiters and line breaks
+            field.quoted = true;
+            field.data = ++p;
+            for (;;) {
+                p = findQuote(p);
+                if (p + 1 < m_end && p[1] == '"') {
+                    field.escapedQuotes = true;
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            field.size = p - field.data;
+
+            if (p == m_end) {
+                malformed = true;    // Unterminated; take the rest of the input
+            } else if (++p < m_end && *p != m_options.delimiter && *p != '\n' && *p != '\r') {
+                // Text after the closing quote is not RFC 4180; drop it
+                malformed = true;
+                p = findFieldEnd(p);
+            }
+        } else {
+            field.data = p;
+            p = findFieldEnd(p);
+            field.size = p - field.data;
+        }
+
+        m_fields.append(field);
+
+        if (p < m_end && *p == m_options.delimiter) {
+            ++p;
+            continue;
+        }
+        if (p < m_end && *p == '\r') {
+            ++p;
+        }
+        if (p < m_end && *p == '\n') {
+            ++p;
+        }
+        break;
+    }
+
+    m_pos = p;
+    if (malformed) {
+        ++m_malformed;
+    }
+}
+
+const char* CsvReader::findFieldEnd(const char* p) const {
+    const char delimiter = m_options.delimiter;
+#ifdef PHONEBOOK_CSV_SSE2
+    if (m_simd) {
+        const __m128i delimiters = _mm_set1_epi8(delimiter);
+        const __m128i newlines = _mm_set1_epi8('\n');
+        const __m128i returns = _mm_set1_epi8('\r');
+        while (m_end - p >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delimiters),
+                                                           _mm_cmpeq_epi8(chunk, newlines)),
+                                              _mm_cmpeq_epi8(chunk, returns));
+            const int mask = _mm_movemask_epi8(hits);
+            if (mask) {
+                return p + qCountTrailingZeroBits(static_cast<quint32>(mask));
+            }
+            p += 16;
+        }
+    }
+#endif
+    while (p < m_end && *p != delimiter && *p != '\n' && *p != '\r') {
+        ++p;
+    }
+    return p;
+}
+
+const char* CsvReader::findQuote(const char* p) const {
+#ifdef PHONEBOOK_CSV_SSE2
+    if (m_simd) {
+        const __m128i quotes = _mm_set1_epi8('"');
+        while (m_end - p >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quotes));
+            if (mask) {
+                return p + qCountTrailingZeroBits(static_cast<quint32>(mask));
+            }
+            p += 16;
+        }
+    }
+#endif
+    while (p < m_end && *p != '"') {
+        ++p;
+    }
+    return p;
+}
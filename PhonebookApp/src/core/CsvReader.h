@@ -0,0 +1,91 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QString>
+#include <QVarLengthArray>
+
+// One field of the current record, pointing into the reader's buffer. Only
+// valid until the next readRecord() call.
+struct CsvField {
+    const char* data = nullptr;
+    qsizetype size = 0;
+    bool quoted = false;
+    bool escapedQuotes = false;    // Holds "" pairs that toString() collapses
+
+    QByteArrayView view() const { return QByteArrayView(data, size); }
+    bool isEmpty() const { return size == 0; }
+    QString toString() const;
+};
+
+// RFC 4180 reader over a memory-mapped file, or any byte range. Handles
+// quoted fields with embedded delimiters, doubled quotes and line breaks,
+// and CRLF or LF record ends. Fields are views into the mapping, so nothing
+// is allocated per field until a caller converts one. Delimiters, quotes
+// and line breaks are found 16 bytes at a time with SSE2 where the target
+// has it, and byte by byte otherwise.
+class CsvReader {
+public:
+    struct Options {
+        char delimiter = ',';
+        bool useSimd = true;     // Ignored where SSE2 is not available
+        bool skipBom = true;
+    };
+
+    explicit CsvReader(const QString& filePath);
+    CsvReader(const QString& filePath, const Options& options);
+    // Reads a byte range owned by the caller, e.g. one chunk of a mapped file
+    explicit CsvReader(QByteArrayView data);
+    CsvReader(QByteArrayView data, const Options& options);
+    ~CsvReader();
+
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+
+    bool isOpen() const;
+
+    // Advances to the next non-blank record; false at the end of the input
+    bool readRecord();
+    int fieldCount() const;
+    const CsvField& field(int index) const;
+
+    QByteArrayView data() const;   // The whole input, e.g. the mapping
+    qsizetype position() const;    // Bytes consumed so far
+    qsizetype size() const;
+    qint64 malformedRecords() const;    // Stray quotes or unterminated quoted fields
+
+    static bool simdAvailable();
+
+    // Helpers for splitting one input into chunks that parse independently.
+    // In well-formed CSV the parity of the quotes before a point tells
+    // whether it lies inside a quoted field, doubled quotes included, so
+    // chunk boundaries can be fixed from per-chunk quote counts.
+    static qsizetype countQuotes(QByteArrayView data, bool useSimd = true);
+    // Offset just past the first line break at or after from that is not
+    // inside a quoted field, or data.size() if there is none
+    static qsizetype nextRecordStart(QByteArrayView data, qsizetype from, bool inQuotes);
+
+private:
+    void setInput(const char* data, qsizetype size);
+    void parseRecord();
+    const char* findFieldEnd(const char* p) const;
+    const char* findQuote(const char* p) const;
+
+    Options m_options;
+    QFile m_file;
+    uchar* m_mapped;
+    QByteArray m_fallback;    // For devices that cannot be mapped
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    bool m_open;
+    bool m_simd;
+    qint64 m_malformed;
+
+    QVarLengthArray<CsvField, 8> m_fields;
+};
+
+#endif // CSVREADER_H
@@ -0,0 +1,443 @@
+#include "Deduplicator.h"
+#include "BloomFilter.h"
+#include "ThreadPool.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringView>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+    // Below this size key extraction is cheaper on the calling thread
+    const int PARALLEL_KEY_THRESHOLD = 1024;
+    const int LSH_ROWS = Deduplicator::MINHASH_SIZE / Deduplicator::LSH_BANDS;
+
+    quint64 mix64(quint64 x) {
+        // splitmix64 finalizer
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    const std::array<quint64, Deduplicator::MINHASH_SIZE>& minHashSeeds() {
+        static const std::array<quint64, Deduplicator::MINHASH_SIZE> seeds = []() {
+            std::array<quint64, Deduplicator::MINHASH_SIZE> values;
+            quint64 state = 0x2545f4914f6cdd1dULL;
+            for (quint64& value : values) {
+                state += 0x9e3779b97f4a7c15ULL;
+                value = mix64(state);
+            }
+            return values;
+        }();
+        return seeds;
+    }
+
+    class UnionFind {
+    public:
+        int add() {
+            m_parent.push_back(static_cast<int>(m_parent.size()));
+            m_size.push_back(1);
+            return m_parent.back();
+        }
+
+        void resize(int count) {
+            while (static_cast<int>(m_parent.size()) < count) {
+                add();
+            }
+        }
+
+        int find(int node) {
+            while (m_parent[node] != node) {
+                m_parent[node] = m_parent[m_parent[node]];
+                node = m_parent[node];
+            }
+            return node;
+        }
+
+        void unite(int a, int b) {
+            a = find(a);
+            b = find(b);
+            if (a == b) {
+                return;
+            }
+            if (m_size[a] < m_size[b]) {
+                std::swap(a, b);
+            }
+            m_parent[b] = a;
+            m_size[a] += m_size[b];
+        }
+
+        int sizeOf(int node) { return m_size[find(node)]; }
+
+    private:
+        std::vector<int> m_parent;
+        std::vector<int> m_size;
+    };
+}
+
+int MergePlan::duplicateRows() const {
+    int count = 0;
+    for (const Group& group : groups) {
+        if (!group.needsReview()) {
+            count += group.rows.size() - (group.existingIndex < 0 ? 1 : 0);
+        }
+    }
+    return count;
+}
+
+QList<Contact> MergePlan::contactsToImport(const QList<Contact>& incoming) const {
+    QHash<int, const Contact*> mergedByFirstRow;
+    for (const Group& group : groups) {
+        if (!group.needsReview() && group.existingIndex < 0) {
+            mergedByFirstRow.insert(group.rows.first(), &group.merged);
+        }
+    }
+
+    QList<Contact> contacts;
+    for (int row : rowsToImport()) {
+        const Contact* merged = mergedByFirstRow.value(row);
+        contacts.append(merged ? *merged : incoming[row]);
+    }
+    return contacts;
+}
+
+QList<int> MergePlan::rowsToImport() const {
+    QList<int> rows = uniqueRows;
+    for (const Group& group : groups) {
+        if (group.needsReview()) {
+            rows.append(group.rows);
+        } else if (group.existingIndex < 0) {
+            rows.append(group.rows.first());
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+Deduplicator::Deduplicator(const Options& options) : m_options(options) {}
+
+MergePlan Deduplicator::plan(const QList<Contact>& incoming, const QList<Contact>& existing) const {
+    QElapsedTimer timer;
+    timer.start();
+
+    MergePlan plan;
+    plan.total = incoming.size();
+
+    const int rowCount = incoming.size();
+    const QList<Keys> keys = keysFor(incoming, m_options.similarNames);
+
+    // Prefixed so keys of different fields never collide
+    auto keyList = [](const Keys& k) {
+        std::array<std::pair<QString, int>, 3> list = {{
+            {k.name.isEmpty() ? QString() : "n:" + k.name, MergePlan::SameName},
+            {k.phone.isEmpty() ? QString() : "p:" + k.phone, MergePlan::SamePhone},
+            {k.email.isEmpty() ? QString() : "e:" + k.email, MergePlan::SameEmail}
+        }};
+        return list;
+    };
+
+    // Pass 1: a key seen twice may be a repeat; everything else is unique
+    // within the batch and never enters a hash table
+    BloomFilter seen(rowCount * 3);
+    BloomFilter repeated(std::max(rowCount / 4, 64));
+    for (const Keys& k : keys) {
+        for (const auto& [key, reason] : keyList(k)) {
+            if (!key.isEmpty() && seen.testAndAdd(key)) {
+                repeated.add(key);
+            }
+        }
+    }
+
+    // Existing contacts are joined through a second filter so only the keys
+    // that probably match are resolved against them
+    QList<Keys> existingKeys;
+    std::unique_ptr<BloomFilter> stored;
+    if (!existing.isEmpty()) {
+        existingKeys = keysFor(existing, false);
+        stored = std::make_unique<BloomFilter>(existing.size() * 3);
+        for (const Keys& k : existingKeys) {
+            for (const auto& [key, reason] : keyList(k)) {
+                if (!key.isEmpty()) {
+                    stored->add(key);
+                }
+            }
+        }
+    }
+
+    UnionFind sets;
+    sets.resize(rowCount);
+    QList<QPair<int, int>> links;    // (node, reason) for every union
+
+    // Pass 2: resolve probable repeats within the batch, remember probable
+    // matches against existing contacts
+    QHash<QString, int> firstRowByKey;
+    QHash<QString, int> existingByKey;
+    QList<std::pair<int, std::pair<QString, int>>> storeProbes;
+
+    for (int row = 0; row < rowCount; ++row) {
+        for (const auto& [key, reason] : keyList(keys[row])) {
+            if (key.isEmpty()) {
+                continue;
+            }
+
+            const bool inBatch = repeated.mightContain(key);
+            const bool inStore = stored && stored->mightContain(key);
+            if (!inBatch && !inStore) {
+                plan.bloomSkipped++;
+                continue;
+            }
+
+            if (inBatch) {
+                auto it = firstRowByKey.constFind(key);
+                if (it == firstRowByKey.constEnd()) {
+                    firstRowByKey.insert(key, row);
+                } else {
+                    sets.unite(row, it.value());
+                    links.append({row, reason});
+                }
+            }
+
+            if (inStore) {
+                existingByKey.insert(key, -1);
+                storeProbes.append({row, {key, reason}});
+            }
+        }
+    }
+
+    // Pass 3: one scan over existing contacts fills in the probed keys
+    for (int i = 0; i < existingKeys.size() && !existingByKey.isEmpty(); ++i) {
+        for (const auto& [key, reason] : keyList(existingKeys[i])) {
+            auto it = existingByKey.find(key);
+            if (!key.isEmpty() && it != existingByKey.end() && it.value() < 0) {
+                it.value() = i;
+            }
+        }
+    }
+
+    QHash<int, int> nodeByExisting;
+    QHash<int, int> existingByNode;
+    for (const auto& [row, probe] : storeProbes) {
+        const int index = existingByKey.value(probe.first, -1);
+        if (index < 0) {
+            continue;    // Bloom false positive
+        }
+
+        auto it = nodeByExisting.constFind(index);
+        if (it == nodeByExisting.constEnd()) {
+            it = nodeByExisting.insert(index, sets.add());
+            existingByNode.insert(it.value(), index);
+        }
+        sets.unite(row, it.value());
+        links.append({row, probe.second});
+    }
+
+    // Near-duplicate names: rows whose signatures agree on a whole band are
+    // compared with the first row seen in that bucket
+    if (m_options.similarNames) {
+        QHash<quint64, int> bucketLeader;
+        for (int row = 0; row < rowCount; ++row) {
+            const Keys& k = keys[row];
+            if (k.name.isEmpty()) {
+                continue;
+            }
+
+            for (int band = 0; band < LSH_BANDS; ++band) {
+                quint64 bucket = mix64(static_cast<quint64>(band) + 1);
+                for (int r = 0; r < LSH_ROWS; ++r) {
+                    bucket = mix64(bucket ^ k.signature[band * LSH_ROWS + r]);
+                }
+
+                auto it = bucketLeader.constFind(bucket);
+                if (it == bucketLeader.constEnd()) {
+                    bucketLeader.insert(bucket, row);
+                    continue;
+                }
+
+                const int leader = it.value();
+                if (sets.find(leader) == sets.find(row)) {
+                    continue;
+                }
+
+                plan.candidatePairs++;
+                if (keys[leader].name != k.name &&
+                    similarity(keys[leader].signature, k.signature) >= m_options.nameSimilarity) {
+                    sets.unite(row, leader);
+                    links.append({row, MergePlan::SimilarName});
+                }
+            }
+        }
+    }
+
+    // Collect groups in order of their first row
+    QHash<int, int> reasonsByRoot;
+    for (const auto& [node, reason] : links) {
+        reasonsByRoot[sets.find(node)] |= reason;
+    }
+
+    QHash<int, int> groupByRoot;
+    for (int row = 0; row < rowCount; ++row) {
+        const int root = sets.find(row);
+        if (sets.sizeOf(root) == 1) {
+            plan.uniqueRows.append(row);
+            continue;
+        }
+
+        auto it = groupByRoot.constFind(root);
+        if (it == groupByRoot.constEnd()) {
+            it = groupByRoot.insert(root, plan.groups.size());
+            MergePlan::Group group;
+            group.reasons = reasonsByRoot.value(root);
+            plan.groups.append(group);
+        }
+        plan.groups[it.value()].rows.append(row);
+    }
+
+    for (auto it = existingByNode.constBegin(); it != existingByNode.constEnd(); ++it) {
+        MergePlan::Group& group = plan.groups[groupByRoot.value(sets.find(it.key()))];
+        if (group.existingIndex < 0 || it.value() < group.existingIndex) {
+            group.existingIndex = it.value();
+        }
+    }
+
+    // Survivor: the stored contact or the first row, with a missing email
+    // taken from the first row that has one
+    for (MergePlan::Group& group : plan.groups) {
+        group.merged = group.existingIndex >= 0 ? existing[group.existingIndex] : incoming[group.rows.first()];
+        if (group.merged.getEmail().isEmpty()) {
+            for (int row : group.rows) {
+                if (!incoming[row].getEmail().isEmpty()) {
+                    group.merged.setEmail(incoming[row].getEmail());
+                    group.updatesExisting = group.existingIndex >= 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    plan.elapsedMs = timer.elapsed();
+    return plan;
+}
+
+QString Deduplicator::phoneKey(const QString& phone) const {
+    const QString trimmed = phone.trimmed();
+    bool international = trimmed.startsWith('+');
+
+    QString digits;
+    digits.reserve(trimmed.size());
+    for (QChar c : trimmed) {
+        if (c.isDigit()) {
+            digits.append(c);
+        }
+    }
+
+    if (!international && digits.startsWith("00")) {
+        international = true;
+        digits.remove(0, 2);
+    }
+
+    // Home-country numbers collapse to their national form; others keep a
+    // marker so "+44 20..." never equals a national "20..."
+    if (international) {
+        if (!m_options.homeCountryCode.isEmpty() && digits.startsWith(m_options.homeCountryCode)) {
+            digits.remove(0, m_options.homeCountryCode.size());
+        } else {
+            digits.prepend('+');
+        }
+    }
+
+    return digits.size() < m_options.minPhoneDigits ? QString() : digits;
+}
+
+QString Deduplicator::emailKey(const QString& email) {
+    const QString lowered = email.trimmed().toLower();
+    const int at = lowered.lastIndexOf('@');
+    if (at <= 0 || at == lowered.size() - 1) {
+        return QString();
+    }
+
+    QString local = lowered.left(at);
+    QString domain = lowered.mid(at + 1);
+
+    // Sub-addresses deliver to the same mailbox
+    const int plus = local.indexOf('+');
+    if (plus > 0) {
+        local.truncate(plus);
+    }
+
+    if (domain == "gmail.com" || domain == "googlemail.com") {
+        local.remove('.');
+        domain = "gmail.com";
+    }
+
+    return local + '@' + domain;
+}
+
+QString Deduplicator::nameKey(const QString& name) {
+    // Token order is ignored so "Smith, John" equals "John Smith"
+    QString cleaned = name.toLower();
+    for (QChar& c : cleaned) {
+        if (!c.isLetterOrNumber()) {
+            c = ' ';
+        }
+    }
+
+    QStringList tokens = cleaned.split(' ', Qt::SkipEmptyParts);
+    std::sort(tokens.begin(), tokens.end());
+    return tokens.join(' ');
+}
+
+Deduplicator::Signature Deduplicator::signatureOf(const QString& normalizedName) {
+    Signature signature;
+    signature.fill(std::numeric_limits<quint32>::max());
+
+    const QString text = ' ' + normalizedName + ' ';
+    const auto& seeds = minHashSeeds();
+    const int shingles = std::max<int>(1, text.size() - 2);
+
+    for (int i = 0; i < shingles; ++i) {
+        const quint64 base = qHash(QStringView(text).mid(i, 3));
+        for (int h = 0; h < MINHASH_SIZE; ++h) {
+            const quint32 value = static_cast<quint32>(mix64(base ^ seeds[h]) >> 32);
+            signature[h] = std::min(signature[h], value);
+        }
+    }
+
+    return signature;
+}
+
+double Deduplicator::similarity(const Signature& a, const Signature& b) {
+    int equal = 0;
+    for (int i = 0; i < MINHASH_SIZE; ++i) {
+        equal += a[i] == b[i] ? 1 : 0;
+    }
+    return static_cast<double>(equal) / MINHASH_SIZE;
+}
+
+QList<Deduplicator::Keys> Deduplicator::keysFor(const QList<Contact>& contacts, bool withSignatures) const {
+    auto extract = [this, withSignatures](const Contact& contact) {
+        Keys keys;
+        keys.name = nameKey(contact.getName());
+        keys.phone = phoneKey(contact.getPhone());
+        keys.email = emailKey(contact.getEmail());
+        if (withSignatures && !keys.name.isEmpty()) {
+            keys.signature = signatureOf(keys.name);
+        }
+        return keys;
+    };
+
+    if (contacts.size() < PARALLEL_KEY_THRESHOLD) {
+        QList<Keys> result;
+        result.reserve(contacts.size());
+        for (const Contact& contact : contacts) {
+            result.append(extract(contact));
+        }
+        return result;
+    }
+
+    return ThreadPool::instance().blockingMapped(contacts, extract);
+}
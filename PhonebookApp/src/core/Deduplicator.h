@@ -0,0 +1,99 @@
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <array>
+#include "Contact.h"
+
+// Result of a dedup pass over an import batch. Rows that describe the same
+// person are grouped; a group either merges into a contact that is already
+// stored (existingIndex >= 0) or collapses into one new contact. Groups
+// linked by a similar name alone are left for review: their rows are
+// imported as they are.
+struct MergePlan {
+    enum Reason {
+        SameName = 0x1,
+        SamePhone = 0x2,
+        SameEmail = 0x4,
+        SimilarName = 0x8    // Near-duplicate name only; worth a review
+    };
+
+    struct Group {
+        QList<int> rows;         // Incoming rows, ascending
+        int existingIndex = -1;  // Index into the existing contacts, or -1
+        int reasons = 0;         // OR of Reason flags that linked the group
+        Contact merged;          // Survivor with gaps filled from the other rows
+        bool updatesExisting = false;
+
+        bool needsReview() const { return reasons == SimilarName; }
+    };
+
+    QList<Group> groups;
+    QList<int> uniqueRows;       // Rows with no duplicate anywhere
+
+    // Statistics
+    int total = 0;
+    int bloomSkipped = 0;        // Keys ruled out without a hash probe
+    int candidatePairs = 0;      // LSH candidates checked for similarity
+    qint64 elapsedMs = 0;
+
+    int duplicateRows() const;
+
+    // Contacts to insert: unique rows, the rows of groups that need review,
+    // and one survivor per other group that does not already exist
+    QList<Contact> contactsToImport(const QList<Contact>& incoming) const;
+    // Incoming row of each contact in contactsToImport(), ascending
+    QList<int> rowsToImport() const;
+};
+
+// Dedup stage for imports. Phone numbers, emails and names are normalized
+// into hashable keys; a Bloom filter over the keys skips definite
+// non-duplicates so only probable repeats reach the hash tables, and names
+// are clustered by MinHash signatures bucketed with LSH to catch spelling
+// variants. Linked rows are grouped with union-find.
+class Deduplicator {
+public:
+    struct Options {
+        QString homeCountryCode = "1";   // Stripped from "+1 ..." and "001 ..."
+        int minPhoneDigits = 7;          // Shorter numbers are not used as keys
+        bool similarNames = true;
+        double nameSimilarity = 0.6;     // Minimum estimated Jaccard of name shingles
+    };
+
+    static const int MINHASH_SIZE = 32;
+    static const int LSH_BANDS = 8;     // 8 bands of 4 rows: ~0.6 Jaccard threshold
+
+    using Signature = std::array<quint32, MINHASH_SIZE>;
+
+    Deduplicator() = default;
+    explicit Deduplicator(const Options& options);
+
+    // Groups duplicates within incoming and against existing. Only exact keys
+    // are matched against existing contacts; near-duplicate names are
+    // clustered within the incoming batch.
+    MergePlan plan(const QList<Contact>& incoming, const QList<Contact>& existing = QList<Contact>()) const;
+
+    // Normalized keys; empty when the field cannot be used as a key
+    QString phoneKey(const QString& phone) const;
+    static QString emailKey(const QString& email);
+    static QString nameKey(const QString& name);
+
+    static Signature signatureOf(const QString& normalizedName);
+    static double similarity(const Signature& a, const Signature& b);
+
+private:
+    struct Keys {
+        QString name;
+        QString phone;
+        QString email;
+        Signature signature;
+    };
+
+    QList<Keys> keysFor(const QList<Contact>& contacts, bool withSignatures) const;
+
+    Options m_options;
+};
+
+#endif // DEDUPLICATOR_H
@@ -1,13 +1,17 @@
 #include "FileHandler.h"
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
+#include "CsvReader.h"
+#include "JsonPullParser.h"
+#include "JsonStreamWriter.h"
+#include "ThreadPool.h"
+#include <QBuffer>
 #include <QFile>
 #include <QTextStream>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QFileInfo>
 #include <QDebug>
+#include <charconv>
+#include <cstring>
 
 FileHandler::FileHandler(QObject* parent) : QObject(parent) {
 }
@@ -34,26 +38,31 @@ bool FileHandler::exportContacts(const QList<Contact>& contacts, const QString&
 }
 
 bool FileHandler::exportToJson(const QList<Contact>& contacts, const QString& filePath) {
-    QJsonArray jsonArray;
-    
-    for (const Contact& contact : contacts) {
-        QJsonObject contactObject;
-        contactObject["id"] = contact.getId();
-        contactObject["name"] = contact.getName();
-        contactObject["phone"] = contact.getPhone();
-        contactObject["email"] = contact.getEmail();
-        jsonArray.append(contactObject);
-    }
-    
-    QJsonDocument document(jsonArray);
-    
+    return exportToJson(rangeSource(contacts.cbegin(), contacts.cend()), filePath);
+}
+
+bool FileHandler::exportToJson(const ContactSource& source, const QString& filePath) {
+    // JsonStreamWriter does the buffering, so QFile's own buffer would only
+    // add a copy
     QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
         qWarning() << "Failed to open file for writing:" << filePath;
         return false;
     }
     
-    file.write(document.toJson());
+    JsonStreamWriter writer(&file);
+    writer.beginArray();
+    const bool sourceOk = source([&writer](const Contact& contact) {
+        writer.writeContact(contact);
+        return !writer.hasError();
+    });
+    writer.endArray();
+    
+    if (!sourceOk || writer.hasError()) {
+        qWarning() << "JSON export failed after" << writer.contactsWritten() << "contacts:" << filePath;
+        file.remove();
+        return false;
+    }
     return true;
 }
 
@@ -134,95 +143,473 @@ QList<Contact> FileHandler::importContacts(const QString& filePath, FileFormat f
 QList<Contact> FileHandler::importFromJson(const QString& filePath) {
     QList<Contact> contacts;
     
+    const bool complete = importFromJson(filePath, [&contacts](const QList<Contact>& batch) {
+        for (const Contact& contact : batch) {
+            if (contact.isValid()) {
+                contacts.append(contact);
+            }
+        }
+        return true;
+    });
+    
+    return complete ? contacts : QList<Contact>();
+}
+
+bool FileHandler::importFromJson(const QString& filePath, const ContactBatchSink& sink, int batchSize) {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "Failed to open file for reading:" << filePath;
-        return contacts;
+        return false;
     }
     
-    QByteArray data = file.readAll();
-    QJsonDocument document = QJsonDocument::fromJson(data);
+    const qint64 totalBytes = file.size();
+    JsonPullParser parser(&file);
     
-    if (!document.isArray()) {
+    if (parser.next() != JsonPullParser::BeginArray) {
         qWarning() << "Invalid JSON format - expected array";
-        return contacts;
+        return false;
     }
     
-    QJsonArray jsonArray = document.array();
-    for (const QJsonValue& value : jsonArray) {
-        if (!value.isObject()) {
-            continue;
+    return streamJsonElements(parser, sink, batchSize, 0, totalBytes);
+}
+
+bool FileHandler::streamJsonElements(JsonPullParser& parser, const ContactBatchSink& sink, int batchSize,
+                                     qint64 offset, qint64 totalBytes) {
+    QList<Contact> batch;
+    batch.reserve(batchSize);
+    auto deliver = [&]() {
+        const bool more = batch.isEmpty() || sink(batch);
+        batch.clear();
+        emit importProgress(offset + parser.bytesConsumed(), totalBytes);
+        return more;
+    };
+    
+    for (;;) {
+        switch (parser.next()) {
+            case JsonPullParser::BeginObject: {
+                Contact contact;
+                if (readJsonContact(parser, contact)) {
+                    batch.append(contact);
+                }
+                break;
+            }
+            case JsonPullParser::BeginArray:
+                parser.skipValue();    // Not a contact
+                break;
+            case JsonPullParser::EndArray:
+                // Only trailing whitespace may follow the array
+                if (parser.next() != JsonPullParser::EndOfInput) {
+                    qWarning() << "JSON parsing error:" << parser.errorString();
+                    return false;
+                }
+                return deliver();
+            case JsonPullParser::EndOfInput:
+                // Only after beginInsideArray(): the input stopped between elements
+                qWarning() << "JSON parsing error: the array is not closed";
+                deliver();
+                return false;
+            case JsonPullParser::Invalid:
+                qWarning() << "JSON parsing error:" << parser.errorString();
+                deliver();
+                return false;
+            default:
+                break;    // Scalars in the array are skipped
         }
         
-        QJsonObject obj = value.toObject();
-        Contact contact(obj["name"].toString(),
-                       obj["phone"].toString(),
-                       obj["email"].toString());
-        
-        if (obj.contains("id")) {
-            contact.setId(obj["id"].toInt());
+        if (batch.size() >= batchSize && !deliver()) {
+            return false;
         }
+    }
+}
+
+bool FileHandler::readJsonContact(JsonPullParser& parser, Contact& contact) {
+    QString name, phone, email;
+    qint64 id = 0;
+    bool hasId = false;
+    
+    while (parser.next() == JsonPullParser::Key) {
+        const QString key = parser.stringValue();
+        const JsonPullParser::Token value = parser.next();
         
-        if (contact.isValid()) {
-            contacts.append(contact);
+        if (value == JsonPullParser::String) {
+            if (key == QLatin1String("name")) {
+                name = parser.stringValue();
+            } else if (key == QLatin1String("phone")) {
+                phone = parser.stringValue();
+            } else if (key == QLatin1String("email")) {
+                email = parser.stringValue();
+            }
+        } else if (value == JsonPullParser::Number && key == QLatin1String("id")) {
+            id = parser.integerValue();
+            hasId = true;
+        } else if (!parser.skipValue()) {
+            return false;
         }
     }
+    if (parser.token() != JsonPullParser::EndObject) {
+        return false;
+    }
     
-    return contacts;
+    contact = Contact(name, phone, email);
+    if (hasId) {
+        contact.setId(static_cast<int>(id));
+    }
+    return true;
 }
 
 QList<Contact> FileHandler::importFromCsv(const QString& filePath) {
     QList<Contact> contacts;
     
+    importFromCsv(filePath, [&contacts](const QList<Contact>& batch) {
+        for (const Contact& contact : batch) {
+            if (contact.isValid()) {
+                contacts.append(contact);
+            }
+        }
+        return true;
+    });
+    
+    return contacts;
+}
+
+bool FileHandler::importFromCsv(const QString& filePath, const ContactBatchSink& sink, int batchSize) {
+    CsvReader reader(filePath);
+    if (!reader.isOpen()) {
+        return false;
+    }
+    
+    // Skip header line
+    reader.readRecord();
+    
+    const bool more = streamCsvRecords(reader, sink, batchSize, 0, reader.size());
+    
+    if (reader.malformedRecords() > 0) {
+        qWarning() << "CSV import:" << reader.malformedRecords() << "malformed record(s) in" << filePath;
+    }
+    return more;
+}
+
+bool FileHandler::streamCsvRecords(CsvReader& reader, const ContactBatchSink& sink, int batchSize,
+                                   qint64 offset, qint64 totalBytes) {
+    QList<Contact> batch;
+    batch.reserve(batchSize);
+    bool more = true;
+    while (more && reader.readRecord()) {
+        Contact contact;
+        if (readCsvContact(reader, contact)) {
+            batch.append(contact);
+        }
+        
+        if (batch.size() >= batchSize) {
+            more = sink(batch);
+            batch.clear();
+            emit importProgress(offset + reader.position(), totalBytes);
+        }
+    }
+    
+    if (more && !batch.isEmpty()) {
+        more = sink(batch);
+    }
+    emit importProgress(offset + reader.position(), totalBytes);
+    return more;
+}
+
+bool FileHandler::readCsvContact(const CsvReader& reader, Contact& contact) {
+    // ID,Name,Phone[,Email]
+    if (reader.fieldCount() < 3) {
+        return false;
+    }
+    
+    contact = Contact(reader.field(1).toString().trimmed(),
+                      reader.field(2).toString().trimmed(),
+                      reader.fieldCount() > 3 ? reader.field(3).toString().trimmed() : QString());
+    
+    // Set ID if provided; parsed from the raw bytes, no string needed
+    const QByteArrayView idField = reader.field(0).view().trimmed();
+    int id = 0;
+    const auto result = std::from_chars(idField.data(), idField.data() + idField.size(), id);
+    if (!idField.isEmpty() && result.ec == std::errc() && result.ptr == idField.data() + idField.size()) {
+        contact.setId(id);
+    }
+    return true;
+}
+
+QList<Contact> FileHandler::importParallel(const QString& filePath, FileFormat format) {
+    QList<Contact> contacts;
+    
+    const bool complete = importParallel(filePath, format, [&contacts](const QList<Contact>& batch) {
+        for (const Contact& contact : batch) {
+            if (contact.isValid()) {
+                contacts.append(contact);
+            }
+        }
+        return true;
+    });
+    
+    return complete ? contacts : QList<Contact>();
+}
+
+bool FileHandler::importParallel(const QString& filePath, FileFormat format, const ContactBatchSink& sink, int chunks) {
+    auto importSerially = [&]() {
+        if (format == CSV) {
+            return importFromCsv(filePath, sink);
+        }
+        if (format == JSON) {
+            return importFromJson(filePath, sink);
+        }
+        const QList<Contact> contacts = importFromXml(filePath);
+        return contacts.isEmpty() || sink(contacts);
+    };
+    
+    if (format == XML) {
+        return importSerially();
+    }
+    
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "Failed to open file for reading:" << filePath;
-        return contacts;
+        return false;
     }
     
-    QTextStream stream(&file);
-    stream.setEncoding(QStringConverter::Utf8);
+    const qint64 size = file.size();
+    uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (!mapped) {
+        return importSerially();
+    }
     
-    // Skip header line
-    if (!stream.atEnd()) {
-        stream.readLine();
+    const QByteArrayView data(reinterpret_cast<const char*>(mapped), size);
+    const int threads = qMax(ThreadPool::instance().maxThreadCount(), 1);
+    if (chunks <= 0) {
+        // A few chunks per thread evens out uneven chunks
+        const qsizetype target = qBound<qsizetype>(PARALLEL_MIN_CHUNK_BYTES, size / (threads * 4), PARALLEL_MAX_CHUNK_BYTES);
+        chunks = static_cast<int>(qMax<qsizetype>(size / target, 1));
+    }
+    
+    // With no cuts, e.g. JSON on a single line or not an array at all, the
+    // serial import streams in batches and says what is wrong
+    const QList<qsizetype> starts = format == CSV ? csvChunkStarts(data, chunks) : jsonChunkStarts(data, chunks);
+    if (starts.size() < 3) {
+        return importSerially();
     }
     
-    while (!stream.atEnd()) {
-        QString line = stream.readLine().trimmed();
-        if (line.isEmpty()) {
-            continue;
+    auto parse = [format, data, starts](int index) {
+        const QByteArrayView chunk = data.sliced(starts[index], starts[index + 1] - starts[index]);
+        if (format == CSV) {
+            return parseCsvChunk(chunk, index == 0);
+        }
+        return parseJsonChunk(chunk, index + 2 == starts.size());
+    };
+    
+    // Keep a window of chunks in flight and hand results over in order
+    const int count = starts.size() - 1;
+    const int window = threads + 2;
+    QList<QFuture<ParsedChunk>> pending;
+    int submitted = 0;
+    bool complete = true;
+    
+    for (int index = 0; index < count && complete; ++index) {
+        for (; submitted < count && submitted < index + window; ++submitted) {
+            pending.append(ThreadPool::instance().executeWithResult([parse, chunk = submitted]() {
+                return parse(chunk);
+            }));
         }
         
-        QStringList fields = line.split(',');
-        if (fields.size() >= 3) {
-            QString name = fields.size() > 1 ? fields[1].trimmed() : "";
-            QString phone = fields.size() > 2 ? fields[2].trimmed() : "";
-            QString email = fields.size() > 3 ? fields[3].trimmed() : "";
-            
-            // Remove quotes if present
-            name = name.remove(QChar('"'));
-            phone = phone.remove(QChar('"'));
-            email = email.remove(QChar('"'));
-            
-            Contact contact(name, phone, email);
-            
-            // Set ID if provided
-            if (!fields[0].isEmpty()) {
-                bool ok;
-                int id = fields[0].toInt(&ok);
-                if (ok) {
-                    contact.setId(id);
+        const ParsedChunk parsed = pending.takeFirst().result();
+        if (!parsed.ok) {
+            // A cut landed inside a record or the data is malformed: from
+            // here on, import in batches as the serial import would
+            complete = streamRemainder(data, starts[index], format, index == 0, sink);
+            break;
+        }
+        
+        if (!parsed.contacts.isEmpty() && !sink(parsed.contacts)) {
+            complete = false;
+        }
+        emit importProgress(starts[index + 1], size);
+    }
+    
+    // Chunks still running read the mapping, which goes away with file;
+    // those not started yet are dropped
+    for (QFuture<ParsedChunk>& future : pending) {
+        future.cancel();
+        future.waitForFinished();
+    }
+    return complete;
+}
+
+bool FileHandler::streamRemainder(QByteArrayView data, qsizetype from, FileFormat format, bool skipHeader,
+                                  const ContactBatchSink& sink) {
+    const QByteArrayView rest = data.sliced(from);
+    
+    if (format == CSV) {
+        CsvReader reader(rest);
+        if (skipHeader) {
+            reader.readRecord();
+        }
+        const bool more = streamCsvRecords(reader, sink, DEFAULT_IMPORT_BATCH_SIZE, from, data.size());
+        if (reader.malformedRecords() > 0) {
+            qWarning() << "CSV import:" << reader.malformedRecords() << "malformed record(s)";
+        }
+        return more;
+    }
+    
+    QByteArray bytes = QByteArray::fromRawData(rest.data(), rest.size());
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    JsonPullParser parser(&buffer);
+    parser.beginInsideArray();
+    return streamJsonElements(parser, sink, DEFAULT_IMPORT_BATCH_SIZE, from, data.size());
+}
+
+QList<qsizetype> FileHandler::csvChunkStarts(QByteArrayView data, int chunks) {
+    const qsizetype size = data.size();
+    const qsizetype step = qMax<qsizetype>(size / qMax(chunks, 1), 1);
+    
+    // The quote count of each stretch between nominal cuts, counted in
+    // parallel, gives the quote state at every cut
+    QList<QByteArrayView> stretches;
+    for (qsizetype from = 0; from < size; from += step) {
+        stretches.append(data.sliced(from, qMin(step, size - from)));
+    }
+    const auto quotes = ThreadPool::instance().blockingMapped(stretches, [](QByteArrayView stretch) {
+        return CsvReader::countQuotes(stretch);
+    });
+    
+    QList<qsizetype> starts = {0};
+    qsizetype quotesBefore = 0;
+    for (int i = 1; i < stretches.size(); ++i) {
+        quotesBefore += quotes[i - 1];
+        const qsizetype cut = i * step;
+        if (cut < starts.last()) {
+            continue;    // The previous record runs past this cut
+        }
+        
+        const qsizetype start = CsvReader::nextRecordStart(data, cut, quotesBefore % 2 != 0);
+        if (start > starts.last() && start < size) {
+            starts.append(start);
+        }
+    }
+    starts.append(size);
+    return starts;
+}
+
+QList<qsizetype> FileHandler::jsonChunkStarts(QByteArrayView data, int chunks) {
+    const qsizetype size = data.size();
+    qsizetype open = 0;
+    while (open < size && (data[open] == ' ' || data[open] == '\t' || data[open] == '\r' || data[open] == '\n')) {
+        ++open;
+    }
+    if (open == size || data[open] != '[') {
+        return {};
+    }
+    
+    // Chunks are runs of whole elements of the top-level array
+    QList<qsizetype> starts = {open + 1};
+    const qsizetype step = qMax<qsizetype>((size - open) / qMax(chunks, 1), 1);
+    
+    for (qsizetype cut = open + step; cut < size; cut += step) {
+        // JSON strings cannot hold a raw line break, so scanning from one
+        // starts outside any string
+        const qsizetype from = qMax(cut, starts.last());
+        const char* newline = static_cast<const char*>(std::memchr(data.data() + from, '\n', size - from));
+        if (!newline) {
+            break;
+        }
+        
+        // Look for "}, {" outside strings. Inside a nested array of objects
+        // this can misfire; the chunk then fails to parse and the import
+        // falls back to one piece from there.
+        const qsizetype limit = qMin(size, cut + step);
+        char previous = 0;
+        char beforePrevious = 0;
+        bool inString = false;
+        for (qsizetype i = newline - data.data() + 1; i < limit; ++i) {
+            const char c = data[i];
+            if (inString) {
+                if (c == '\\') {
+                    ++i;
+                } else if (c == '"') {
+                    inString = false;
                 }
+                continue;
             }
-            
-            if (contact.isValid()) {
-                contacts.append(contact);
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                continue;
+            }
+            if (c == '{' && previous == ',' && beforePrevious == '}') {
+                starts.append(i);
+                break;
             }
+            inString = c == '"';
+            beforePrevious = previous;
+            previous = c;
         }
     }
+    starts.append(size);
+    return starts;
+}
+
+FileHandler::ParsedChunk FileHandler::parseCsvChunk(QByteArrayView chunk, bool skipHeader) {
+    ParsedChunk parsed;
+    CsvReader reader(chunk);
+    if (skipHeader) {
+        reader.readRecord();
+    }
     
-    return contacts;
+    while (reader.readRecord()) {
+        Contact contact;
+        if (readCsvContact(reader, contact)) {
+            parsed.contacts.append(contact);
+        }
+    }
+    
+    parsed.ok = reader.malformedRecords() == 0;
+    if (!parsed.ok) {
+        parsed.error = QString("%1 malformed record(s)").arg(reader.malformedRecords());
+    }
+    return parsed;
+}
+
+FileHandler::ParsedChunk FileHandler::parseJsonChunk(QByteArrayView chunk, bool last) {
+    ParsedChunk parsed;
+    
+    // Read straight from the mapping
+    QByteArray bytes = QByteArray::fromRawData(chunk.data(), chunk.size());
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    JsonPullParser parser(&buffer);
+    parser.beginInsideArray();
+    
+    bool closed = false;
+    for (;;) {
+        switch (parser.next()) {
+            case JsonPullParser::BeginObject: {
+                Contact contact;
+                if (readJsonContact(parser, contact)) {
+                    parsed.contacts.append(contact);
+                }
+                break;
+            }
+            case JsonPullParser::BeginArray:
+                parser.skipValue();    // Not a contact
+                break;
+            case JsonPullParser::EndArray:
+                closed = true;
+                break;
+            case JsonPullParser::EndOfInput:
+                // Only the last chunk may close the array, and it must
+                parsed.ok = closed == last;
+                if (!parsed.ok) {
+                    parsed.error = closed ? "The array ends early" : "The array is not closed";
+                }
+                return parsed;
+            case JsonPullParser::Invalid:
+                parsed.error = parser.errorString();
+                return parsed;
+            default:
+                break;    // Scalars in the array are skipped
+        }
+    }
 }
 
 QList<Contact> FileHandler::importFromXml(const QString& filePath) {
@@ -325,7 +712,7 @@ QString FileHandler::escapeHtml(const QString& text) const {
 }
 
 QString FileHandler::escapeCsv(const QString& text) const {
-    if (text.contains(',') || text.contains('"') || text.contains('\n')) {
+    if (text.contains(',') || text.contains('"') || text.contains('\n') || text.contains('\r')) {
         QString escaped = text;
         escaped.replace("\"", "\"\"");
         return "\"" + escaped + "\"";
@@ -2,10 +2,15 @@
 #define FILEHANDLER_H
 
 #include <QObject>
+#include <QByteArrayView>
 #include <QString>
 #include <QList>
+#include <functional>
 #include "Contact.h"
 
+class CsvReader;
+class JsonPullParser;
+
 class FileHandler : public QObject {
     Q_OBJECT
     
@@ -16,21 +21,65 @@ public:
         XML
     };
     
+    // A source calls the visitor once per contact until it runs out or the
+    // visitor returns false, and returns false if it failed. Matches
+    // ContactManager::forEachContact and Database::forEachContact.
+    using ContactVisitor = std::function<bool(const Contact&)>;
+    using ContactSource = std::function<bool(const ContactVisitor&)>;
+    // Receives imported contacts a batch at a time; return false to stop
+    using ContactBatchSink = std::function<bool(const QList<Contact>&)>;
+    
+    static constexpr int DEFAULT_IMPORT_BATCH_SIZE = 4096;
+    // Chunk size bounds for importParallel() when it picks the chunk count
+    static constexpr qsizetype PARALLEL_MIN_CHUNK_BYTES = 1024 * 1024;
+    static constexpr qsizetype PARALLEL_MAX_CHUNK_BYTES = 16 * 1024 * 1024;
+    
+    template <typename Iterator>
+    static ContactSource rangeSource(Iterator first, Iterator last) {
+        return [first, last](const ContactVisitor& visit) {
+            for (Iterator it = first; it != last && visit(*it); ++it) {
+            }
+            return true;
+        };
+    }
+    
     explicit FileHandler(QObject* parent = nullptr);
     ~FileHandler() = default;
     
     // Export operations
     bool exportContacts(const QList<Contact>& contacts, const QString& filePath, FileFormat format = JSON);
     bool exportToJson(const QList<Contact>& contacts, const QString& filePath);
+    bool exportToJson(const ContactSource& source, const QString& filePath);    // Streams; constant memory
     bool exportToCsv(const QList<Contact>& contacts, const QString& filePath);
     bool exportToXml(const QList<Contact>& contacts, const QString& filePath);
     
     // Import operations
     QList<Contact> importContacts(const QString& filePath, FileFormat format = JSON);
     QList<Contact> importFromJson(const QString& filePath);
+    // Streams the array in filePath to sink with a pull parser, holding one
+    // batch at a time, and reports importProgress() in bytes. Every contact
+    // object is passed on, valid or not. Returns false on a parse error (the
+    // batches already delivered stay delivered) or if the sink stopped.
+    bool importFromJson(const QString& filePath, const ContactBatchSink& sink,
+                        int batchSize = DEFAULT_IMPORT_BATCH_SIZE);
     QList<Contact> importFromCsv(const QString& filePath);
+    // Streams records from a memory-mapped CsvReader to sink, as the JSON
+    // overload does; the first record is taken as the header
+    bool importFromCsv(const QString& filePath, const ContactBatchSink& sink,
+                       int batchSize = DEFAULT_IMPORT_BATCH_SIZE);
     QList<Contact> importFromXml(const QString& filePath);
     
+    // Parallel CSV or JSON import: maps the file, cuts it into chunks at
+    // record boundaries, parses the chunks on ThreadPool and hands each
+    // chunk's contacts to sink as one batch, in file order. Only a few
+    // chunks are in flight at once, so memory stays bounded. chunks = 0
+    // sizes them from the pool; XML, unmappable files and files that yield
+    // a single chunk import serially, and after a chunk that fails to parse
+    // the rest streams in batches as the serial import would. Same return
+    // value as the streaming imports.
+    bool importParallel(const QString& filePath, FileFormat format, const ContactBatchSink& sink, int chunks = 0);
+    QList<Contact> importParallel(const QString& filePath, FileFormat format);
+    
     // Utility methods
     static FileFormat detectFileFormat(const QString& filePath);
     static QString getFileExtension(FileFormat format);
@@ -41,8 +90,33 @@ signals:
     void exportFinished(bool success);
     void importStarted();
     void importFinished(bool success, int contactCount);
+    void importProgress(qint64 bytesRead, qint64 totalBytes);
     
 private:
+    struct ParsedChunk {
+        QList<Contact> contacts;
+        bool ok = false;    // False if the chunk must be parsed again with what follows it
+        QString error;
+    };
+    
+    static QList<qsizetype> csvChunkStarts(QByteArrayView data, int chunks);
+    static QList<qsizetype> jsonChunkStarts(QByteArrayView data, int chunks);
+    static ParsedChunk parseCsvChunk(QByteArrayView chunk, bool skipHeader);
+    static ParsedChunk parseJsonChunk(QByteArrayView chunk, bool last);
+    
+    // Batch loops shared by the serial imports and importParallel()'s
+    // fallback; progress is offset plus the bytes the reader has consumed
+    bool streamCsvRecords(CsvReader& reader, const ContactBatchSink& sink, int batchSize,
+                          qint64 offset, qint64 totalBytes);
+    // Starts after the array's '[' and reads through its ']'
+    bool streamJsonElements(JsonPullParser& parser, const ContactBatchSink& sink, int batchSize,
+                            qint64 offset, qint64 totalBytes);
+    bool streamRemainder(QByteArrayView data, qsizetype from, FileFormat format, bool skipHeader,
+                         const ContactBatchSink& sink);
+    
+    static bool readJsonContact(JsonPullParser& parser, Contact& contact);
+    static bool readCsvContact(const CsvReader& reader, Contact& contact);
+    
     QString escapeHtml(const QString& text) const;
     QString escapeCsv(const QString& text) const;
 };
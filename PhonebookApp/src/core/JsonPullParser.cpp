@@ -0,0 +1,441 @@
+#include "JsonPullParser.h"
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+    bool isWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // RFC 8259 number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool isValidNumber(const char* p, const char* end) {
+        if (p < end && *p == '-') {
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) {
+            return false;
+        }
+        if (*p++ != '0') {
+            while (p < end && isDigit(*p)) {
+                ++p;
+            }
+        }
+        if (p < end && *p == '.') {
+            if (++p == end || !isDigit(*p)) {
+                return false;
+            }
+            while (p < end && isDigit(*p)) {
+                ++p;
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            if (++p < end && (*p == '+' || *p == '-')) {
+                ++p;
+            }
+            if (p == end || !isDigit(*p)) {
+                return false;
+            }
+            while (p < end && isDigit(*p)) {
+                ++p;
+            }
+        }
+        return p == end;
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Reads the four hex digits after "\u"; -1 if malformed
+    int readHex4(const char* p, const char* end) {
+        if (end - p < 4) {
+            return -1;
+        }
+        int value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int digit = hexValue(p[i]);
+            if (digit < 0) {
+                return -1;
+            }
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    void appendUtf8(QByteArray& out, char32_t codePoint) {
+        if (codePoint < 0x80) {
+            out.append(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            out.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+            out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            out.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+            out.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            out.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+}
+
+JsonPullParser::JsonPullParser(QIODevice* device, int chunkSize)
+    : m_device(device)
+    , m_pos(0)
+    , m_bufferOffset(0)
+    , m_chunkSize(qMax(chunkSize, 64))
+    , m_atEnd(false)
+    , m_insideArray(false)
+    , m_state(ExpectValue)
+    , m_token(Invalid)
+    , m_bool(false) {
+}
+
+void JsonPullParser::beginInsideArray() {
+    m_stack.append('[');
+    m_state = ExpectValueOrEnd;
+    m_insideArray = true;
+}
+
+JsonPullParser::Token JsonPullParser::next() {
+    if (hasError()) {
+        return Invalid;
+    }
+
+    for (;;) {
+        if (!skipWhitespace()) {
+            if (m_state == AfterValue && m_stack.isEmpty()) {
+                return m_token = EndOfInput;
+            }
+            if (m_insideArray && m_stack.size() == 1 && m_state != ExpectKey && m_state != ExpectKeyOrEnd) {
+                return m_token = EndOfInput;    // Between elements of the outer array
+            }
+            return fail("Unexpected end of input");
+        }
+
+        const char c = m_buffer.at(m_pos);
+        switch (m_state) {
+            case AfterValue:
+                if (m_stack.isEmpty()) {
+                    return fail("Unexpected data after the document");
+                }
+                if (c == ',') {
+                    ++m_pos;
+                    m_state = m_stack.last() == '{' ? ExpectKey : ExpectValue;
+                    continue;
+                }
+                return endContainer(c);
+
+            case ExpectKeyOrEnd:
+                if (c == '}') {
+                    return endContainer(c);
+                }
+                [[fallthrough]];
+            case ExpectKey:
+                if (c != '"') {
+                    return fail("Expected a member name");
+                }
+                return readString(Key);
+
+            case ExpectValueOrEnd:
+                if (c == ']') {
+                    return endContainer(c);
+                }
+                [[fallthrough]];
+            case ExpectValue:
+                return readValue(c);
+        }
+    }
+}
+
+JsonPullParser::Token JsonPullParser::token() const {
+    return m_token;
+}
+
+int JsonPullParser::depth() const {
+    return m_stack.size();
+}
+
+QString JsonPullParser::stringValue() const {
+    return m_string;
+}
+
+double JsonPullParser::numberValue() const {
+    return m_number.toDouble();
+}
+
+qint64 JsonPullParser::integerValue() const {
+    bool ok = false;
+    const qint64 value = m_number.toLongLong(&ok);
+    return ok ? value : static_cast<qint64>(m_number.toDouble());
+}
+
+bool JsonPullParser::boolValue() const {
+    return m_bool;
+}
+
+bool JsonPullParser::skipValue() {
+    if (m_token != BeginArray && m_token != BeginObject) {
+        return !hasError();
+    }
+
+    const int outer = depth() - 1;
+    while (depth() > outer) {
+        if (next() == Invalid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonPullParser::hasError() const {
+    return !m_error.isEmpty();
+}
+
+QString JsonPullParser::errorString() const {
+    return m_error;
+}
+
+qint64 JsonPullParser::bytesConsumed() const {
+    return m_bufferOffset + m_pos;
+}
+
+bool JsonPullParser::fill() {
+    if (m_atEnd) {
+        return false;
+    }
+
+    // Drop what has been consumed; only the unfinished token moves
+    if (m_pos > 0) {
+        m_buffer.remove(0, m_pos);
+        m_bufferOffset += m_pos;
+        m_pos = 0;
+    }
+
+    const qsizetype kept = m_buffer.size();
+    m_buffer.resize(kept + m_chunkSize);
+    const qint64 read = m_device->read(m_buffer.data() + kept, m_chunkSize);
+    m_buffer.resize(kept + qMax<qint64>(read, 0));
+
+    if (read <= 0) {
+        m_atEnd = true;
+        return false;
+    }
+    return true;
+}
+
+bool JsonPullParser::skipWhitespace() {
+    for (;;) {
+        const char* data = m_buffer.constData();
+        const qsizetype size = m_buffer.size();
+        while (m_pos < size && isWhitespace(data[m_pos])) {
+            ++m_pos;
+        }
+        if (m_pos < size) {
+            return true;
+        }
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+JsonPullParser::Token JsonPullParser::readValue(char c) {
+    switch (c) {
+        case '{':
+        case '[':
+            ++m_pos;
+            m_stack.append(c);
+            m_state = c == '{' ? ExpectKeyOrEnd : ExpectValueOrEnd;
+            return m_token = c == '{' ? BeginObject : BeginArray;
+        case '"':
+            return readString(String);
+        case 't':
+            return readLiteral("true", Bool, true);
+        case 'f':
+            return readLiteral("false", Bool, false);
+        case 'n':
+            return readLiteral("null", Null, false);
+        default:
+            if (c == '-' || isDigit(c)) {
+                return readNumber();
+            }
+            return fail("Unexpected character");
+    }
+}
+
+JsonPullParser::Token JsonPullParser::readString(Token kind) {
+    // Find the closing quote first, so the common escape-free string is
+    // decoded straight from the buffer in one go
+    qsizetype offset = 1;
+    bool escaped = false;
+    for (;;) {
+        const char* data = m_buffer.constData() + m_pos;
+        const qsizetype available = m_buffer.size() - m_pos;
+        while (offset < available) {
+            const unsigned char c = static_cast<unsigned char>(data[offset]);
+            if (c == '"') {
+                break;
+            }
+            if (c == '\\') {
+                escaped = true;
+                offset += 2;
+                continue;
+            }
+            if (c < 0x20) {
+                return fail("Control character in string");
+            }
+            ++offset;
+        }
+        if (offset < available) {
+            break;
+        }
+        if (!fill()) {
+            return fail("Unterminated string");
+        }
+    }
+
+    const char* begin = m_buffer.constData() + m_pos + 1;
+    const char* end = m_buffer.constData() + m_pos + offset;
+    if (!escaped) {
+        m_string = QString::fromUtf8(begin, end - begin);
+    } else if (!unescape(begin, end)) {
+        return fail("Invalid escape sequence");
+    }
+    m_pos += offset + 1;
+
+    if (kind == Key) {
+        if (!skipWhitespace() || m_buffer.at(m_pos) != ':') {
+            return fail("Expected ':' after a member name");
+        }
+        ++m_pos;
+        m_state = ExpectValue;
+    } else {
+        m_state = AfterValue;
+    }
+    return m_token = kind;
+}
+
+JsonPullParser::Token JsonPullParser::readNumber() {
+    qsizetype length = 0;
+    for (;;) {
+        const char* data = m_buffer.constData() + m_pos;
+        const qsizetype available = m_buffer.size() - m_pos;
+        while (length < available && isNumberChar(data[length])) {
+            ++length;
+        }
+        if (length < available || !fill()) {
+            break;
+        }
+    }
+
+    const char* begin = m_buffer.constData() + m_pos;
+    if (!isValidNumber(begin, begin + length)) {
+        return fail("Invalid number");
+    }
+    m_number = QByteArray(begin, length);
+    m_pos += length;
+    m_state = AfterValue;
+    return m_token = Number;
+}
+
+JsonPullParser::Token JsonPullParser::readLiteral(const char* text, Token kind, bool value) {
+    const qsizetype length = qsizetype(std::strlen(text));
+    while (m_buffer.size() - m_pos < length) {
+        if (!fill()) {
+            return fail("Invalid literal");
+        }
+    }
+    if (std::memcmp(m_buffer.constData() + m_pos, text, length) != 0) {
+        return fail("Invalid literal");
+    }
+
+    m_pos += length;
+    m_bool = value;
+    m_state = AfterValue;
+    return m_token = kind;
+}
+
+JsonPullParser::Token JsonPullParser::endContainer(char close) {
+    const char open = close == '}' ? '{' : '[';
+    if ((close != '}' && close != ']') || m_stack.isEmpty() || m_stack.last() != open) {
+        return fail(m_state == AfterValue ? "Expected ',' or a closing bracket" : "Mismatched closing bracket");
+    }
+
+    ++m_pos;
+    m_stack.removeLast();
+    m_state = AfterValue;
+    return m_token = close == '}' ? EndObject : EndArray;
+}
+
+JsonPullParser::Token JsonPullParser::fail(const char* message) {
+    m_error = QString("%1 at byte %2").arg(QLatin1String(message)).arg(bytesConsumed());
+    return m_token = Invalid;
+}
+
+bool JsonPullParser::unescape(const char* begin, const char* end) {
+    QByteArray decoded;
+    decoded.reserve(end - begin);
+
+    for (const char* p = begin; p < end; ++p) {
+        if (*p != '\\') {
+            decoded.append(*p);
+            continue;
+        }
+        if (++p == end) {
+            return false;
+        }
+
+        switch (*p) {
+            case '"':  decoded.append('"'); break;
+            case '\\': decoded.append('\\'); break;
+            case '/':  decoded.append('/'); break;
+            case 'b':  decoded.append('\b'); break;
+            case 'f':  decoded.append('\f'); break;
+            case 'n':  decoded.append('\n'); break;
+            case 'r':  decoded.append('\r'); break;
+            case 't':  decoded.append('\t'); break;
+            case 'u': {
+                int unit = readHex4(p + 1, end);
+                if (unit < 0) {
+                    return false;
+                }
+                p += 4;
+
+                char32_t codePoint = unit;
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    // A high surrogate pairs with a following \uDC00-\uDFFF
+                    const int low = end - p > 2 && p[1] == '\\' && p[2] == 'u' ? readHex4(p + 3, end) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        codePoint = 0xFFFD;
+                    }
+                } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                    codePoint = 0xFFFD;
+                }
+                appendUtf8(decoded, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    m_string = QString::fromUtf8(decoded);
+    return true;
+}
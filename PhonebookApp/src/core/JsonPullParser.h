@@ -0,0 +1,99 @@
+#ifndef JSONPULLPARSER_H
+#define JSONPULLPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+#include <QtGlobal>
+
+class QIODevice;
+
+// Incremental JSON tokenizer. Reads the device a chunk at a time and hands
+// out one token per next() call, so a document of any size is parsed in
+// memory proportional to the chunk size plus the longest single token.
+// Structure is checked as it goes: mismatched brackets, missing commas or
+// colons and trailing data all end in Invalid with errorString() set.
+class JsonPullParser {
+public:
+    enum Token {
+        Invalid,        // Parse error; sticky
+        BeginArray,
+        EndArray,
+        BeginObject,
+        EndObject,
+        Key,            // An object member name; the value follows
+        String,
+        Number,
+        Bool,
+        Null,
+        EndOfInput
+    };
+
+    static constexpr int DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+    explicit JsonPullParser(QIODevice* device, int chunkSize = DEFAULT_CHUNK_SIZE);
+
+    // Call before the first next() to parse one piece of an array split at
+    // element boundaries: the input starts as if just after the '[', and may
+    // end between elements as well as after the closing ']'
+    void beginInsideArray();
+
+    Token next();
+    Token token() const;
+    int depth() const;    // Open arrays and objects
+
+    // Values of the current token
+    QString stringValue() const;    // Key or String
+    double numberValue() const;
+    qint64 integerValue() const;    // Number, truncated if it has a fraction
+    bool boolValue() const;
+
+    // With the current token BeginArray or BeginObject, advances to its
+    // matching end; otherwise does nothing. Returns false on a parse error.
+    bool skipValue();
+
+    bool hasError() const;
+    QString errorString() const;
+    qint64 bytesConsumed() const;
+
+private:
+    enum State {
+        ExpectValue,
+        ExpectValueOrEnd,   // Just after '['
+        ExpectKey,
+        ExpectKeyOrEnd,     // Just after '{'
+        AfterValue
+    };
+
+    // Buffer management; both compact the buffer, so offsets into it must be
+    // taken relative to m_pos
+    bool fill();
+    bool skipWhitespace();
+
+    Token readValue(char c);
+    Token readString(Token kind);
+    Token readNumber();
+    Token readLiteral(const char* text, Token kind, bool value);
+    Token endContainer(char close);
+    Token fail(const char* message);
+    bool unescape(const char* begin, const char* end);
+
+    QIODevice* m_device;
+    QByteArray m_buffer;
+    qsizetype m_pos;
+    qint64 m_bufferOffset;    // Device position of m_buffer[0]
+    int m_chunkSize;
+    bool m_atEnd;
+    bool m_insideArray;
+
+    QVarLengthArray<char, 32> m_stack;
+    State m_state;
+    Token m_token;
+
+    QString m_string;
+    QByteArray m_number;
+    bool m_bool;
+    QString m_error;
+};
+
+#endif // JSONPULLPARSER_H
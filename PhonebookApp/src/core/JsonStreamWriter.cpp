@@ -0,0 +1,123 @@
+#include "JsonStreamWriter.h"
+#include <QIODevice>
+#include <QDebug>
+#include <charconv>
+
+JsonStreamWriter::JsonStreamWriter(QIODevice* device, int bufferSize)
+    : m_device(device)
+    , m_capacity(qMax(bufferSize, 256))
+    , m_flushedBytes(0)
+    , m_contacts(0)
+    , m_error(false) {
+    m_buffer.reserve(m_capacity);
+}
+
+JsonStreamWriter::~JsonStreamWriter() {
+    flush();
+}
+
+void JsonStreamWriter::beginArray() {
+    m_buffer.append("[\n");
+}
+
+void JsonStreamWriter::writeContact(const Contact& contact) {
+    if (m_contacts > 0) {
+        m_buffer.append(",\n");
+    }
+
+    m_buffer.append("{\"id\":");
+    appendNumber(contact.getId());
+    m_buffer.append(",\"name\":");
+    appendString(contact.getName());
+    m_buffer.append(",\"phone\":");
+    appendString(contact.getPhone());
+    m_buffer.append(",\"email\":");
+    appendString(contact.getEmail());
+    m_buffer.append('}');
+    ++m_contacts;
+
+    if (m_buffer.size() >= m_capacity) {
+        flush();
+    }
+}
+
+void JsonStreamWriter::endArray() {
+    m_buffer.append(m_contacts > 0 ? "\n]\n" : "]\n");
+    flush();
+}
+
+bool JsonStreamWriter::flush() {
+    if (!m_buffer.isEmpty() && !m_error) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            qWarning() << "JSON export write failed:" << m_device->errorString();
+            m_error = true;
+        } else {
+            m_flushedBytes += m_buffer.size();
+        }
+    }
+    // resize() keeps the allocation, so the buffer is reused rather than regrown
+    m_buffer.resize(0);
+    return !m_error;
+}
+
+bool JsonStreamWriter::hasError() const {
+    return m_error;
+}
+
+qint64 JsonStreamWriter::bytesWritten() const {
+    return m_flushedBytes + m_buffer.size();
+}
+
+qint64 JsonStreamWriter::contactsWritten() const {
+    return m_contacts;
+}
+
+void JsonStreamWriter::appendString(const QString& text) {
+    m_buffer.append('"');
+
+    const QChar* chars = text.constData();
+    const qsizetype length = text.size();
+    qsizetype i = 0;
+    while (i < length) {
+        const char16_t c = chars[i].unicode();
+
+        if (c >= 0x80) {
+            // Encode the whole non-ASCII run at once
+            qsizetype end = i + 1;
+            while (end < length && chars[end].unicode() >= 0x80) {
+                ++end;
+            }
+            m_buffer.append(QStringView(chars + i, end - i).toUtf8());
+            i = end;
+            continue;
+        }
+
+        switch (c) {
+            case '"':  m_buffer.append("\\\""); break;
+            case '\\': m_buffer.append("\\\\"); break;
+            case '\b': m_buffer.append("\\b"); break;
+            case '\f': m_buffer.append("\\f"); break;
+            case '\n': m_buffer.append("\\n"); break;
+            case '\r': m_buffer.append("\\r"); break;
+            case '\t': m_buffer.append("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    static const char hex[] = "0123456789abcdef";
+                    const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                    m_buffer.append(escaped, sizeof(escaped));
+                } else {
+                    m_buffer.append(static_cast<char>(c));
+                }
+                break;
+        }
+        ++i;
+    }
+
+    m_buffer.append('"');
+}
+
+void JsonStreamWriter::appendNumber(qint64 value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr - digits);
+}
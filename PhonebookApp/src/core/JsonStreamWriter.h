@@ -0,0 +1,49 @@
+#ifndef JSONSTREAMWRITER_H
+#define JSONSTREAMWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include "Contact.h"
+
+class QIODevice;
+
+// Writes a JSON array of contacts to a device as they arrive. Output is
+// serialized straight into a fixed-size buffer that is handed to the device
+// whenever it fills, so memory stays at one buffer however many contacts
+// are written. Produces one object per line:
+//   [
+//   {"id":1,"name":"...","phone":"...","email":"..."},
+//   ...
+//   ]
+class JsonStreamWriter {
+public:
+    static constexpr int DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    explicit JsonStreamWriter(QIODevice* device, int bufferSize = DEFAULT_BUFFER_SIZE);
+    ~JsonStreamWriter();    // Flushes whatever is buffered
+
+    void beginArray();
+    void writeContact(const Contact& contact);
+    void endArray();        // Also flushes
+
+    // Returns false once any write to the device has failed
+    bool flush();
+    bool hasError() const;
+
+    qint64 bytesWritten() const;    // Including bytes still buffered
+    qint64 contactsWritten() const;
+
+private:
+    void appendString(const QString& text);
+    void appendNumber(qint64 value);
+
+    QIODevice* m_device;
+    QByteArray m_buffer;
+    int m_capacity;
+    qint64 m_flushedBytes;
+    qint64 m_contacts;
+    bool m_error;
+};
+
+#endif // JSONSTREAMWRITER_H
@@ -0,0 +1,33 @@
+#include "MemoryStats.h"
+
+qint64 MemoryStats::totalBytes() const {
+    return treeBytes + stringBytes + indexBytes + cacheBytes;
+}
+
+double MemoryStats::bytesPerContact() const {
+    return contacts > 0 ? static_cast<double>(totalBytes()) / contacts : 0.0;
+}
+
+qint64 StringFootprint::add(const QString& text) {
+    const qint64 bytes = payloadBytes(text);
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (m_seen.contains(text.constData())) {
+        m_sharedBytes += bytes;
+        return 0;
+    }
+
+    m_seen.insert(text.constData());
+    m_bytes += bytes;
+    return bytes;
+}
+
+qint64 StringFootprint::payloadBytes(const QString& text) {
+    // Null, empty and literal strings own no heap block
+    if (text.capacity() == 0) {
+        return 0;
+    }
+    return static_cast<qint64>(sizeof(QArrayData)) + (text.capacity() + 1) * static_cast<qint64>(sizeof(QChar));
+}
@@ -0,0 +1,40 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <QSet>
+#include <QString>
+#include <QtGlobal>
+
+// Approximate heap footprint of a contact store. Sizes are derived from
+// sizeof and container capacities; allocator overhead is not included.
+struct MemoryStats {
+    int contacts = 0;
+    qint64 treeBytes = 0;          // BST nodes of the name tree and sorted views
+    qint64 stringBytes = 0;        // Distinct QString payloads held by contacts
+    qint64 sharedStringBytes = 0;  // Payload bytes not duplicated thanks to implicit sharing
+    qint64 indexBytes = 0;         // ContactIndex slots, maps, hashes and their keys
+    qint64 cacheBytes = 0;         // Pending change deltas
+
+    qint64 totalBytes() const;
+    double bytesPerContact() const;
+};
+
+// Counts QString payloads once per shared buffer, so copies of a contact
+// held by several containers are charged a single time.
+class StringFootprint {
+public:
+    // Returns the bytes newly charged for text
+    qint64 add(const QString& text);
+
+    qint64 bytes() const { return m_bytes; }
+    qint64 sharedBytes() const { return m_sharedBytes; }
+
+    static qint64 payloadBytes(const QString& text);
+
+private:
+    QSet<const void*> m_seen;
+    qint64 m_bytes = 0;
+    qint64 m_sharedBytes = 0;
+};
+
+#endif // MEMORYSTATS_H
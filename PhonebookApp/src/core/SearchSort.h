@@ -4,6 +4,8 @@
 #include <QList>
 #include <QString>
 #include <functional>
+#include <queue>
+#include <vector>
 #include "Contact.h"
 
 class SearchSort {
@@ -22,6 +24,10 @@ public:
     template<typename T>
     static void mergeSort(QList<T>& data, const std::function<bool(const T&, const T&)>& comparator);
     
+    // Merge several individually sorted lists into one sorted list
+    template<typename T>
+    static QList<T> kWayMerge(const QList<QList<T>>& sortedLists, const std::function<bool(const T&, const T&)>& comparator);
+    
     // Contact-specific search methods
     static QList<Contact> searchByName(const QList<Contact>& contacts, const QString& name);
     static QList<Contact> searchByPhone(const QList<Contact>& contacts, const QString& phone);
@@ -169,4 +175,41 @@ void SearchSort::merge(QList<T>& data, int left, int mid, int right, const std::
     }
 }
 
+template<typename T>
+QList<T> SearchSort::kWayMerge(const QList<QList<T>>& sortedLists, const std::function<bool(const T&, const T&)>& comparator) {
+    QList<T> result;
+    
+    qsizetype total = 0;
+    for (const QList<T>& list : sortedLists) {
+        total += list.size();
+    }
+    result.reserve(total);
+    
+    // Heap of (list, position) cursors ordered by the element they point at
+    using Cursor = std::pair<int, int>;
+    auto after = [&sortedLists, &comparator](const Cursor& a, const Cursor& b) {
+        return comparator(sortedLists[b.first][b.second], sortedLists[a.first][a.second]);
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(after)> heap(after);
+    
+    for (int i = 0; i < sortedLists.size(); ++i) {
+        if (!sortedLists[i].isEmpty()) {
+            heap.push({i, 0});
+        }
+    }
+    
+    while (!heap.empty()) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        
+        result.append(sortedLists[cursor.first][cursor.second]);
+        
+        if (cursor.second + 1 < sortedLists[cursor.first].size()) {
+            heap.push({cursor.first, cursor.second + 1});
+        }
+    }
+    
+    return result;
+}
+
 #endif // SEARCHSORT_H
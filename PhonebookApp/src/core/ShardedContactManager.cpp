@@ -0,0 +1,223 @@
+#include "ShardedContactManager.h"
+#include "SearchSort.h"
+#include "ThreadPool.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QDebug>
+#include <algorithm>
+
+ShardedContactManager::ShardedContactManager(int shardCount, QObject* parent) : QObject(parent) {
+    if (shardCount < 1) {
+        shardCount = 1;
+    }
+
+    m_shards.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+bool ShardedContactManager::addContact(const Contact& contact) {
+    if (!contact.isValid()) {
+        qWarning() << "Cannot add invalid contact";
+        return false;
+    }
+
+    Shard& shard = *m_shards[shardFor(contact)];
+    {
+        QMutexLocker locker(&shard.mutex);
+        if (!shard.contacts.insert(contact)) {
+            return false;
+        }
+        shard.index.insert(contact);
+    }
+
+    emit contactAdded(contact);
+    return true;
+}
+
+bool ShardedContactManager::removeContact(const Contact& contact) {
+    Shard& shard = *m_shards[shardFor(contact)];
+    {
+        QMutexLocker locker(&shard.mutex);
+        if (!shard.contacts.remove(contact)) {
+            return false;
+        }
+        shard.index.remove(contact);
+    }
+
+    emit contactRemoved(contact);
+    return true;
+}
+
+bool ShardedContactManager::updateContact(const Contact& oldContact, const Contact& newContact) {
+    if (!newContact.isValid()) {
+        qWarning() << "Cannot update to invalid contact";
+        return false;
+    }
+
+    int oldIndex = shardFor(oldContact);
+    int newIndex = shardFor(newContact);
+    Shard& oldShard = *m_shards[oldIndex];
+    Shard& newShard = *m_shards[newIndex];
+
+    // Lock both shards in index order so concurrent updates cannot deadlock
+    QMutexLocker firstLocker(&m_shards[std::min(oldIndex, newIndex)]->mutex);
+    std::unique_ptr<QMutexLocker<QMutex>> secondLocker;
+    if (oldIndex != newIndex) {
+        secondLocker = std::make_unique<QMutexLocker<QMutex>>(&m_shards[std::max(oldIndex, newIndex)]->mutex);
+    }
+
+    // Matched by name, the shard key, as removeContact() does
+    const Contact* stored = oldShard.contacts.findEquivalent(oldContact);
+    if (!stored) {
+        return false;
+    }
+
+    Contact previous = *stored;
+    oldShard.contacts.remove(previous);
+
+    if (!newShard.contacts.insert(newContact)) {
+        oldShard.contacts.insert(previous);
+        qWarning() << "Updated contact name already in use:" << newContact.getName();
+        return false;
+    }
+
+    oldShard.index.remove(previous);
+    newShard.index.insert(newContact);
+
+    secondLocker.reset();
+    firstLocker.unlock();
+
+    emit contactUpdated(oldContact, newContact);
+    return true;
+}
+
+ImportReport ShardedContactManager::importContactsBatch(const QList<Contact>& contacts) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ImportReport report;
+    report.total = contacts.size();
+
+    const QList<bool> valid = ContactManager::validateContacts(contacts);
+
+    // Route rows to shards, then fill every shard in parallel
+    QList<QList<int>> rowsByShard(shardCount());
+    for (int row = 0; row < contacts.size(); ++row) {
+        if (!valid[row]) {
+            report.invalid++;
+            report.rejections.append(ImportReport::Rejection{row, ImportReport::InvalidContact});
+            continue;
+        }
+        rowsByShard[shardFor(contacts[row])].append(row);
+    }
+
+    QList<int> shardIds;
+    for (int i = 0; i < shardCount(); ++i) {
+        shardIds.append(i);
+    }
+
+    const QList<ImportReport> partials = ThreadPool::instance().blockingMapped(shardIds, [this, &contacts, &rowsByShard](int shardId) {
+        ImportReport partial;
+        Shard& shard = *m_shards[shardId];
+        QMutexLocker locker(&shard.mutex);
+
+        for (int row : rowsByShard[shardId]) {
+            if (shard.contacts.insert(contacts[row])) {
+                shard.index.insert(contacts[row]);
+                partial.added++;
+            } else {
+                partial.duplicates++;
+                partial.rejections.append(ImportReport::Rejection{row, ImportReport::DuplicateContact});
+            }
+        }
+        return partial;
+    });
+
+    for (const ImportReport& partial : partials) {
+        report.added += partial.added;
+        report.duplicates += partial.duplicates;
+        report.rejections.append(partial.rejections);
+    }
+    // In row order, as ContactManager reports them
+    std::sort(report.rejections.begin(), report.rejections.end(),
+              [](const ImportReport::Rejection& a, const ImportReport::Rejection& b) { return a.row < b.row; });
+
+    report.elapsedMs = timer.elapsed();
+
+    emit contactsImported(report.added, report.skipped());
+    return report;
+}
+
+QList<Contact> ShardedContactManager::getAllContacts() const {
+    return mergeShards([](const Shard& shard) {
+        return shard.contacts.inorderTraversal();
+    });
+}
+
+QList<Contact> ShardedContactManager::searchContacts(const QString& query) const {
+    if (query.isEmpty()) {
+        return getAllContacts();
+    }
+
+    return mergeShards([&query](const Shard& shard) {
+        return shard.contacts.search(query);
+    });
+}
+
+QList<Contact> ShardedContactManager::query(const ContactQuery& query) const {
+    return mergeShards([&query](const Shard& shard) {
+        return shard.index.execute(query);
+    });
+}
+
+void ShardedContactManager::clearAllContacts() {
+    for (const auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
+        shard->contacts.clear();
+        shard->index.clear();
+    }
+
+    emit contactsCleared();
+}
+
+int ShardedContactManager::getContactCount() const {
+    size_t count = 0;
+    for (const auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
+        count += shard->contacts.size();
+    }
+    return static_cast<int>(count);
+}
+
+bool ShardedContactManager::isEmpty() const {
+    return getContactCount() == 0;
+}
+
+int ShardedContactManager::shardCount() const {
+    return static_cast<int>(m_shards.size());
+}
+
+int ShardedContactManager::shardFor(const Contact& contact) const {
+    // Same normalization as Contact::operator<, so equal keys share a shard
+    return static_cast<int>(qHash(contact.getName().toLower()) % m_shards.size());
+}
+
+QList<Contact> ShardedContactManager::mergeShards(const std::function<QList<Contact>(const Shard&)>& read) const {
+    QList<int> shardIds;
+    for (int i = 0; i < shardCount(); ++i) {
+        shardIds.append(i);
+    }
+
+    const QList<QList<Contact>> perShard = ThreadPool::instance().blockingMapped(shardIds, [this, &read](int shardId) {
+        const Shard& shard = *m_shards[shardId];
+        QMutexLocker locker(&shard.mutex);
+        return read(shard);
+    });
+
+    return SearchSort::kWayMerge<Contact>(perShard, [](const Contact& a, const Contact& b) {
+        return a < b;
+    });
+}
@@ -0,0 +1,68 @@
+#ifndef SHARDEDCONTACTMANAGER_H
+#define SHARDEDCONTACTMANAGER_H
+
+#include "Contact.h"
+#include "BST.h"
+#include "ContactIndex.h"
+#include "ContactManager.h"
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Contact store split into independent shards, each with its own tree,
+// indexes and lock, so that writers on different shards never contend.
+// Contacts are routed by a hash of their lowercased name, which is also the
+// uniqueness key, so duplicate checks stay local to one shard. Ordered reads
+// merge the per-shard results.
+class ShardedContactManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ShardedContactManager(int shardCount = DEFAULT_SHARD_COUNT, QObject* parent = nullptr);
+    ~ShardedContactManager() = default;
+
+    // Contact management
+    bool addContact(const Contact& contact);
+    bool removeContact(const Contact& contact);
+    bool updateContact(const Contact& oldContact, const Contact& newContact);
+    ImportReport importContactsBatch(const QList<Contact>& contacts);
+
+    // Search and retrieval, in name order across all shards
+    QList<Contact> getAllContacts() const;
+    QList<Contact> searchContacts(const QString& query) const;
+    QList<Contact> query(const ContactQuery& query) const;
+
+    // Bulk operations
+    void clearAllContacts();
+    int getContactCount() const;
+    bool isEmpty() const;
+
+    // Sharding
+    int shardCount() const;
+    int shardFor(const Contact& contact) const;
+
+    static const int DEFAULT_SHARD_COUNT = 16;
+
+signals:
+    void contactAdded(const Contact& contact);
+    void contactRemoved(const Contact& contact);
+    void contactUpdated(const Contact& oldContact, const Contact& newContact);
+    void contactsCleared();
+    void contactsImported(int count, int skipped);
+
+private:
+    struct Shard {
+        BST<Contact> contacts;
+        ContactIndex index;
+        mutable QMutex mutex;
+    };
+
+    QList<Contact> mergeShards(const std::function<QList<Contact>(const Shard&)>& read) const;
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+#endif // SHARDEDCONTACTMANAGER_H
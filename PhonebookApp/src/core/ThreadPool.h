@@ -30,6 +30,14 @@ public:
     template<typename Func, typename Result = std::invoke_result_t<Func>>
     QFuture<Result> executeWithResult(Func&& function);
     
+    // Runs function(QPromise<T>&) so the task can report progress and observe cancellation
+    template<typename T, typename Func>
+    QFuture<T> executeWithPromise(Func&& function);
+    
+    // Parallel map over a sequence, blocking until every item is processed
+    template<typename Sequence, typename MapFunctor>
+    auto blockingMapped(const Sequence& sequence, MapFunctor&& function);
+    
     // Utility methods
     void waitForDone();
     void clear();
@@ -50,4 +58,14 @@ QFuture<Result> ThreadPool::executeWithResult(Func&& function) {
     return QtConcurrent::run(m_threadPool, std::forward<Func>(function));
 }
 
+template<typename T, typename Func>
+QFuture<T> ThreadPool::executeWithPromise(Func&& function) {
+    return QtConcurrent::run(m_threadPool, std::forward<Func>(function));
+}
+
+template<typename Sequence, typename MapFunctor>
+auto ThreadPool::blockingMapped(const Sequence& sequence, MapFunctor&& function) {
+    return QtConcurrent::blockingMapped(m_threadPool, sequence, std::forward<MapFunctor>(function));
+}
+
 #endif // THREADPOOL_H
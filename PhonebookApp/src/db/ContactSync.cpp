@@ -0,0 +1,139 @@
+#include "ContactSync.h"
+#include "core/ContactManager.h"
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDebug>
+
+ContactSync::ContactSync(ContactManager* manager, Database* database, QObject* parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_database(database)
+    , m_autoPersistTimer(new QTimer(this)) {
+    connect(m_autoPersistTimer, &QTimer::timeout, this, [this]() {
+        if (hasUnsavedChanges()) {
+            persist();
+        }
+    });
+}
+
+bool ContactSync::loadAll() {
+    if (!m_database->isConnected()) {
+        return false;
+    }
+    
+    // Taken first: anything written during the load is picked up again by
+    // the next reload() rather than missed
+    m_watermark = m_database->lastUpdatedAt();
+    
+    QList<Contact> batch;
+    batch.reserve(LOAD_BATCH_SIZE);
+    int count = 0;
+    
+    bool ok = m_database->forEachContact([&](const Contact& contact) {
+        batch.append(contact);
+        if (batch.size() == LOAD_BATCH_SIZE) {
+            count += m_manager->mergeStoredContacts(batch);
+            batch.clear();
+        }
+        return true;
+    });
+    count += m_manager->mergeStoredContacts(batch);
+    
+    emit loaded(count);
+    return ok;
+}
+
+int ContactSync::reload() {
+    if (!m_database->isConnected()) {
+        return 0;
+    }
+    
+    QString since = m_watermark;
+    m_watermark = m_database->lastUpdatedAt();
+    
+    // No watermark yet means the table was empty: everything is new
+    QList<Contact> changed = since.isEmpty() ? m_database->getAllContacts()
+                                             : m_database->getContactsUpdatedSince(since);
+    int count = m_manager->mergeStoredContacts(changed);
+    
+    emit reloaded(count);
+    return count;
+}
+
+BulkWriteResult ContactSync::persist() {
+    BulkWriteResult result;
+    ContactManager::DirtySet dirty = m_manager->takeDirty();
+    if (dirty.isEmpty()) {
+        result.success = true;
+        return result;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    int rows = 0;
+    QList<int> insertedIds;
+    result.success = m_database->runInTransaction([&]() {
+        // New contacts take their ids from the table, never their own
+        if (!dirty.inserted.isEmpty()) {
+            BulkWriteResult saved = m_database->saveContacts(dirty.inserted, &insertedIds);
+            if (!saved.success) {
+                return false;
+            }
+            rows += saved.rowsAffected;
+        }
+        if (!dirty.updated.isEmpty()) {
+            BulkWriteResult upserted = m_database->upsertContacts(dirty.updated);
+            if (!upserted.success) {
+                return false;
+            }
+            rows += upserted.rowsAffected;
+        }
+        if (!dirty.removedIds.isEmpty()) {
+            BulkWriteResult deleted = m_database->deleteContacts(dirty.removedIds);
+            if (!deleted.success) {
+                return false;
+            }
+            rows += deleted.rowsAffected;
+        }
+        return true;
+    });
+    
+    result.elapsedMs = timer.elapsed();
+    
+    if (!result.success) {
+        // Keep the changes so the next attempt writes them
+        m_manager->restoreDirty(dirty);
+        qWarning() << "Failed to persist"
+                   << dirty.inserted.size() + dirty.updated.size() + dirty.removedIds.size() << "change(s)";
+        emit persistFailed();
+        return result;
+    }
+    
+    m_manager->adoptStoredIds(dirty.inserted, insertedIds);
+    result.rowsAffected = rows;
+    emit persisted(rows);
+    return result;
+}
+
+bool ContactSync::discardAndReload() {
+    m_manager->clearAllContacts();
+    m_manager->takeDirty();    // The clear is not a change to persist
+    return loadAll();
+}
+
+bool ContactSync::hasUnsavedChanges() const {
+    return m_manager->hasUnsavedChanges();
+}
+
+QString ContactSync::watermark() const {
+    return m_watermark;
+}
+
+void ContactSync::setAutoPersistInterval(int ms) {
+    if (ms > 0) {
+        m_autoPersistTimer->start(ms);
+    } else {
+        m_autoPersistTimer->stop();
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef CONTACTSYNC_H
+#define CONTACTSYNC_H
+
+#include <QObject>
+#include <QString>
+#include "db/Database.h"
+
+class ContactManager;
+class QTimer;
+
+// Keeps a ContactManager and a Database in step. loadAll() bulk-loads the
+// table into memory; after that persist() writes back only the contacts the
+// manager marked dirty, in one transaction, and reload() pulls in rows other
+// writers changed since the last updated_at watermark.
+//
+// persist() runs on the calling thread, the GUI thread in the app. It writes
+// only what changed since the last call, usually a few rows on the auto-persist
+// timer, so it stays short without going through DatabaseWriter.
+class ContactSync : public QObject {
+    Q_OBJECT
+    
+public:
+    ContactSync(ContactManager* manager, Database* database, QObject* parent = nullptr);
+    
+    bool loadAll();
+    int reload();                  // Returns the number of contacts merged
+    BulkWriteResult persist();
+    // Drops unsaved changes and loads the table again, e.g. after a restore
+    bool discardAndReload();
+    
+    bool hasUnsavedChanges() const;
+    QString watermark() const;
+    
+    // Persists on a timer while there are unsaved changes; 0 disables
+    void setAutoPersistInterval(int ms);
+    
+signals:
+    void loaded(int count);
+    void reloaded(int count);
+    void persisted(int rows);
+    void persistFailed();
+    
+private:
+    ContactManager* m_manager;
+    Database* m_database;
+    QTimer* m_autoPersistTimer;
+    QString m_watermark;
+    
+    static const int LOAD_BATCH_SIZE = 4096;
+};
+
+#endif // CONTACTSYNC_H
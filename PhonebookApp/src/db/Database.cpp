@@ -1,18 +1,72 @@
 #include "Database.h"
 #include <QSqlError>
 #include <QSqlRecord>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QStandardPaths>
 #include <QDir>
 #include <QFile>
-#include <QTextStream>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
 #include <QDebug>
+#include <algorithm>
+
+// Q_INIT_RESOURCE cannot be used inside a namespace or class scope
+static void initMigrationResources() {
+    Q_INIT_RESOURCE(migrations);
+}
 
 const QString Database::DATABASE_NAME = "phonebook.db";
+const QString Database::MIGRATIONS_PATH = ":/migrations";
 const QString Database::CONNECTION_NAME = "PhonebookConnection";
 
+PerformanceProfile PerformanceProfile::durable() {
+    return PerformanceProfile();
+}
+
+PerformanceProfile PerformanceProfile::fast() {
+    PerformanceProfile profile;
+    profile.synchronous = SyncNormal;
+    profile.cacheSizeKiB = 65536;
+    profile.mmapSizeBytes = 256LL * 1024 * 1024;
+    profile.tempStoreInMemory = true;
+    return profile;
+}
+
+QStringList PerformanceProfile::pragmas() const {
+    return QStringList{QString("PRAGMA journal_mode = %1").arg(journalMode)} + connectionPragmas();
+}
+
+QStringList PerformanceProfile::connectionPragmas() const {
+    static const char* const syncNames[] = {"OFF", "NORMAL", "FULL"};
+    
+    // A negative cache_size is in KiB rather than pages
+    return {
+        QString("PRAGMA synchronous = %1").arg(syncNames[synchronous]),
+        QString("PRAGMA cache_size = -%1").arg(cacheSizeKiB),
+        QString("PRAGMA mmap_size = %1").arg(mmapSizeBytes),
+        QString("PRAGMA temp_store = %1").arg(tempStoreInMemory ? "MEMORY" : "DEFAULT"),
+        QString("PRAGMA busy_timeout = %1").arg(busyTimeoutMs)
+    };
+}
+
+double BulkWriteResult::rowsPerSecond() const {
+    return rowsAffected * 1000.0 / std::max<qint64>(elapsedMs, 1);
+}
+
 Database::Database(QObject* parent)
+    : Database(CONNECTION_NAME, parent) {
+}
+
+Database::Database(const QString& connectionName, QObject* parent)
     : QObject(parent)
-    , m_isInitialized(false) {
+    , m_connectionName(connectionName)
+    , m_isInitialized(false)
+    , m_inTransaction(false)
+    , m_rollbackOnly(false)
+    , m_ownerThread(nullptr)
+    , m_hasFullTextSearch(false) {
 }
 
 Database::~Database() {
@@ -30,7 +84,8 @@ bool Database::initialize(const QString& databasePath) {
     QFileInfo fileInfo(m_databasePath);
     QDir().mkpath(fileInfo.absolutePath());
     
-    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_ownerThread = QThread::currentThread();
+    m_database = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
     m_database.setDatabaseName(m_databasePath);
     
     if (!m_database.open()) {
@@ -40,46 +95,191 @@ bool Database::initialize(const QString& databasePath) {
         return false;
     }
     
-    if (!createTables()) {
+    if (!applyPerformanceProfile()) {
         close();
         return false;
     }
     
-    if (!executeMigrations()) {
+    if (!applyMigrations()) {
         close();
         return false;
     }
     
+    // Full-text search is an optimization; LIKE still works without it
+    m_hasFullTextSearch = createFullTextIndex();
+    
     m_isInitialized = true;
     return true;
 }
 
+void Database::setPerformanceProfile(const PerformanceProfile& profile) {
+    m_profile = profile;
+}
+
+PerformanceProfile Database::performanceProfile() const {
+    return m_profile;
+}
+
+QVariant Database::pragmaValue(const QString& pragma) const {
+    if (!m_database.isOpen()) {
+        return QVariant();
+    }
+    
+    QSqlQuery query(connection());
+    if (!query.exec(QString("PRAGMA %1").arg(pragma)) || !query.next()) {
+        logError("pragmaValue", query);
+        return QVariant();
+    }
+    return query.value(0);
+}
+
 bool Database::isConnected() const {
     return m_database.isOpen() && m_isInitialized;
 }
 
+QString Database::databasePath() const {
+    return m_databasePath;
+}
+
 void Database::close() {
+    // Reader threads must be idle by now; their connections go first
+    {
+        QMutexLocker locker(&m_poolMutex);
+        for (auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+            it->statements->clear();
+            it->database.close();
+            it->database = QSqlDatabase();
+            QSqlDatabase::removeDatabase(it->name);
+        }
+        m_pool.clear();
+    }
+    
+    // Statements must be gone before their connection is removed
+    m_statements.clear();
     if (m_database.isOpen()) {
         m_database.close();
     }
-    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
     m_isInitialized = false;
 }
 
+int Database::readerConnectionCount() const {
+    QMutexLocker locker(&m_poolMutex);
+    return m_pool.size();
+}
+
+QSqlDatabase Database::connection() const {
+    QThread* thread = QThread::currentThread();
+    if (thread == m_ownerThread) {
+        return m_database;
+    }
+    
+    QMutexLocker locker(&m_poolMutex);
+    auto it = m_pool.find(thread);
+    if (it != m_pool.end()) {
+        return it->database;
+    }
+    
+    // First query from this thread: clone the main connection. WAL lets the
+    // clones read while the owner thread writes.
+    ConnectionSlot slot;
+    slot.name = QString("%1-%2").arg(m_connectionName).arg(reinterpret_cast<quintptr>(thread), 0, 16);
+    slot.database = QSqlDatabase::cloneDatabase(m_connectionName, slot.name);
+    
+    if (!slot.database.open()) {
+        qWarning() << "Failed to open reader connection:" << slot.database.lastError().text();
+        slot.database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(slot.name);
+        return QSqlDatabase();
+    }
+    
+    QSqlQuery query(slot.database);
+    for (const QString& pragma : m_profile.connectionPragmas()) {
+        if (!query.exec(pragma)) {
+            qWarning() << "Failed to apply" << pragma << "on reader connection:" << query.lastError().text();
+        }
+    }
+    
+    // Connections are bound to their thread; release it from there on exit
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        releaseConnection(thread);
+    }, Qt::DirectConnection);
+    
+    return m_pool.insert(thread, slot)->database;
+}
+
+void Database::releaseConnection(QThread* thread) const {
+    QMutexLocker locker(&m_poolMutex);
+    auto it = m_pool.find(thread);
+    if (it == m_pool.end()) {
+        return;
+    }
+    
+    QString name = it->name;
+    it->statements->clear();
+    it->database.close();
+    m_pool.erase(it);
+    QSqlDatabase::removeDatabase(name);
+}
+
+int Database::cachedStatementCount() const {
+    if (QThread::currentThread() == m_ownerThread) {
+        return m_statements.size();
+    }
+    
+    QMutexLocker locker(&m_poolMutex);
+    auto it = m_pool.constFind(QThread::currentThread());
+    return it != m_pool.constEnd() ? it->statements->size() : 0;
+}
+
+QSqlQuery* Database::cachedQuery(const QString& sql) const {
+    QSqlDatabase database = connection();
+    if (!database.isOpen()) {
+        return nullptr;
+    }
+    
+    StatementCache* statements = &m_statements;
+    if (QThread::currentThread() != m_ownerThread) {
+        QMutexLocker locker(&m_poolMutex);
+        auto slot = m_pool.constFind(QThread::currentThread());
+        if (slot == m_pool.constEnd()) {
+            return nullptr;
+        }
+        statements = slot->statements.get();
+    }
+    
+    auto it = statements->constFind(sql);
+    if (it != statements->constEnd()) {
+        return it->get();
+    }
+    
+    // SQLite re-prepares cached statements by itself after schema changes
+    auto query = std::make_shared<QSqlQuery>(database);
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        logError("prepare", *query);
+        return nullptr;
+    }
+    return statements->insert(sql, query)->get();
+}
+
 bool Database::saveContact(const Contact& contact) {
     if (!isConnected()) {
         emit databaseError("Database is not connected");
         return false;
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("INSERT INTO contacts (name, phone, email) VALUES (?, ?, ?)");
-    query.addBindValue(contact.getName());
-    query.addBindValue(contact.getPhone());
-    query.addBindValue(contact.getEmail());
+    QSqlQuery* query = cachedQuery("INSERT INTO contacts (name, phone, email) VALUES (?, ?, ?)");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, contact.getName());
+    query->bindValue(1, contact.getPhone());
+    query->bindValue(2, contact.getEmail());
     
-    if (!query.exec()) {
-        logError("saveContact", query);
+    if (!query->exec()) {
+        logError("saveContact", *query);
         return false;
     }
     
@@ -93,19 +293,22 @@ bool Database::updateContact(const Contact& contact) {
         return false;
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("UPDATE contacts SET name = ?, phone = ?, email = ? WHERE id = ?");
-    query.addBindValue(contact.getName());
-    query.addBindValue(contact.getPhone());
-    query.addBindValue(contact.getEmail());
-    query.addBindValue(contact.getId());
+    QSqlQuery* query = cachedQuery("UPDATE contacts SET name = ?, phone = ?, email = ?, "
+                                   "updated_at = CURRENT_TIMESTAMP WHERE id = ?");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, contact.getName());
+    query->bindValue(1, contact.getPhone());
+    query->bindValue(2, contact.getEmail());
+    query->bindValue(3, contact.getId());
     
-    if (!query.exec()) {
-        logError("updateContact", query);
+    if (!query->exec()) {
+        logError("updateContact", *query);
         return false;
     }
     
-    if (query.numRowsAffected() == 0) {
+    if (query->numRowsAffected() == 0) {
         emit databaseError("Contact not found for update");
         return false;
     }
@@ -120,16 +323,18 @@ bool Database::deleteContact(int contactId) {
         return false;
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("DELETE FROM contacts WHERE id = ?");
-    query.addBindValue(contactId);
+    QSqlQuery* query = cachedQuery("DELETE FROM contacts WHERE id = ?");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, contactId);
     
-    if (!query.exec()) {
-        logError("deleteContact", query);
+    if (!query->exec()) {
+        logError("deleteContact", *query);
         return false;
     }
     
-    if (query.numRowsAffected() == 0) {
+    if (query->numRowsAffected() == 0) {
         emit databaseError("Contact not found for deletion");
         return false;
     }
@@ -143,51 +348,129 @@ Contact Database::getContact(int contactId) const {
         return Contact();
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("SELECT id, name, phone, email FROM contacts WHERE id = ?");
-    query.addBindValue(contactId);
-    
-    if (!query.exec()) {
-        logError("getContact", query);
+    QSqlQuery* query = cachedQuery("SELECT id, name, phone, email FROM contacts WHERE id = ?");
+    if (!query) {
         return Contact();
     }
+    query->bindValue(0, contactId);
     
-    if (query.next()) {
-        Contact contact(query.value("name").toString(),
-                       query.value("phone").toString(),
-                       query.value("email").toString());
-        contact.setId(query.value("id").toInt());
-        return contact;
+    if (!query->exec()) {
+        logError("getContact", *query);
+        return Contact();
     }
     
-    return Contact();
+    Contact contact;
+    if (query->next()) {
+        contact = contactFromRow(*query);
+    }
+    // Resets the statement so it holds no read snapshot between calls
+    query->finish();
+    return contact;
 }
 
 QList<Contact> Database::getAllContacts() const {
     QList<Contact> contacts;
+    forEachContact([&contacts](const Contact& contact) {
+        contacts.append(contact);
+        return true;
+    });
+    return contacts;
+}
+
+QList<Contact> Database::getContactsPage(const PageKey& after, int limit, PageKey* next) const {
+    QList<Contact> contacts;
     
-    if (!isConnected()) {
+    // Past the end the key stays put; the start sentinel would wrap around
+    if (next) {
+        *next = after;
+    }
+    if (!isConnected() || limit <= 0) {
         return contacts;
     }
     
-    QSqlQuery query("SELECT id, name, phone, email FROM contacts ORDER BY name", m_database);
+    // Seeks on the (name, id) order of idx_contacts_name_nocase instead of
+    // skipping OFFSET rows, so every page costs the same
+    QSqlQuery query(connection());
+    query.setForwardOnly(true);
+    if (after.isStart()) {
+        query.prepare("SELECT id, name, phone, email FROM contacts ORDER BY name COLLATE NOCASE, id LIMIT ?");
+    } else {
+        // SQLite will not seek on a row value with a collation, so the
+        // leading name bound carries the index range
+        query.prepare("SELECT id, name, phone, email FROM contacts "
+                      "WHERE name COLLATE NOCASE >= ? AND (name COLLATE NOCASE, id) > (?, ?) "
+                      "ORDER BY name COLLATE NOCASE, id LIMIT ?");
+        query.addBindValue(after.name);
+        query.addBindValue(after.name);
+        query.addBindValue(after.id);
+    }
+    query.addBindValue(limit);
     
     if (!query.exec()) {
-        logError("getAllContacts", query);
+        logError("getContactsPage", query);
         return contacts;
     }
     
+    contacts.reserve(limit);
     while (query.next()) {
-        Contact contact(query.value("name").toString(),
-                       query.value("phone").toString(),
-                       query.value("email").toString());
-        contact.setId(query.value("id").toInt());
-        contacts.append(contact);
+        contacts.append(contactFromRow(query));
     }
     
+    if (next && !contacts.isEmpty()) {
+        *next = PageKey{contacts.last().getName(), contacts.last().getId()};
+    }
     return contacts;
 }
 
+QList<Contact> Database::getContactsByPhone(const QString& phone) const {
+    QList<Contact> contacts;
+    if (!isConnected() || phone.isEmpty()) {
+        return contacts;
+    }
+    
+    QSqlQuery* query = cachedQuery("SELECT id, name, phone, email FROM contacts "
+                                   "WHERE phone = ? ORDER BY name COLLATE NOCASE");
+    if (!query) {
+        return contacts;
+    }
+    query->bindValue(0, phone);
+    
+    if (!query->exec()) {
+        logError("getContactsByPhone", *query);
+        return contacts;
+    }
+    
+    while (query->next()) {
+        contacts.append(contactFromRow(*query));
+    }
+    query->finish();
+    
+    return contacts;
+}
+
+bool Database::forEachContact(const std::function<bool(const Contact&)>& callback) const {
+    if (!isConnected()) {
+        return false;
+    }
+    
+    // Forward-only: the driver keeps no row cache, so memory stays flat
+    QSqlQuery query(connection());
+    query.setForwardOnly(true);
+    
+    if (!query.exec("SELECT id, name, phone, email FROM contacts ORDER BY name COLLATE NOCASE, id")) {
+        logError("forEachContact", query);
+        return false;
+    }
+    
+    while (query.next()) {
+        if (!callback(contactFromRow(query))) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
 QList<Contact> Database::searchContacts(const QString& searchQuery) const {
     QList<Contact> contacts;
     
@@ -195,32 +478,334 @@ QList<Contact> Database::searchContacts(const QString& searchQuery) const {
         return contacts;
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("SELECT id, name, phone, email FROM contacts "
-                  "WHERE name LIKE ? OR phone LIKE ? OR email LIKE ? "
-                  "ORDER BY name");
+    if (m_hasFullTextSearch && searchQuery.size() >= MIN_FULL_TEXT_QUERY) {
+        return searchFullText(searchQuery);
+    }
+    
+    // Short queries (and SQLite builds without FTS5) fall back to a scan
+    QSqlQuery* query = cachedQuery("SELECT id, name, phone, email FROM contacts "
+                                   "WHERE name LIKE ? OR phone LIKE ? OR email LIKE ? "
+                                   "ORDER BY name COLLATE NOCASE");
+    if (!query) {
+        return contacts;
+    }
     
     QString likePattern = QString("%%1%").arg(searchQuery);
-    query.addBindValue(likePattern);
-    query.addBindValue(likePattern);
-    query.addBindValue(likePattern);
+    query->bindValue(0, likePattern);
+    query->bindValue(1, likePattern);
+    query->bindValue(2, likePattern);
+    
+    if (!query->exec()) {
+        logError("searchContacts", *query);
+        return contacts;
+    }
+    
+    while (query->next()) {
+        contacts.append(contactFromRow(*query));
+    }
+    query->finish();
+    
+    return contacts;
+}
+
+BulkWriteResult Database::saveContacts(const QList<Contact>& contacts, QList<int>* insertedIds) {
+    BulkWriteResult result;
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return result;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    if (insertedIds) {
+        insertedIds->clear();
+        insertedIds->reserve(contacts.size());
+    }
+    
+    result.success = runInTransaction([&]() {
+        QSqlQuery query(m_database);
+        query.prepare("INSERT INTO contacts (name, phone, email) VALUES (?, ?, ?)");
+        
+        if (insertedIds) {
+            // Row by row to read each new id back; still one prepared statement
+            for (const Contact& contact : contacts) {
+                query.bindValue(0, contact.getName());
+                query.bindValue(1, contact.getPhone());
+                query.bindValue(2, contact.getEmail());
+                if (!query.exec()) {
+                    logError("saveContacts", query);
+                    return false;
+                }
+                insertedIds->append(query.lastInsertId().toInt());
+            }
+            return true;
+        }
+        
+        QVariantList names, phones, emails;
+        names.reserve(contacts.size());
+        phones.reserve(contacts.size());
+        emails.reserve(contacts.size());
+        for (const Contact& contact : contacts) {
+            names.append(contact.getName());
+            phones.append(contact.getPhone());
+            emails.append(contact.getEmail());
+        }
+        query.addBindValue(names);
+        query.addBindValue(phones);
+        query.addBindValue(emails);
+        
+        if (!query.execBatch()) {
+            logError("saveContacts", query);
+            return false;
+        }
+        return true;
+    });
+    
+    result.rowsAffected = result.success ? contacts.size() : 0;
+    result.elapsedMs = timer.elapsed();
+    
+    if (result.success) {
+        emit contactsSaved(result.rowsAffected);
+    }
+    return result;
+}
+
+BulkWriteResult Database::updateContacts(const QList<Contact>& contacts) {
+    BulkWriteResult result;
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return result;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Executed row by row on the same prepared statement, since execBatch
+    // cannot report how many ids actually matched
+    int affected = 0;
+    result.success = runInTransaction([&]() {
+        QSqlQuery query(m_database);
+        query.prepare("UPDATE contacts SET name = ?, phone = ?, email = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?");
+        
+        for (const Contact& contact : contacts) {
+            query.bindValue(0, contact.getName());
+            query.bindValue(1, contact.getPhone());
+            query.bindValue(2, contact.getEmail());
+            query.bindValue(3, contact.getId());
+            
+            if (!query.exec()) {
+                logError("updateContacts", query);
+                return false;
+            }
+            affected += query.numRowsAffected();
+        }
+        return true;
+    });
+    
+    result.rowsAffected = result.success ? affected : 0;
+    result.elapsedMs = timer.elapsed();
+    
+    if (result.success) {
+        emit contactsUpdated(result.rowsAffected);
+    }
+    return result;
+}
+
+BulkWriteResult Database::deleteContacts(const QList<int>& contactIds) {
+    BulkWriteResult result;
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return result;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    int affected = 0;
+    result.success = runInTransaction([&]() {
+        QSqlQuery query(m_database);
+        query.prepare("DELETE FROM contacts WHERE id = ?");
+        
+        for (int contactId : contactIds) {
+            query.bindValue(0, contactId);
+            
+            if (!query.exec()) {
+                logError("deleteContacts", query);
+                return false;
+            }
+            affected += query.numRowsAffected();
+        }
+        return true;
+    });
+    
+    result.rowsAffected = result.success ? affected : 0;
+    result.elapsedMs = timer.elapsed();
+    
+    if (result.success) {
+        emit contactsDeleted(result.rowsAffected);
+    }
+    return result;
+}
+
+BulkWriteResult Database::upsertContacts(const QList<Contact>& contacts) {
+    BulkWriteResult result;
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return result;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    QVariantList ids, names, phones, emails;
+    ids.reserve(contacts.size());
+    names.reserve(contacts.size());
+    phones.reserve(contacts.size());
+    emails.reserve(contacts.size());
+    for (const Contact& contact : contacts) {
+        ids.append(contact.getId());
+        names.append(contact.getName());
+        phones.append(contact.getPhone());
+        emails.append(contact.getEmail());
+    }
+    
+    result.success = runInTransaction([&]() {
+        QSqlQuery query(m_database);
+        query.prepare("INSERT INTO contacts (id, name, phone, email) VALUES (?, ?, ?, ?) "
+                      "ON CONFLICT(id) DO UPDATE SET name = excluded.name, phone = excluded.phone, "
+                      "email = excluded.email, updated_at = CURRENT_TIMESTAMP");
+        query.addBindValue(ids);
+        query.addBindValue(names);
+        query.addBindValue(phones);
+        query.addBindValue(emails);
+        
+        if (!query.execBatch()) {
+            logError("upsertContacts", query);
+            return false;
+        }
+        return true;
+    });
+    
+    result.rowsAffected = result.success ? contacts.size() : 0;
+    result.elapsedMs = timer.elapsed();
+    
+    if (result.success) {
+        emit contactsSaved(result.rowsAffected);
+    }
+    return result;
+}
+
+QList<Contact> Database::getContactsUpdatedSince(const QString& timestamp) const {
+    QList<Contact> contacts;
+    if (!isConnected()) {
+        return contacts;
+    }
+    
+    QSqlQuery query(connection());
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, name, phone, email FROM contacts WHERE updated_at >= ? ORDER BY id");
+    query.addBindValue(timestamp);
     
     if (!query.exec()) {
-        logError("searchContacts", query);
+        logError("getContactsUpdatedSince", query);
         return contacts;
     }
     
     while (query.next()) {
-        Contact contact(query.value("name").toString(),
-                       query.value("phone").toString(),
-                       query.value("email").toString());
-        contact.setId(query.value("id").toInt());
-        contacts.append(contact);
+        contacts.append(contactFromRow(query));
+    }
+    
+    return contacts;
+}
+
+QString Database::lastUpdatedAt() const {
+    if (!isConnected()) {
+        return QString();
+    }
+    
+    QSqlQuery query(connection());
+    if (!query.exec("SELECT MAX(updated_at) FROM contacts") || !query.next()) {
+        logError("lastUpdatedAt", query);
+        return QString();
+    }
+    return query.value(0).toString();
+}
+
+bool Database::runInTransaction(const std::function<bool()>& work) {
+    if (m_inTransaction) {
+        // Cannot roll back on its own; the outer call rolls everything back
+        const bool ok = work();
+        if (!ok) {
+            m_rollbackOnly = true;
+        }
+        return ok;
+    }
+    
+    if (!m_database.transaction()) {
+        logError("beginTransaction", m_database.lastError());
+        return false;
+    }
+    
+    m_inTransaction = true;
+    m_rollbackOnly = false;
+    bool ok = work() && !m_rollbackOnly;
+    m_inTransaction = false;
+    m_rollbackOnly = false;
+    
+    if (ok && m_database.commit()) {
+        return true;
+    }
+    
+    if (ok) {
+        logError("commit", m_database.lastError());
+    }
+    m_database.rollback();
+    return false;
+}
+
+QList<Contact> Database::searchFullText(const QString& searchQuery) const {
+    QList<Contact> contacts;
+    
+    // Quoted as a single phrase, so the trigram tokenizer does a
+    // case-insensitive substring match on any column
+    QString phrase = '"' + QString(searchQuery).replace('"', "\"\"") + '"';
+    
+    QSqlQuery* query = cachedQuery("SELECT c.id, c.name, c.phone, c.email FROM contacts_fts "
+                                   "JOIN contacts c ON c.id = contacts_fts.rowid "
+                                   "WHERE contacts_fts MATCH ? "
+                                   "ORDER BY bm25(contacts_fts), c.name");
+    if (!query) {
+        return contacts;
+    }
+    query->bindValue(0, phrase);
+    
+    if (!query->exec()) {
+        logError("searchFullText", *query);
+        return contacts;
+    }
+    
+    while (query->next()) {
+        contacts.append(contactFromRow(*query));
     }
+    query->finish();
     
     return contacts;
 }
 
+Contact Database::contactFromRow(const QSqlQuery& query) {
+    // Columns by position: id, name, phone, email
+    Contact contact(query.value(1).toString(),
+                   query.value(2).toString(),
+                   query.value(3).toString());
+    contact.setId(query.value(0).toInt());
+    return contact;
+}
+
+bool Database::hasFullTextSearch() const {
+    return m_hasFullTextSearch;
+}
+
 bool Database::clearAllContacts() {
     if (!isConnected()) {
         emit databaseError("Database is not connected");
@@ -242,18 +827,180 @@ int Database::getContactCount() const {
         return 0;
     }
     
-    QSqlQuery query("SELECT COUNT(*) FROM contacts", m_database);
+    // Maintained by the contact_stats triggers, so no table scan
+    QSqlQuery* query = cachedQuery("SELECT count FROM contact_stats WHERE key = 'total'");
+    if (!query) {
+        return 0;
+    }
     
-    if (!query.exec()) {
-        logError("getContactCount", query);
+    if (!query->exec()) {
+        logError("getContactCount", *query);
         return 0;
     }
     
-    if (query.next()) {
-        return query.value(0).toInt();
+    int count = query->next() ? query->value(0).toInt() : 0;
+    query->finish();
+    return count;
+}
+
+QMap<QString, int> Database::getLetterCounts() const {
+    return statsWithPrefix("letter:");
+}
+
+QMap<QString, int> Database::getDomainCounts() const {
+    return statsWithPrefix("domain:");
+}
+
+QMap<QString, int> Database::statsWithPrefix(const QString& prefix) const {
+    QMap<QString, int> counts;
+    if (!isConnected()) {
+        return counts;
+    }
+    
+    // A key range rather than LIKE, so the primary key index is used. Every
+    // prefix ends in ':', and ';' is the next character.
+    QSqlQuery* query = cachedQuery("SELECT key, count FROM contact_stats WHERE key >= ? AND key < ?");
+    if (!query) {
+        return counts;
     }
+    query->bindValue(0, prefix);
+    query->bindValue(1, prefix.left(prefix.size() - 1) + ';');
     
-    return 0;
+    if (!query->exec()) {
+        logError("statsWithPrefix", *query);
+        return counts;
+    }
+    
+    while (query->next()) {
+        counts.insert(query->value(0).toString().mid(prefix.size()), query->value(1).toInt());
+    }
+    query->finish();
+    
+    return counts;
+}
+
+QList<ChangeLogEntry> Database::getChangesSince(qint64 afterSeq, int limit) const {
+    QList<ChangeLogEntry> changes;
+    if (!isConnected() || limit <= 0) {
+        return changes;
+    }
+    
+    // seq is the rowid, so each batch is a seek plus a short range scan
+    QSqlQuery* query = cachedQuery("SELECT seq, op, contact_id, payload, changed_at FROM contact_changes "
+                                   "WHERE seq > ? ORDER BY seq LIMIT ?");
+    if (!query) {
+        return changes;
+    }
+    query->bindValue(0, afterSeq);
+    query->bindValue(1, limit);
+    
+    if (!query->exec()) {
+        logError("getChangesSince", *query);
+        return changes;
+    }
+    
+    static const QHash<QString, ChangeLogEntry::Operation> operations = {
+        {"insert", ChangeLogEntry::Insert},
+        {"update", ChangeLogEntry::Update},
+        {"delete", ChangeLogEntry::Delete}
+    };
+    
+    // limit is only a ceiling; a caught-up consumer gets a handful of rows
+    changes.reserve(qMin(limit, 256));
+    while (query->next()) {
+        const QJsonObject payload = QJsonDocument::fromJson(query->value(3).toByteArray()).object();
+        
+        ChangeLogEntry entry;
+        entry.seq = query->value(0).toLongLong();
+        entry.operation = operations.value(query->value(1).toString(), ChangeLogEntry::Update);
+        entry.contact = Contact(payload.value("name").toString(),
+                                payload.value("phone").toString(),
+                                payload.value("email").toString());
+        entry.contact.setId(query->value(2).toInt());
+        entry.changedAt = query->value(4).toString();
+        changes.append(entry);
+    }
+    query->finish();
+    
+    return changes;
+}
+
+qint64 Database::lastChangeSeq() const {
+    if (!isConnected()) {
+        return 0;
+    }
+    
+    QSqlQuery query(connection());
+    if (!query.exec("SELECT MAX(seq) FROM contact_changes") || !query.next()) {
+        logError("lastChangeSeq", query);
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+int Database::compactChangeLog(qint64 throughSeq) {
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return -1;
+    }
+    
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM contact_changes WHERE seq <= ? AND seq NOT IN "
+                  "(SELECT MAX(seq) FROM contact_changes WHERE seq <= ? GROUP BY contact_id)");
+    query.addBindValue(throughSeq);
+    query.addBindValue(throughSeq);
+    
+    if (!query.exec()) {
+        logError("compactChangeLog", query);
+        return -1;
+    }
+    return query.numRowsAffected();
+}
+
+int Database::truncateChangeLog(qint64 throughSeq) {
+    if (!isConnected()) {
+        emit databaseError("Database is not connected");
+        return -1;
+    }
+    
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM contact_changes WHERE seq <= ?");
+    query.addBindValue(throughSeq);
+    
+    if (!query.exec()) {
+        logError("truncateChangeLog", query);
+        return -1;
+    }
+    return query.numRowsAffected();
+}
+
+QStringList Database::explainQueryPlan(const QString& sql, const QVariantList& bindValues) const {
+    QStringList plan;
+    if (!isConnected()) {
+        return plan;
+    }
+    
+    QSqlQuery query(connection());
+    query.setForwardOnly(true);
+    if (!query.prepare("EXPLAIN QUERY PLAN " + sql)) {
+        logError("explainQueryPlan", query);
+        return plan;
+    }
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query.bindValue(i, bindValues[i]);
+    }
+    
+    if (!query.exec()) {
+        logError("explainQueryPlan", query);
+        return plan;
+    }
+    
+    // Columns: id, parent, notused, detail
+    while (query.next()) {
+        plan.append(query.value(3).toString());
+    }
+    
+    return plan;
 }
 
 bool Database::executeQuery(const QString& queryString) {
@@ -272,86 +1019,270 @@ bool Database::executeQuery(const QString& queryString) {
     return true;
 }
 
-bool Database::createTables() {
+bool Database::applyPerformanceProfile() {
     QSqlQuery query(m_database);
     
-    QString createContactsTable = R"(
-        CREATE TABLE IF NOT EXISTS contacts (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL,
-            phone TEXT NOT NULL,
-            email TEXT,
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        )
-    )";
-    
-    if (!query.exec(createContactsTable)) {
-        logError("createTables", query);
-        return false;
-    }
-    
-    // Create indexes for better search performance
-    QString createNameIndex = "CREATE INDEX IF NOT EXISTS idx_contacts_name ON contacts (name)";
-    if (!query.exec(createNameIndex)) {
-        logError("createNameIndex", query);
-        return false;
+    for (const QString& pragma : m_profile.pragmas()) {
+        if (!query.exec(pragma)) {
+            logError("applyPerformanceProfile", query);
+            return false;
+        }
     }
     
-    QString createPhoneIndex = "CREATE INDEX IF NOT EXISTS idx_contacts_phone ON contacts (phone)";
-    if (!query.exec(createPhoneIndex)) {
-        logError("createPhoneIndex", query);
-        return false;
+    // journal_mode reports the mode actually in effect; in-memory databases
+    // cannot use WAL, for example
+    QString journalMode = pragmaValue("journal_mode").toString();
+    if (journalMode.compare(m_profile.journalMode, Qt::CaseInsensitive) != 0) {
+        qWarning() << "Requested journal mode" << m_profile.journalMode << "but SQLite is using" << journalMode;
     }
     
     return true;
 }
 
-bool Database::executeMigrations() {
-    // Check if migrations.sql file exists and execute it
-    QString migrationsPath = QDir::currentPath() + "/src/db/migrations.sql";
-    QFile migrationsFile(migrationsPath);
+bool Database::createFullTextIndex() {
+    QSqlQuery query(m_database);
     
-    if (!migrationsFile.exists()) {
-        // No migrations file, that's okay
-        return true;
+    if (!query.exec("SELECT COUNT(*) FROM sqlite_master WHERE name IN "
+                    "('contacts_fts', 'contacts_fts_insert', 'contacts_fts_delete', 'contacts_fts_update')")) {
+        logError("createFullTextIndex", query);
+        return false;
     }
+    const bool complete = query.next() && query.value(0).toInt() == 4;
+    query.finish();
     
-    if (!migrationsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "Could not open migrations file:" << migrationsPath;
-        return true; // Not critical
+    // The table and its triggers are created together, so a warm start
+    // stops here; anything less is finished and rebuilt below
+    if (complete) {
+        return true;
     }
     
-    QTextStream in(&migrationsFile);
-    QString migrations = in.readAll();
+    // External-content table: the index stores trigrams only and reads
+    // column values back from contacts
+    const QString createTable = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS contacts_fts USING fts5(
+            name, phone, email,
+            content = 'contacts', content_rowid = 'id',
+            tokenize = 'trigram'
+        )
+    )";
+    
+    const QStringList triggers = {
+        R"(CREATE TRIGGER IF NOT EXISTS contacts_fts_insert AFTER INSERT ON contacts BEGIN
+               INSERT INTO contacts_fts (rowid, name, phone, email)
+               VALUES (new.id, new.name, new.phone, new.email);
+           END)",
+        R"(CREATE TRIGGER IF NOT EXISTS contacts_fts_delete AFTER DELETE ON contacts BEGIN
+               INSERT INTO contacts_fts (contacts_fts, rowid, name, phone, email)
+               VALUES ('delete', old.id, old.name, old.phone, old.email);
+           END)",
+        R"(CREATE TRIGGER IF NOT EXISTS contacts_fts_update AFTER UPDATE OF name, phone, email ON contacts BEGIN
+               INSERT INTO contacts_fts (contacts_fts, rowid, name, phone, email)
+               VALUES ('delete', old.id, old.name, old.phone, old.email);
+               INSERT INTO contacts_fts (rowid, name, phone, email)
+               VALUES (new.id, new.name, new.phone, new.email);
+           END)"
+    };
     
-    if (migrations.isEmpty()) {
+    // All or nothing, so an interrupted setup is never mistaken for a
+    // finished one on the next start
+    return runInTransaction([&]() {
+        if (!query.exec(createTable)) {
+            // FTS5 or the trigram tokenizer (SQLite 3.34+) is unavailable
+            qWarning() << "Full-text search unavailable, using LIKE scans:" << query.lastError().text();
+            return false;
+        }
+        
+        for (const QString& trigger : triggers) {
+            if (!query.exec(trigger)) {
+                logError("createFullTextIndex", query);
+                return false;
+            }
+        }
+        
+        // Rows written before the index or without its triggers: build it
+        // from the table
+        if (!query.exec("INSERT INTO contacts_fts (contacts_fts) VALUES ('rebuild')")) {
+            logError("rebuildFullTextIndex", query);
+            return false;
+        }
         return true;
-    }
+    });
+}
+
+int Database::schemaVersion() const {
+    QVariant version = pragmaValue("user_version");
+    return version.isValid() ? version.toInt() : -1;
+}
+
+int Database::latestSchemaVersion() {
+    const QList<Migration> all = migrations();
+    return all.isEmpty() ? 0 : all.last().version;
+}
+
+QList<Database::Migration> Database::migrations() {
+    initMigrationResources();
     
-    // Execute migrations (simple approach - split by semicolon)
-    QStringList migrationQueries = migrations.split(';', Qt::SkipEmptyParts);
+    // Files are named NNNN_description.sql; the number is the version
+    QList<Migration> migrations;
+    QDir dir(MIGRATIONS_PATH);
+    for (const QString& fileName : dir.entryList({"*.sql"}, QDir::Files, QDir::Name)) {
+        bool ok = false;
+        int version = fileName.section('_', 0, 0).toInt(&ok);
+        if (!ok || version <= 0) {
+            qWarning() << "Ignoring migration with no version number:" << fileName;
+            continue;
+        }
+        
+        QFile file(dir.filePath(fileName));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "Could not read migration" << fileName;
+            continue;
+        }
+        migrations.append({version, fileName, QString::fromUtf8(file.readAll())});
+    }
+    return migrations;
+}
+
+bool Database::applyMigrations() {
+    int current = schemaVersion();
+    if (current < 0) {
+        return false;
+    }
     
-    for (const QString& migrationQuery : migrationQueries) {
-        QString trimmedQuery = migrationQuery.trimmed();
-        if (!trimmedQuery.isEmpty()) {
-            if (!executeQuery(trimmedQuery)) {
-                qWarning() << "Failed to execute migration:" << trimmedQuery;
-                // Continue with other migrations
+    for (const Migration& migration : migrations()) {
+        if (migration.version <= current) {
+            continue;
+        }
+        
+        // Each migration commits with its version number or not at all;
+        // user_version lives in the file header, so it is transactional
+        bool ok = runInTransaction([&]() {
+            QSqlQuery query(m_database);
+            for (const QString& statement : splitSqlStatements(migration.script)) {
+                if (!query.exec(statement)) {
+                    logError("migration " + migration.name, query);
+                    return false;
+                }
             }
+            return query.exec(QString("PRAGMA user_version = %1").arg(migration.version));
+        });
+        
+        if (!ok) {
+            emit databaseError(QString("Migration %1 failed").arg(migration.name));
+            return false;
         }
+        current = migration.version;
     }
     
     return true;
 }
 
+QStringList Database::splitSqlStatements(const QString& script) {
+    QStringList statements;
+    QString current;
+    QString word;
+    QString firstWord;
+    int wordCount = 0;
+    bool inTrigger = false;    // CREATE [TEMP] TRIGGER ... BEGIN ... END
+    int blockDepth = 0;        // Open BEGIN/CASE blocks inside a trigger
+    
+    auto endWord = [&]() {
+        if (word.isEmpty()) {
+            return;
+        }
+        const QString upper = word.toUpper();
+        if (++wordCount == 1) {
+            firstWord = upper;
+        }
+        if (firstWord == "CREATE" && upper == "TRIGGER" && wordCount <= 3) {
+            inTrigger = true;
+        }
+        if (inTrigger && (upper == "BEGIN" || upper == "CASE")) {
+            blockDepth++;
+        } else if (inTrigger && upper == "END") {
+            blockDepth--;
+        }
+        word.clear();
+    };
+    
+    auto endStatement = [&]() {
+        const QString statement = current.trimmed();
+        if (!statement.isEmpty()) {
+            statements.append(statement);
+        }
+        current.clear();
+        firstWord.clear();
+        wordCount = 0;
+        inTrigger = false;
+        blockDepth = 0;
+    };
+    
+    const int length = script.size();
+    int i = 0;
+    while (i < length) {
+        const QChar ch = script[i];
+        const QChar next = i + 1 < length ? script[i + 1] : QChar();
+        
+        // Comments are dropped; a space keeps the tokens around them apart
+        if (ch == '-' && next == '-') {
+            endWord();
+            int end = script.indexOf('\n', i);
+            i = end < 0 ? length : end;
+            current += ' ';
+            continue;
+        }
+        if (ch == '/' && next == '*') {
+            endWord();
+            int end = script.indexOf("*/", i + 2);
+            i = end < 0 ? length : end + 2;
+            current += ' ';
+            continue;
+        }
+        
+        // Quoted strings and identifiers are copied whole; a doubled quote
+        // just closes and reopens
+        if (ch == '\'' || ch == '"' || ch == '`' || ch == '[') {
+            endWord();
+            const QChar close = ch == '[' ? QChar(']') : ch;
+            int end = script.indexOf(close, i + 1);
+            end = end < 0 ? length - 1 : end;
+            current += script.mid(i, end - i + 1);
+            i = end + 1;
+            continue;
+        }
+        
+        if (ch.isLetterOrNumber() || ch == '_' || ch == '$') {
+            word += ch;
+            current += ch;
+            i++;
+            continue;
+        }
+        
+        endWord();
+        if (ch == ';' && blockDepth == 0) {
+            endStatement();
+        } else {
+            current += ch;
+        }
+        i++;
+    }
+    
+    endWord();
+    endStatement();
+    return statements;
+}
+
 QString Database::getDefaultDatabasePath() const {
     QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     return dataPath + "/" + DATABASE_NAME;
 }
 
 void Database::logError(const QString& operation, const QSqlQuery& query) const {
-    QString error = QString("%1 failed: %2").arg(operation).arg(query.lastError().text());
-    emit const_cast<Database*>(this)->databaseError(error);
-    qWarning() << error;
+    logError(operation, query.lastError());
+}
+
+void Database::logError(const QString& operation, const QSqlError& error) const {
+    QString message = QString("%1 failed: %2").arg(operation).arg(error.text());
+    emit const_cast<Database*>(this)->databaseError(message);
+    qWarning() << message;
 }
@@ -6,18 +6,97 @@
 #include <QSqlQuery>
 #include <QString>
 #include <QList>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+#include <QVariant>
+#include <functional>
+#include <memory>
 #include "core/Contact.h"
 
+class QSqlError;
+class QThread;
+
+// Position in case-insensitive (name, id) order for keyset pagination;
+// the default value starts from the first contact
+struct PageKey {
+    QString name;
+    int id = 0;
+    
+    bool isStart() const { return name.isNull() && id == 0; }
+};
+
+// One entry of the contact_changes log. seq increases with every change;
+// gaps appear after compaction.
+struct ChangeLogEntry {
+    enum Operation {
+        Insert,
+        Update,
+        Delete
+    };
+    
+    qint64 seq = 0;
+    Operation operation = Insert;
+    Contact contact;      // The row after the change; the removed row for a delete
+    QString changedAt;
+};
+
+// SQLite settings applied when the connection opens
+struct PerformanceProfile {
+    enum Synchronous {
+        SyncOff,
+        SyncNormal,    // With WAL, durable across crashes but not power loss
+        SyncFull
+    };
+    
+    QString journalMode = "WAL";    // Readers no longer block the writer
+    Synchronous synchronous = SyncFull;
+    int cacheSizeKiB = 8192;
+    qint64 mmapSizeBytes = 0;
+    bool tempStoreInMemory = false;
+    int busyTimeoutMs = 5000;
+    
+    // Presets: every commit fully synced, or fewer syncs and more memory
+    static PerformanceProfile durable();
+    static PerformanceProfile fast();
+    
+    QStringList pragmas() const;
+    QStringList connectionPragmas() const;  // Everything except the database-wide journal_mode
+};
+
+// Outcome of a bulk write. The whole batch runs in one transaction, so on
+// failure nothing was written; inside an outer runInTransaction() the
+// failure also rolls that transaction back.
+struct BulkWriteResult {
+    bool success = false;
+    int rowsAffected = 0;
+    qint64 elapsedMs = 0;
+    
+    double rowsPerSecond() const;
+};
+
 class Database : public QObject {
     Q_OBJECT
     
 public:
     explicit Database(QObject* parent = nullptr);
+    // Several Database objects may be open at once if each has its own name
+    explicit Database(const QString& connectionName, QObject* parent = nullptr);
     ~Database();
     
     // Database management
     bool initialize(const QString& databasePath = "");
+    void setPerformanceProfile(const PerformanceProfile& profile);  // Takes effect on initialize()
+    PerformanceProfile performanceProfile() const;
+    QVariant pragmaValue(const QString& pragma) const;
+    
+    // Reads may run on any thread: each thread lazily gets its own
+    // connection. Writes must come from the thread that called initialize().
+    int readerConnectionCount() const;
+    int cachedStatementCount() const;   // On the calling thread's connection
     bool isConnected() const;
+    QString databasePath() const;
     void close();
     
     // Contact operations
@@ -26,30 +105,129 @@ public:
     bool deleteContact(int contactId);
     Contact getContact(int contactId) const;
     QList<Contact> getAllContacts() const;
+    
+    // Flat-memory reads in (name, id) order. Pass the returned next key to
+    // fetch the following page; an empty page means the end, and leaves
+    // next at after. forEachContact stops when callback returns false.
+    QList<Contact> getContactsPage(const PageKey& after, int limit, PageKey* next = nullptr) const;
+    bool forEachContact(const std::function<bool(const Contact&)>& callback) const;
     QList<Contact> searchContacts(const QString& query) const;
+    QList<Contact> getContactsByPhone(const QString& phone) const;
+    bool hasFullTextSearch() const;
+    
+    // Bulk operations: one transaction and one prepared statement per call
+    // Inserts under new ids from the table; pass insertedIds to get them
+    // back in the order of contacts
+    BulkWriteResult saveContacts(const QList<Contact>& contacts, QList<int>* insertedIds = nullptr);
+    BulkWriteResult updateContacts(const QList<Contact>& contacts);
+    BulkWriteResult deleteContacts(const QList<int>& contactIds);
+    // Writes contacts under their own ids, inserting or replacing as needed.
+    // Only for ids the table handed out: a client-side id may belong to
+    // another writer's row by now.
+    BulkWriteResult upsertContacts(const QList<Contact>& contacts);
+    
+    // Incremental reads keyed on updated_at. Timestamps have one-second
+    // resolution, so pass the last watermark and expect some overlap.
+    QList<Contact> getContactsUpdatedSince(const QString& timestamp) const;
+    QString lastUpdatedAt() const;
+    
+    // Runs work in a transaction, committing only if it returns true. Nested
+    // calls join the outer transaction; if one fails, the outer transaction
+    // rolls back even when its own work returns true.
+    bool runInTransaction(const std::function<bool()>& work);
     
     // Utility methods
     bool clearAllContacts();
     int getContactCount() const;
+    
+    // Trigger-maintained counters: contacts per uppercased first letter of
+    // the name and per lowercased email domain. Reading them is O(keys).
+    QMap<QString, int> getLetterCounts() const;
+    QMap<QString, int> getDomainCounts() const;
+    
+    // Change-data-capture log kept by triggers on contacts. Consumers read
+    // in batches from the last seq they applied and must apply an update as
+    // an upsert: compactChangeLog() keeps only the newest entry per contact
+    // up to a seq, so a contact inserted in that range may be left with just
+    // an update. Applied that way, the survivors replay the final state.
+    // truncateChangeLog() drops entries every consumer has applied. Both
+    // return the number removed, or -1.
+    QList<ChangeLogEntry> getChangesSince(qint64 afterSeq, int limit = 1000) const;
+    qint64 lastChangeSeq() const;
+    int compactChangeLog(qint64 throughSeq);
+    int truncateChangeLog(qint64 throughSeq);
+    
     bool executeQuery(const QString& query);
     
+    // Schema version is PRAGMA user_version: the number of the last
+    // migration applied. initialize() brings it up to latestSchemaVersion().
+    int schemaVersion() const;
+    static int latestSchemaVersion();
+    // Splits a script on ';', keeping trigger bodies, strings and comments intact
+    static QStringList splitSqlStatements(const QString& script);
+    
+    // Detail lines of EXPLAIN QUERY PLAN, for checking index use
+    QStringList explainQueryPlan(const QString& sql, const QVariantList& bindValues = QVariantList()) const;
+    
 signals:
     void databaseError(const QString& error);
     void contactSaved(const Contact& contact);
     void contactUpdated(const Contact& contact);
     void contactDeleted(int contactId);
+    void contactsSaved(int count);
+    void contactsUpdated(int count);
+    void contactsDeleted(int count);
     
 private:
-    bool createTables();
-    bool executeMigrations();
+    // Prepared statements keyed by SQL text. Queries live on the heap so
+    // pointers stay valid while the pool rehashes.
+    using StatementCache = QHash<QString, std::shared_ptr<QSqlQuery>>;
+    
+    struct ConnectionSlot {
+        QString name;
+        QSqlDatabase database;
+        std::shared_ptr<StatementCache> statements = std::make_shared<StatementCache>();
+    };
+    
+    QSqlDatabase connection() const;
+    QSqlQuery* cachedQuery(const QString& sql) const;
+    void releaseConnection(QThread* thread) const;
+    bool applyPerformanceProfile();
+    bool createFullTextIndex();
+    QList<Contact> searchFullText(const QString& searchQuery) const;
+    // A numbered script from resources/migrations
+    struct Migration {
+        int version;
+        QString name;
+        QString script;
+    };
+    
+    static QList<Migration> migrations();
+    bool applyMigrations();
     QString getDefaultDatabasePath() const;
+    QMap<QString, int> statsWithPrefix(const QString& prefix) const;
+    static Contact contactFromRow(const QSqlQuery& query);
     void logError(const QString& operation, const QSqlQuery& query) const;
+    void logError(const QString& operation, const QSqlError& error) const;
     
     QSqlDatabase m_database;
+    QString m_connectionName;
     QString m_databasePath;
     bool m_isInitialized;
+    bool m_inTransaction;
+    bool m_rollbackOnly;    // A nested runInTransaction() failed
+    PerformanceProfile m_profile;
+    QThread* m_ownerThread;
+    mutable QHash<QThread*, ConnectionSlot> m_pool;
+    mutable QMutex m_poolMutex;
+    mutable StatementCache m_statements;    // Owner thread's connection
+    bool m_hasFullTextSearch;
+    
+    // Trigram tokens need at least this many characters to match
+    static const int MIN_FULL_TEXT_QUERY = 3;
     
     static const QString DATABASE_NAME;
+    static const QString MIGRATIONS_PATH;
     static const QString CONNECTION_NAME;
 };
 
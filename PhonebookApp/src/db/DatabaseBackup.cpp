@@ -0,0 +1,271 @@
+#include "DatabaseBackup.h"
+#include "utils/Config.h"
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QDebug>
+
+// Only defined when QSQLITE is built against the same system library, so
+// the backup API can drive the driver's own connections
+#ifdef PHONEBOOK_HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
+DatabaseBackup::DatabaseBackup(QObject* parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_cancelled(0) {
+}
+
+DatabaseBackup::~DatabaseBackup() {
+    cancel();
+    wait();
+    delete m_thread;
+}
+
+bool DatabaseBackup::backup(const QString& databasePath, const QString& backupPath) {
+    return backup(databasePath, backupPath, Options());
+}
+
+bool DatabaseBackup::backup(const QString& databasePath, const QString& backupPath, const Options& options) {
+    return start(databasePath, backupPath, false, options);
+}
+
+bool DatabaseBackup::restore(const QString& backupPath, const QString& databasePath) {
+    return restore(backupPath, databasePath, Options());
+}
+
+bool DatabaseBackup::restore(const QString& backupPath, const QString& databasePath, const Options& options) {
+    return start(backupPath, databasePath, true, options);
+}
+
+void DatabaseBackup::cancel() {
+    m_cancelled.storeRelaxed(1);
+}
+
+bool DatabaseBackup::isRunning() const {
+    return m_thread && !m_thread->isFinished();
+}
+
+bool DatabaseBackup::wait(int timeoutMs) {
+    return !m_thread || m_thread->wait(QDeadlineTimer(timeoutMs));
+}
+
+QString DatabaseBackup::defaultBackupPath(const QString& databasePath) {
+    QFileInfo info(databasePath);
+    return info.absolutePath() + '/' + info.completeBaseName() + '-' +
+           QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + '.' + Config::BACKUP_FILE_EXTENSION;
+}
+
+bool DatabaseBackup::start(const QString& from, const QString& to, bool restoring, const Options& options) {
+    if (isRunning()) {
+        return false;
+    }
+    if (!QFileInfo::exists(from)) {
+        qWarning() << "Nothing to copy from" << from;
+        return false;
+    }
+
+    delete m_thread;
+    m_cancelled.storeRelaxed(0);
+
+    m_thread = QThread::create([this, from, to, restoring, options]() {
+        // A backup lands in a .part file so a cancelled or failed run never
+        // leaves a truncated backup behind; a restore writes in place
+        const QString target = restoring ? to : to + ".part";
+        QString error;
+#ifdef PHONEBOOK_HAVE_SQLITE3
+        error = copyPages(from, target, options);
+#else
+        Q_UNUSED(options);
+        if (!restoring) {
+            QFile::remove(target);    // VACUUM INTO refuses an existing file
+        }
+        error = restoring ? copyRows(from, to) : vacuumInto(from, target);
+#endif
+        if (!restoring) {
+            if (error.isEmpty() && ((QFile::exists(to) && !QFile::remove(to)) || !QFile::rename(target, to))) {
+                error = "Could not move the backup into place";
+            }
+            if (!error.isEmpty()) {
+                QFile::remove(target);
+            }
+        }
+
+        if (!error.isEmpty()) {
+            qWarning() << (restoring ? "Restore" : "Backup") << "failed:" << error;
+        }
+        emit finished(error.isEmpty(), error);
+    });
+    m_thread->start();
+    return true;
+}
+
+#ifdef PHONEBOOK_HAVE_SQLITE3
+
+namespace {
+    // The QSQLITE driver's own connection; sqlite3_close() on a second
+    // connection to the same file would drop the POSIX locks it holds
+    sqlite3* sqliteHandle(const QSqlDatabase& database) {
+        const QVariant handle = database.driver()->handle();
+        if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) {
+            return nullptr;
+        }
+        return *static_cast<sqlite3* const*>(handle.constData());
+    }
+}
+
+QString DatabaseBackup::copyPages(const QString& from, const QString& to, const Options& options) {
+    const QString sourceName = QString("PhonebookBackupSource-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    const QString destinationName = QString("PhonebookBackupTarget-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    QString error;
+    {
+        QSqlDatabase sourceDatabase = QSqlDatabase::addDatabase("QSQLITE", sourceName);
+        sourceDatabase.setDatabaseName(from);
+        sourceDatabase.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", destinationName);
+        destinationDatabase.setDatabaseName(to);
+        destinationDatabase.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+        sqlite3* source = nullptr;
+        sqlite3* destination = nullptr;
+        if (!sourceDatabase.open()) {
+            error = sourceDatabase.lastError().text();
+        } else if (!destinationDatabase.open()) {
+            error = destinationDatabase.lastError().text();
+        } else {
+            source = sqliteHandle(sourceDatabase);
+            destination = sqliteHandle(destinationDatabase);
+            if (!source || !destination) {
+                error = "The SQLite driver exposes no handle";
+            }
+        }
+
+        if (error.isEmpty()) {
+            // A backup restarts whenever another connection writes the source,
+            // so under steady writes it might never finish. An open read
+            // transaction pins one WAL snapshot for every step while writers
+            // carry on.
+            QSqlQuery pin(sourceDatabase);
+            pin.exec("BEGIN");
+            pin.exec("SELECT COUNT(*) FROM sqlite_master");
+            pin.finish();
+
+            sqlite3_backup* backup = sqlite3_backup_init(destination, "main", source, "main");
+            if (!backup) {
+                error = QString::fromUtf8(sqlite3_errmsg(destination));
+            } else {
+                int rc = SQLITE_OK;
+                while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                    if (m_cancelled.loadRelaxed()) {
+                        error = "Cancelled";
+                        break;
+                    }
+
+                    rc = sqlite3_backup_step(backup, options.pagesPerStep);
+                    const int pageCount = sqlite3_backup_pagecount(backup);
+                    emit progress(pageCount - sqlite3_backup_remaining(backup), pageCount);
+
+                    // The destination stays write-locked until the last step, so
+                    // a cancelled restore rolls back; the source lock is released
+                    if (rc != SQLITE_DONE) {
+                        QThread::msleep(options.stepDelayMs);
+                    }
+                }
+
+                if (sqlite3_backup_finish(backup) != SQLITE_OK && error.isEmpty()) {
+                    error = QString::fromUtf8(sqlite3_errmsg(destination));
+                } else if (rc != SQLITE_DONE && error.isEmpty()) {
+                    error = QString::fromUtf8(sqlite3_errstr(rc));
+                }
+            }
+
+            pin.exec("COMMIT");
+        }
+
+        sourceDatabase.close();
+        destinationDatabase.close();
+    }
+    QSqlDatabase::removeDatabase(sourceName);
+    QSqlDatabase::removeDatabase(destinationName);
+    return error;
+}
+
+#else
+
+QString DatabaseBackup::vacuumInto(const QString& from, const QString& to) {
+    const QString name = QString("PhonebookBackup-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", name);
+        database.setDatabaseName(from);
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            // One consistent snapshot in a single statement (SQLite 3.27+);
+            // there are no steps to report, so progress jumps to the end
+            emit progress(0, 1);
+            QSqlQuery query(database);
+            query.prepare("VACUUM INTO ?");
+            query.addBindValue(to);
+            if (!query.exec()) {
+                error = query.lastError().text();
+            } else {
+                emit progress(1, 1);
+            }
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    return error;
+}
+
+QString DatabaseBackup::copyRows(const QString& from, const QString& to) {
+    const QString name = QString("PhonebookRestore-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", name);
+        database.setDatabaseName(to);
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            // Replaces the rows but keeps the live schema; the triggers keep
+            // the stats and search index in step
+            emit progress(0, 1);
+            QSqlQuery query(database);
+            query.prepare("ATTACH DATABASE ? AS backup");
+            query.addBindValue(from);
+
+            const QStringList statements = {
+                "BEGIN IMMEDIATE",
+                "DELETE FROM main.contacts",
+                "INSERT INTO main.contacts (id, name, phone, email, created_at, updated_at) "
+                "SELECT id, name, phone, email, created_at, updated_at FROM backup.contacts",
+                "COMMIT"
+            };
+
+            bool ok = query.exec();
+            for (int i = 0; ok && i < statements.size(); ++i) {
+                ok = query.exec(statements[i]);
+            }
+            if (!ok) {
+                error = query.lastError().text();
+                query.exec("ROLLBACK");
+            } else {
+                emit progress(1, 1);
+            }
+            query.exec("DETACH DATABASE backup");
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    return error;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef DATABASEBACKUP_H
+#define DATABASEBACKUP_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QString>
+
+class QThread;
+
+// Online backup and restore of the SQLite file on a background thread. When
+// Qt's SQLite driver uses the system SQLite library it runs the backup API
+// on the driver's connections, copying a few pages per step and pausing
+// between steps so writers are never held up for long; otherwise it falls
+// back to VACUUM INTO and an ATTACH-and-copy restore.
+// Backups are written to a .part file and renamed once complete; a restore
+// commits as a whole or not at all.
+class DatabaseBackup : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        int pagesPerStep = 64;
+        int stepDelayMs = 5;
+    };
+
+    explicit DatabaseBackup(QObject* parent = nullptr);
+    ~DatabaseBackup();    // Cancels a running job and waits for it
+
+    // Return false if a job is already running; the outcome arrives through
+    // finished()
+    bool backup(const QString& databasePath, const QString& backupPath);
+    bool backup(const QString& databasePath, const QString& backupPath, const Options& options);
+    bool restore(const QString& backupPath, const QString& databasePath);
+    bool restore(const QString& backupPath, const QString& databasePath, const Options& options);
+
+    void cancel();
+    bool isRunning() const;
+    bool wait(int timeoutMs = -1);
+
+    // <database>-<timestamp>.<Config::BACKUP_FILE_EXTENSION> next to the database
+    static QString defaultBackupPath(const QString& databasePath);
+
+signals:
+    void progress(int pagesCopied, int pageCount);
+    void finished(bool success, const QString& error);
+
+private:
+    bool start(const QString& from, const QString& to, bool restoring, const Options& options);
+    // Each returns an error message, or an empty string on success
+#ifdef PHONEBOOK_HAVE_SQLITE3
+    QString copyPages(const QString& from, const QString& to, const Options& options);
+#else
+    QString vacuumInto(const QString& from, const QString& to);
+    QString copyRows(const QString& from, const QString& to);
+#endif
+
+    QThread* m_thread;
+    QAtomicInt m_cancelled;
+};
+
+#endif // DATABASEBACKUP_H
@@ -0,0 +1,227 @@
+#include "DatabaseWriter.h"
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QDebug>
+
+DatabaseWriter::DatabaseWriter(QObject* parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_sequence(0)
+    , m_committedSeq(0)
+    , m_flushWaiters(0)
+    , m_stopping(false)
+    , m_started(false)
+    , m_startOk(false) {
+}
+
+DatabaseWriter::~DatabaseWriter() {
+    stop();
+}
+
+bool DatabaseWriter::start(const QString& databasePath) {
+    return start(databasePath, Options());
+}
+
+bool DatabaseWriter::start(const QString& databasePath, const Options& options) {
+    if (m_thread) {
+        return isRunning();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+        m_started = false;
+        m_startOk = false;
+    }
+
+    m_thread = QThread::create([this, databasePath, options]() {
+        run(databasePath, options);
+    });
+    m_thread->start();
+
+    // Wait for the worker to report whether its connection opened
+    QMutexLocker locker(&m_mutex);
+    while (!m_started) {
+        m_committedChanged.wait(&m_mutex);
+    }
+
+    if (!m_startOk) {
+        locker.unlock();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void DatabaseWriter::stop() {
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_workAvailable.wakeAll();
+    }
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool DatabaseWriter::isRunning() const {
+    QMutexLocker locker(&m_mutex);
+    return m_thread && m_startOk && !m_stopping;
+}
+
+void DatabaseWriter::saveContact(const Contact& contact) {
+    QMutexLocker locker(&m_mutex);
+    m_inserts.append(contact);
+    enqueued();
+}
+
+void DatabaseWriter::updateContact(const Contact& contact) {
+    QMutexLocker locker(&m_mutex);
+    if (m_deletes.contains(contact.getId())) {
+        // The row is about to be deleted; the update can never apply
+        m_stats.coalesced++;
+    } else {
+        auto it = m_updates.find(contact.getId());
+        if (it != m_updates.end()) {
+            *it = contact;
+            m_stats.coalesced++;
+        } else {
+            m_updates.insert(contact.getId(), contact);
+        }
+    }
+    enqueued();
+}
+
+void DatabaseWriter::deleteContact(int contactId) {
+    QMutexLocker locker(&m_mutex);
+    if (m_updates.remove(contactId) > 0) {
+        m_stats.coalesced++;
+    }
+    if (m_deletes.contains(contactId)) {
+        m_stats.coalesced++;
+    } else {
+        m_deletes.insert(contactId);
+    }
+    enqueued();
+}
+
+bool DatabaseWriter::flush(int timeoutMs) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_thread || !m_startOk) {
+        return false;
+    }
+
+    const quint64 target = m_sequence;
+    const quint64 failuresBefore = m_stats.failedBatches;
+    QDeadlineTimer deadline(timeoutMs);    // Negative never expires
+
+    // Waiters make the worker commit now instead of at the next interval
+    m_flushWaiters++;
+    m_workAvailable.wakeAll();
+    while (m_committedSeq < target) {
+        if (!m_committedChanged.wait(&m_mutex, deadline)) {
+            break;
+        }
+    }
+    m_flushWaiters--;
+
+    return m_committedSeq >= target && m_stats.failedBatches == failuresBefore;
+}
+
+int DatabaseWriter::pendingOperations() const {
+    QMutexLocker locker(&m_mutex);
+    return pendingLocked();
+}
+
+DatabaseWriter::Stats DatabaseWriter::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.committed = m_committedSeq;
+    return stats;
+}
+
+void DatabaseWriter::run(const QString& databasePath, const Options& options) {
+    // Owned by this thread, so every write happens here
+    Database database(QString("PhonebookWriter-%1").arg(reinterpret_cast<quintptr>(this), 0, 16));
+    database.setPerformanceProfile(options.profile);
+    connect(&database, &Database::databaseError, this, &DatabaseWriter::writeFailed, Qt::DirectConnection);
+    const bool opened = database.initialize(databasePath);
+
+    QMutexLocker locker(&m_mutex);
+    m_started = true;
+    m_startOk = opened;
+    m_committedChanged.wakeAll();
+    if (!opened) {
+        return;
+    }
+
+    forever {
+        while (!m_stopping && pendingLocked() == 0) {
+            m_workAvailable.wait(&m_mutex);
+        }
+        if (pendingLocked() == 0) {
+            break;    // Stopping with nothing left to write
+        }
+
+        // Group commit: let the batch grow until the interval passes, it is
+        // full, or someone needs it durable now
+        QDeadlineTimer deadline(options.commitIntervalMs);
+        while (!m_stopping && m_flushWaiters == 0 &&
+               pendingLocked() < options.maxBatchOps && !deadline.hasExpired()) {
+            m_workAvailable.wait(&m_mutex, deadline);
+        }
+
+        QList<Contact> inserts;
+        QList<Contact> updates = m_updates.values();
+        QList<int> deletes = m_deletes.values();
+        inserts.swap(m_inserts);
+        m_updates.clear();
+        m_deletes.clear();
+        const quint64 batchSeq = m_sequence;
+        const int operations = inserts.size() + updates.size() + deletes.size();
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = database.runInTransaction([&]() {
+            return (inserts.isEmpty() || database.saveContacts(inserts).success) &&
+                   (updates.isEmpty() || database.updateContacts(updates).success) &&
+                   (deletes.isEmpty() || database.deleteContacts(deletes).success);
+        });
+        const qint64 elapsed = timer.elapsed();
+
+        locker.relock();
+        m_stats.batches++;
+        if (!ok) {
+            m_stats.failedBatches++;
+            qWarning() << "DatabaseWriter dropped a batch of" << operations << "operation(s)";
+        }
+        m_committedSeq = batchSeq;
+        m_committedChanged.wakeAll();
+
+        if (ok) {
+            locker.unlock();
+            emit batchCommitted(operations, elapsed);
+            locker.relock();
+        }
+    }
+}
+
+int DatabaseWriter::pendingLocked() const {
+    return m_inserts.size() + m_updates.size() + m_deletes.size();
+}
+
+void DatabaseWriter::enqueued() {
+    m_sequence++;
+    m_stats.enqueued++;
+    m_workAvailable.wakeOne();
+}
@@ -0,0 +1,94 @@
+#ifndef DATABASEWRITER_H
+#define DATABASEWRITER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+#include "core/Contact.h"
+#include "db/Database.h"
+
+class QThread;
+
+// Write-behind front end for Database. Mutations return as soon as they are
+// queued; a dedicated thread that owns its own connection applies them in
+// group transactions, committing every commitIntervalMs or maxBatchOps
+// operations, whichever comes first. Updates to the same id coalesce into
+// the last one, and a delete drops any pending update for its id.
+//
+// For callers that already own their ids and can live with fire-and-forget
+// writes. ContactSync does not use it: a new contact must adopt the id the
+// table hands out, and a failed persist returns its changes to the manager
+// for the next attempt, neither of which the queue can report back.
+class DatabaseWriter : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        int commitIntervalMs = 50;
+        int maxBatchOps = 1000;
+        PerformanceProfile profile = PerformanceProfile::durable();
+    };
+
+    struct Stats {
+        quint64 enqueued = 0;     // Operations accepted
+        quint64 coalesced = 0;    // Operations absorbed by a later one
+        quint64 committed = 0;    // Operations whose batch has finished
+        quint64 batches = 0;
+        quint64 failedBatches = 0;
+    };
+
+    explicit DatabaseWriter(QObject* parent = nullptr);
+    ~DatabaseWriter();
+
+    // Opens the writer connection on the worker thread
+    bool start(const QString& databasePath);
+    bool start(const QString& databasePath, const Options& options);
+    void stop();    // Commits everything queued, then joins the thread
+    bool isRunning() const;
+
+    // Queued mutations
+    void saveContact(const Contact& contact);
+    void updateContact(const Contact& contact);
+    void deleteContact(int contactId);
+
+    // Durability point: blocks until every operation queued before the call
+    // is committed. Returns false on timeout or if a batch failed meanwhile.
+    bool flush(int timeoutMs = -1);
+
+    int pendingOperations() const;
+    Stats stats() const;
+
+signals:
+    void batchCommitted(int operations, qint64 elapsedMs);
+    void writeFailed(const QString& error);
+
+private:
+    void run(const QString& databasePath, const Options& options);
+    int pendingLocked() const;
+    void enqueued();
+
+    QThread* m_thread;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_workAvailable;
+    QWaitCondition m_committedChanged;
+
+    // Pending batch
+    QList<Contact> m_inserts;
+    QHash<int, Contact> m_updates;
+    QSet<int> m_deletes;
+
+    Stats m_stats;
+    quint64 m_sequence;        // Sequence number of the last queued operation
+    quint64 m_committedSeq;    // Every operation up to here has been applied
+    int m_flushWaiters;
+    bool m_stopping;
+    bool m_started;
+    bool m_startOk;
+};
+
+#endif // DATABASEWRITER_H
@@ -16,6 +16,12 @@
 #include <QPushButton>
 #include <QTableWidget>
 #include <QTableWidgetItem>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <algorithm>
+#include "core/FileHandler.h"
+#include "core/ThreadPool.h"
+#include "utils/Config.h"
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -38,10 +44,16 @@ MainWindow::MainWindow(QWidget* parent)
     , m_statusBar(nullptr)
     , m_statusLabel(nullptr)
     , m_contactManager(nullptr)
+    , m_database(nullptr)
+    , m_sync(nullptr)
+    , m_backup(nullptr)
     , m_currentSelectedRow(-1)
     , m_isEditing(false) {
     
     m_contactManager = new ContactManager(this);
+    m_database = new Database(this);
+    m_sync = new ContactSync(m_contactManager, m_database, this);
+    m_backup = new DatabaseBackup(this);
     setupUI();
     setupMenuBar();
     setupStatusBar();
@@ -51,6 +63,14 @@ MainWindow::MainWindow(QWidget* parent)
     setMinimumSize(800, 600);
     resize(1000, 700);
     
+    // Without a database the phonebook still works, just in memory
+    if (m_database->initialize()) {
+        m_sync->loadAll();
+        m_sync->setAutoPersistInterval(Config::AUTO_PERSIST_INTERVAL);
+    } else {
+        showMessage("Database unavailable; contacts will not be saved");
+    }
+    
     updateStatusBar();
 }
 
@@ -100,7 +120,12 @@ void MainWindow::setupContactTable() {
     m_contactTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_contactTable->setSelectionMode(QAbstractItemView::SingleSelection);
     m_contactTable->setAlternatingRowColors(true);
-    m_contactTable->setSortingEnabled(true);
+    // Rows mirror ContactManager order so change notifications can be applied by row
+    // Header clicks switch ContactManager's active view instead
+    m_contactTable->setSortingEnabled(false);
+    m_contactTable->horizontalHeader()->setSectionsClickable(true);
+    m_contactTable->horizontalHeader()->setSortIndicatorShown(true);
+    m_contactTable->horizontalHeader()->setSortIndicator(0, Qt::AscendingOrder);
     m_contactTable->horizontalHeader()->setStretchLastSection(true);
     m_contactTable->verticalHeader()->setVisible(false);
     
@@ -158,7 +183,7 @@ void MainWindow::setupSearchBar() {
     m_searchButton = new QPushButton("Search", this);
     m_clearSearchButton = new QPushButton("Clear", this);
     
-    m_searchEdit->setPlaceholderText("Search contacts by name, phone, or email");
+    m_searchEdit->setPlaceholderText("Search contacts, e.g. name:ali phone:555* email:@corp.com");
 }
 
 void MainWindow::setupMenuBar() {
@@ -168,10 +193,15 @@ void MainWindow::setupMenuBar() {
     QAction* importAction = fileMenu->addAction("&Import Contacts...");
     QAction* exportAction = fileMenu->addAction("&Export Contacts...");
     fileMenu->addSeparator();
+    QAction* backupAction = fileMenu->addAction("&Backup Database...");
+    QAction* restoreAction = fileMenu->addAction("&Restore Database...");
+    fileMenu->addSeparator();
     QAction* exitAction = fileMenu->addAction("E&xit");
     
     connect(importAction, &QAction::triggered, this, &MainWindow::onImportContacts);
     connect(exportAction, &QAction::triggered, this, &MainWindow::onExportContacts);
+    connect(backupAction, &QAction::triggered, this, &MainWindow::onBackupDatabase);
+    connect(restoreAction, &QAction::triggered, this, &MainWindow::onRestoreDatabase);
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
     
     // Help menu
@@ -206,6 +236,15 @@ void MainWindow::setupConnections() {
     connect(m_contactManager, &ContactManager::contactRemoved, this, &MainWindow::onContactRemoved);
     connect(m_contactManager, &ContactManager::contactUpdated, this, &MainWindow::onContactUpdated);
     connect(m_contactManager, &ContactManager::contactsCleared, this, &MainWindow::onContactsCleared);
+    connect(m_contactManager, &ContactManager::contactsImported, this, &MainWindow::onContactsImported);
+    connect(m_contactManager, &ContactManager::contactsChanged, this, &MainWindow::onContactsChanged);
+    connect(m_contactManager, &ContactManager::sortOrderChanged, this, &MainWindow::onSortOrderChanged);
+    connect(m_contactTable->horizontalHeader(), &QHeaderView::sectionClicked, this, &MainWindow::onHeaderClicked);
+    
+    // Stored counters change only when the database does
+    connect(m_sync, &ContactSync::loaded, this, &MainWindow::updateDirectoryStats);
+    connect(m_sync, &ContactSync::reloaded, this, &MainWindow::updateDirectoryStats);
+    connect(m_sync, &ContactSync::persisted, this, &MainWindow::updateDirectoryStats);
 }
 
 void MainWindow::onAddContact() {
@@ -273,7 +312,7 @@ void MainWindow::onDeleteContact() {
 
 void MainWindow::onSearchContacts() {
     QString query = m_searchEdit->text();
-    QList<Contact> results = m_contactManager->searchContacts(query);
+    QList<Contact> results = m_contactManager->query(ContactQuery::compile(query));
     
     refreshContactTable();
     
@@ -289,13 +328,223 @@ void MainWindow::onClearSearch() {
 }
 
 void MainWindow::onImportContacts() {
-    // Placeholder for import functionality
-    QMessageBox::information(this, "Import", "Import functionality not yet implemented.");
+    QString filter = QString("Contact Files (*.json *.csv *.xml);;%1;;%2;;%3")
+                         .arg(FileHandler::getFileFilter(FileHandler::JSON))
+                         .arg(FileHandler::getFileFilter(FileHandler::CSV))
+                         .arg(FileHandler::getFileFilter(FileHandler::XML));
+    QString filePath = QFileDialog::getOpenFileName(this, "Import Contacts", QString(), filter);
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    FileHandler::FileFormat format = FileHandler::detectFileFormat(filePath);
+    if (format == FileHandler::JSON || format == FileHandler::CSV) {
+        startStreamingImport(filePath, format);
+        return;
+    }
+    
+    // Parse off the GUI thread, then import with progress
+    showMessage("Reading " + filePath + "...");
+    
+    ThreadPool::instance().executeWithResult([filePath, format]() {
+        FileHandler handler;
+        return handler.importContacts(filePath, format);
+    }).then(this, [this](const QList<Contact>& contacts) {
+        if (contacts.isEmpty()) {
+            QMessageBox::warning(this, "Import", "No valid contacts found in the selected file.");
+            return;
+        }
+        startImport(contacts);
+    });
+}
+
+void MainWindow::startImport(const QList<Contact>& contacts) {
+    QProgressDialog* progress = new QProgressDialog("Importing contacts...", "Cancel", 0, contacts.size(), this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    
+    QFutureWatcher<ImportReport>* watcher = new QFutureWatcher<ImportReport>(this);
+    connect(watcher, &QFutureWatcher<ImportReport>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<ImportReport>::cancel);
+    connect(watcher, &QFutureWatcher<ImportReport>::finished, this, [this, watcher, progress]() {
+        if (watcher->isCanceled()) {
+            showMessage("Import cancelled");
+        }
+        progress->deleteLater();
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(m_contactManager->importContactsAsync(contacts));
+}
+
+void MainWindow::startStreamingImport(const QString& filePath, FileHandler::FileFormat format) {
+    QProgressDialog* progress = new QProgressDialog("Importing " + filePath + "...", "Cancel",
+                                                    0, ContactManager::STREAM_PROGRESS_STEPS, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    
+    // Chunks of the file are parsed across the pool and inserted in file
+    // order as they complete, so even a multi-gigabyte export never sits in
+    // memory whole
+    QFuture<ImportReport> future = m_contactManager->importStreamAsync(
+        [filePath, format](const ContactManager::BatchSink& sink, const std::function<void(qint64, qint64)>& report) {
+            FileHandler handler;
+            QObject::connect(&handler, &FileHandler::importProgress, report);
+            return handler.importParallel(filePath, format, sink);
+        });
+    
+    QFutureWatcher<ImportReport>* watcher = new QFutureWatcher<ImportReport>(this);
+    connect(watcher, &QFutureWatcher<ImportReport>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<ImportReport>::cancel);
+    connect(watcher, &QFutureWatcher<ImportReport>::finished, this, [this, watcher, progress]() {
+        if (watcher->isCanceled()) {
+            showMessage("Import cancelled");
+        } else if (!watcher->result().error.isEmpty()) {
+            QMessageBox::warning(this, "Import", "The file could not be read completely; "
+                                 "contacts before the damaged part were imported.");
+        }
+        progress->deleteLater();
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(future);
 }
 
 void MainWindow::onExportContacts() {
-    // Placeholder for export functionality
-    QMessageBox::information(this, "Export", "Export functionality not yet implemented.");
+    QString filter = QString("%1;;%2;;%3")
+                         .arg(FileHandler::getFileFilter(FileHandler::JSON))
+                         .arg(FileHandler::getFileFilter(FileHandler::CSV))
+                         .arg(FileHandler::getFileFilter(FileHandler::XML));
+    QString filePath = QFileDialog::getSaveFileName(this, "Export Contacts",
+                                                    "contacts." + Config::EXPORT_FILE_EXTENSION, filter);
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    FileHandler::FileFormat format = FileHandler::detectFileFormat(filePath);
+    showMessage("Writing " + filePath + "...");
+    
+    QFuture<bool> exported;
+    if (format == FileHandler::JSON && m_database->isConnected() && m_sync->persist().success) {
+        // Stream straight from a database cursor on a pool thread: nothing is
+        // copied, and the contact list stays editable meanwhile
+        Database* database = m_database;
+        exported = ThreadPool::instance().executeWithResult([database, filePath]() {
+            FileHandler handler;
+            return handler.exportToJson([database](const FileHandler::ContactVisitor& visit) {
+                return database->forEachContact(visit);
+            }, filePath);
+        });
+    } else {
+        QList<Contact> contacts = m_contactManager->getContactsForExport();
+        exported = ThreadPool::instance().executeWithResult([contacts, filePath, format]() {
+            FileHandler handler;
+            return handler.exportContacts(contacts, filePath, format);
+        });
+    }
+    
+    exported.then(this, [this, filePath](bool success) {
+        if (success) {
+            showMessage("Contacts exported to " + filePath);
+        } else {
+            QMessageBox::warning(this, "Export", "Could not export contacts to " + filePath);
+        }
+    });
+}
+
+void MainWindow::onBackupDatabase() {
+    if (!m_database->isConnected() || m_backup->isRunning()) {
+        QMessageBox::warning(this, "Backup", "The database is not available for a backup right now.");
+        return;
+    }
+    
+    QString filter = QString("Phonebook Backups (*.%1)").arg(Config::BACKUP_FILE_EXTENSION);
+    QString filePath = QFileDialog::getSaveFileName(this, "Backup Database",
+                                                    DatabaseBackup::defaultBackupPath(m_database->databasePath()),
+                                                    filter);
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    // Include edits that are still waiting for the next auto-persist
+    m_sync->persist();
+    
+    runBackupJob("Backing up contacts...", [this, filePath]() {
+        return m_backup->backup(m_database->databasePath(), filePath);
+    }, [this, filePath](bool success, const QString& error) {
+        if (success) {
+            showMessage("Backup saved to " + filePath);
+        } else {
+            QMessageBox::warning(this, "Backup", "Backup failed: " + error);
+        }
+    });
+}
+
+void MainWindow::onRestoreDatabase() {
+    if (!m_database->isConnected() || m_backup->isRunning()) {
+        QMessageBox::warning(this, "Restore", "The database is not available for a restore right now.");
+        return;
+    }
+    
+    QString filter = QString("Phonebook Backups (*.%1)").arg(Config::BACKUP_FILE_EXTENSION);
+    QString filePath = QFileDialog::getOpenFileName(this, "Restore Database", QString(), filter);
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    int ret = QMessageBox::question(this, "Restore Database",
+                                    "Restoring replaces every contact with the contents of the backup, "
+                                    "and unsaved changes are lost. Continue?",
+                                    QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
+    
+    // The restore writes the file underneath us; reopen once it is done so
+    // migrations run if the backup predates the current schema
+    const QString databasePath = m_database->databasePath();
+    m_sync->setAutoPersistInterval(0);
+    m_database->close();
+    
+    runBackupJob("Restoring contacts...", [this, filePath, databasePath]() {
+        return m_backup->restore(filePath, databasePath);
+    }, [this, databasePath](bool restored, const QString& error) {
+        if (!m_database->initialize(databasePath)) {
+            QMessageBox::critical(this, "Restore", "Could not reopen the database after the restore.");
+            return;
+        }
+        if (restored) {
+            m_sync->discardAndReload();
+            showMessage("Contacts restored from backup");
+        } else {
+            QMessageBox::warning(this, "Restore", "Restore failed: " + error);
+        }
+        m_sync->setAutoPersistInterval(Config::AUTO_PERSIST_INTERVAL);
+    });
+}
+
+void MainWindow::runBackupJob(const QString& label, const std::function<bool()>& start,
+                              const std::function<void(bool, const QString&)>& done) {
+    QProgressDialog* progress = new QProgressDialog(label, "Cancel", 0, 0, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    
+    // Connections die with the dialog, so the next job starts clean
+    connect(m_backup, &DatabaseBackup::progress, progress, [progress](int pagesCopied, int pageCount) {
+        progress->setMaximum(pageCount);
+        progress->setValue(pagesCopied);
+    });
+    connect(progress, &QProgressDialog::canceled, m_backup, &DatabaseBackup::cancel);
+    connect(m_backup, &DatabaseBackup::finished, progress, [progress, done](bool success, const QString& error) {
+        progress->deleteLater();
+        done(success, error);
+    });
+    
+    // Connected first, so even a job that ends at once is reported
+    if (!start()) {
+        progress->deleteLater();
+        done(false, "the job could not be started");
+    }
 }
 
 void MainWindow::onAbout() {
@@ -342,54 +591,115 @@ void MainWindow::onTableDoubleClicked(int row, int column) {
     onTableSelectionChanged(); // Fill the form
 }
 
+// The table itself is updated from contactsChanged
 void MainWindow::onContactAdded(const Contact& contact) {
     Q_UNUSED(contact)
-    refreshContactTable();
     updateStatusBar();
 }
 
 void MainWindow::onContactRemoved(const Contact& contact) {
     Q_UNUSED(contact)
-    refreshContactTable();
     updateStatusBar();
 }
 
 void MainWindow::onContactUpdated(const Contact& oldContact, const Contact& newContact) {
     Q_UNUSED(oldContact)
     Q_UNUSED(newContact)
-    refreshContactTable();
     updateStatusBar();
 }
 
 void MainWindow::onContactsCleared() {
-    refreshContactTable();
     updateStatusBar();
 }
 
+void MainWindow::onContactsImported(int count, int skipped) {
+    updateStatusBar();
+    showMessage(QString("Imported %1 contact(s), skipped %2").arg(count).arg(skipped));
+}
+
+void MainWindow::onContactsChanged(const QList<ContactChange>& changes) {
+    // Rows only line up with the manager while no search filter is active
+    if (!m_searchEdit->text().isEmpty()) {
+        refreshContactTable();
+        return;
+    }
+    
+    for (const ContactChange& change : changes) {
+        switch (change.type) {
+            case ContactChange::Inserted:
+                m_contactTable->insertRow(change.row);
+                setContactRow(change.row, change.contact);
+                break;
+            case ContactChange::Removed:
+                m_contactTable->removeRow(change.row);
+                break;
+            case ContactChange::Moved:
+                if (change.row != change.toRow) {
+                    m_contactTable->removeRow(change.row);
+                    m_contactTable->insertRow(change.toRow);
+                }
+                setContactRow(change.toRow, change.contact);
+                break;
+            case ContactChange::Reset:
+                refreshContactTable();
+                return;
+        }
+    }
+}
+
+void MainWindow::onHeaderClicked(int column) {
+    static const ContactManager::SortKey keys[] = {
+        ContactManager::SortByName, ContactManager::SortByPhone, ContactManager::SortByEmail
+    };
+    if (column >= 0 && column < 3) {
+        m_contactManager->setSortKey(keys[column]);
+    }
+}
+
+void MainWindow::onSortOrderChanged(ContactManager::SortKey key) {
+    // The rows are rebuilt by the Reset that follows through contactsChanged
+    m_contactTable->horizontalHeader()->setSortIndicator(static_cast<int>(key), Qt::AscendingOrder);
+}
+
 void MainWindow::refreshContactTable() {
     QString searchQuery = m_searchEdit->text();
     QList<Contact> contacts;
     
     if (searchQuery.isEmpty()) {
-        contacts = m_contactManager->getAllContacts();
+        // Undelivered changes are already in the snapshot; replaying them
+        // would insert or remove rows twice
+        contacts = m_contactManager->resyncSortedContacts();
     } else {
-        contacts = m_contactManager->searchContacts(searchQuery);
+        // Query results come back in name order
+        contacts = m_contactManager->query(ContactQuery::compile(searchQuery));
+        switch (m_contactManager->sortKey()) {
+            case ContactManager::SortByPhone:
+                std::sort(contacts.begin(), contacts.end(), ContactPhoneOrder());
+                break;
+            case ContactManager::SortByEmail:
+                std::sort(contacts.begin(), contacts.end(), ContactEmailOrder());
+                break;
+            default:
+                break;
+        }
     }
     
     m_contactTable->setRowCount(contacts.size());
     
     for (int i = 0; i < contacts.size(); ++i) {
-        const Contact& contact = contacts[i];
-        
-        m_contactTable->setItem(i, 0, new QTableWidgetItem(contact.getName()));
-        m_contactTable->setItem(i, 1, new QTableWidgetItem(contact.getPhone()));
-        m_contactTable->setItem(i, 2, new QTableWidgetItem(contact.getEmail()));
+        setContactRow(i, contacts[i]);
     }
     
     // Adjust column widths
     m_contactTable->resizeColumnsToContents();
 }
 
+void MainWindow::setContactRow(int row, const Contact& contact) {
+    m_contactTable->setItem(row, 0, new QTableWidgetItem(contact.getName()));
+    m_contactTable->setItem(row, 1, new QTableWidgetItem(contact.getPhone()));
+    m_contactTable->setItem(row, 2, new QTableWidgetItem(contact.getEmail()));
+}
+
 void MainWindow::clearContactForm() {
     m_nameEdit->clear();
     m_phoneEdit->clear();
@@ -442,6 +752,38 @@ void MainWindow::updateStatusBar() {
     m_statusLabel->setText(QString("Total contacts: %1").arg(contactCount));
 }
 
+void MainWindow::updateDirectoryStats() {
+    if (!m_database->isConnected()) {
+        return;
+    }
+    
+    // Both maps come from trigger-maintained counters, not table scans
+    QStringList letters;
+    const QMap<QString, int> letterCounts = m_database->getLetterCounts();
+    for (auto it = letterCounts.constBegin(); it != letterCounts.constEnd(); ++it) {
+        letters << QString("%1: %2").arg(it.key()).arg(it.value());
+    }
+    
+    QList<QPair<int, QString>> domains;
+    const QMap<QString, int> domainCounts = m_database->getDomainCounts();
+    for (auto it = domainCounts.constBegin(); it != domainCounts.constEnd(); ++it) {
+        domains.append({it.value(), it.key()});
+    }
+    std::sort(domains.begin(), domains.end(), [](const QPair<int, QString>& a, const QPair<int, QString>& b) {
+        return a.first > b.first;
+    });
+    
+    QStringList topDomains;
+    for (int i = 0; i < std::min<int>(domains.size(), Config::STATUS_TOP_DOMAINS); ++i) {
+        topDomains << QString("%1: %2").arg(domains[i].second).arg(domains[i].first);
+    }
+    
+    m_statusLabel->setToolTip(QString("Saved contacts: %1\nBy letter: %2\nTop domains: %3")
+                              .arg(m_database->getContactCount())
+                              .arg(letters.isEmpty() ? "-" : letters.join(", "))
+                              .arg(topDomains.isEmpty() ? "-" : topDomains.join(", ")));
+}
+
 void MainWindow::showMessage(const QString& message, int timeout) {
     statusBar()->showMessage(message, timeout);
 }
@@ -460,5 +802,15 @@ void MainWindow::closeEvent(QCloseEvent* event) {
         }
     }
     
+    if (m_database->isConnected() && !m_sync->persist().success) {
+        int ret = QMessageBox::warning(this, "Save Failed",
+                                      "Some changes could not be saved. Exit anyway?",
+                                      QMessageBox::Yes | QMessageBox::No);
+        if (ret == QMessageBox::No) {
+            event->ignore();
+            return;
+        }
+    }
+    
     event->accept();
 }
@@ -17,6 +17,11 @@
 #include <QMessageBox>
 #include "core/ContactManager.h"
 #include "core/Contact.h"
+#include "core/FileHandler.h"
+#include "db/Database.h"
+#include "db/ContactSync.h"
+#include "db/DatabaseBackup.h"
+#include <functional>
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -36,6 +41,8 @@ private slots:
     void onClearSearch();
     void onImportContacts();
     void onExportContacts();
+    void onBackupDatabase();
+    void onRestoreDatabase();
     void onAbout();
     
     void onTableSelectionChanged();
@@ -46,20 +53,33 @@ private slots:
     void onContactRemoved(const Contact& contact);
     void onContactUpdated(const Contact& oldContact, const Contact& newContact);
     void onContactsCleared();
+    void onContactsImported(int count, int skipped);
+    void onContactsChanged(const QList<ContactChange>& changes);
+    void onSortOrderChanged(ContactManager::SortKey key);
+    void onHeaderClicked(int column);
     
 private:
     void setupUI();
+    void setupContactTable();
+    void setupContactForm();
+    void setupSearchBar();
     void setupMenuBar();
     void setupStatusBar();
     void setupConnections();
     
     void refreshContactTable();
+    void startImport(const QList<Contact>& contacts);
+    void startStreamingImport(const QString& filePath, FileHandler::FileFormat format);
+    void runBackupJob(const QString& label, const std::function<bool()>& start,
+                      const std::function<void(bool, const QString&)>& done);
+    void setContactRow(int row, const Contact& contact);
     void clearContactForm();
     void fillContactForm(const Contact& contact);
     Contact getContactFromForm() const;
     bool validateContactForm() const;
     
     void updateStatusBar();
+    void updateDirectoryStats();
     void showMessage(const QString& message, int timeout = 3000);
     
     // UI Components
@@ -92,6 +112,9 @@ private:
     
     // Business logic
     ContactManager* m_contactManager;
+    Database* m_database;
+    ContactSync* m_sync;
+    DatabaseBackup* m_backup;
     
     // State
     int m_currentSelectedRow;
@@ -27,9 +27,13 @@ namespace Config {
     // Threading
     const int MAX_THREAD_POOL_SIZE = 4;
     
+    // Persistence
+    const int AUTO_PERSIST_INTERVAL = 2000; // milliseconds
+    
     // UI settings
     const int STATUS_MESSAGE_TIMEOUT = 3000; // milliseconds
     const int SEARCH_DELAY = 300; // milliseconds
+    const int STATUS_TOP_DOMAINS = 5;
 }
 
 #endif // CONFIG_H
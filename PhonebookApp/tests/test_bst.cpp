@@ -77,6 +77,20 @@ TEST_F(BSTTest, Remove) {
     EXPECT_FALSE(bst->remove(contact2));
 }
 
+TEST_F(BSTTest, FindEquivalentIgnoresPhone) {
+    bst->insert(contact1);
+    bst->insert(contact2);
+    
+    // find() wants operator==, which also compares the phone
+    Contact byName("alice", "");
+    EXPECT_EQ(bst->find(byName), nullptr);
+    
+    const Contact* found = bst->findEquivalent(byName);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->getPhone(), "123-456-7890");
+    EXPECT_EQ(bst->findEquivalent(Contact("Dave", "")), nullptr);
+}
+
 TEST_F(BSTTest, Clear) {
     bst->insert(contact1);
     bst->insert(contact2);
@@ -104,6 +118,39 @@ TEST_F(BSTTest, Search) {
     EXPECT_EQ(results.size(), 0);
 }
 
+TEST_F(BSTTest, PositionalAccess) {
+    bst->insert(contact2); // Bob
+    bst->insert(contact3); // Charlie
+    bst->insert(contact1); // Alice
+    
+    EXPECT_EQ(bst->indexOf(contact1), 0);
+    EXPECT_EQ(bst->indexOf(contact2), 1);
+    EXPECT_EQ(bst->indexOf(contact3), 2);
+    
+    ASSERT_NE(bst->at(1), nullptr);
+    EXPECT_EQ(bst->at(1)->getName(), "Bob");
+    EXPECT_EQ(bst->at(3), nullptr);
+    
+    bst->remove(contact2);
+    EXPECT_EQ(bst->indexOf(contact2), -1);
+    EXPECT_EQ(bst->indexOf(contact3), 1);
+    EXPECT_EQ(bst->size(), 2);
+}
+
+TEST_F(BSTTest, CustomOrderAndRange) {
+    BST<Contact, ContactPhoneOrder> byPhone;
+    byPhone.insert(Contact("Alice", "555-3000"));
+    byPhone.insert(Contact("Bob", "555-1000"));
+    byPhone.insert(Contact("Carol", "555-2000"));
+    
+    QList<Contact> page = byPhone.range(1, 5);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0].getName(), "Carol");
+    EXPECT_EQ(page[1].getName(), "Alice");
+    EXPECT_EQ(byPhone.rank(Contact("Bob", "555-1000")), 0u);
+    EXPECT_TRUE(byPhone.range(3, 5).isEmpty());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,337 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QThread>
+#include "core/ThreadPool.h"
+#include "core/ContactManager.h"
+#include "core/Contact.h"
+
+class ContactManagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        contact1 = Contact("Alice Johnson", "123-456-7890", "alice@example.com");
+        contact2 = Contact("Bob Smith", "987-654-3210", "bob@example.com");
+        contact3 = Contact("Charlie Brown", "555-1234", "charlie@example.com");
+    }
+    
+    ContactManager manager;
+    Contact contact1, contact2, contact3;
+};
+
+TEST_F(ContactManagerTest, RemoveMatchesByName) {
+    ASSERT_TRUE(manager.addContact(contact1));
+    ASSERT_TRUE(manager.addContact(contact2));
+    
+    // Names are the key; the phone of the argument does not have to match
+    EXPECT_TRUE(manager.removeContact(Contact("alice johnson", "")));
+    EXPECT_EQ(manager.getContactCount(), 1);
+    EXPECT_EQ(manager.getAllContacts()[0].getName(), "Bob Smith");
+    EXPECT_FALSE(manager.removeContact(Contact("Alice Johnson", "123-456-7890")));
+}
+
+TEST_F(ContactManagerTest, UpdateMatchesByName) {
+    ASSERT_TRUE(manager.addContact(contact1));
+    
+    Contact edited("Alice Johnson", "222-333-4444", "alice@work.example.com");
+    EXPECT_TRUE(manager.updateContact(Contact("Alice Johnson", ""), edited));
+    ASSERT_EQ(manager.getContactCount(), 1);
+    EXPECT_EQ(manager.getAllContacts()[0].getPhone(), "222-333-4444");
+    EXPECT_EQ(manager.getAllContacts()[0].getId(), contact1.getId());
+}
+
+TEST_F(ContactManagerTest, ImportBatchReportsEveryRejection) {
+    ASSERT_TRUE(manager.addContact(contact3));
+    
+    const QList<Contact> batch = {
+        contact1,
+        Contact("", "555-0000"),                       // Invalid: no name
+        contact2,
+        Contact("Alice Johnson", "123-456-7890"),      // Duplicate within the batch
+        Contact("charlie brown", "555-1234"),          // Duplicate of a stored contact
+        Contact("Dana Scully", "not a phone"),         // Invalid phone
+    };
+    
+    int deliveries = 0;
+    QObject::connect(&manager, &ContactManager::contactsImported, [&](int count, int skipped) {
+        deliveries++;
+        EXPECT_EQ(count, 2);
+        EXPECT_EQ(skipped, 4);
+    });
+    
+    const ImportReport report = manager.importContactsBatch(batch);
+    EXPECT_EQ(deliveries, 1);
+    EXPECT_EQ(report.total, 6);
+    EXPECT_EQ(report.added, 2);
+    EXPECT_EQ(report.invalid, 2);
+    EXPECT_EQ(report.duplicates, 2);
+    EXPECT_EQ(report.skipped(), 4);
+    
+    ASSERT_EQ(report.rejections.size(), 4);
+    const QList<int> rows = {1, 3, 4, 5};
+    const QList<ImportReport::Reason> reasons = {ImportReport::InvalidContact, ImportReport::DuplicateContact,
+                                                 ImportReport::DuplicateContact, ImportReport::InvalidContact};
+    for (int i = 0; i < rows.size(); ++i) {
+        EXPECT_EQ(report.rejections[i].row, rows[i]) << "rejection " << i;
+        EXPECT_EQ(report.rejections[i].reason, reasons[i]) << "rejection " << i;
+    }
+    
+    EXPECT_EQ(manager.getContactCount(), 3);
+}
+
+TEST_F(ContactManagerTest, ApplyMergePlanKeepsReviewGroupsAndIncomingRows) {
+    const QList<Contact> incoming = {
+        Contact("John Smith", "555-1111"),
+        Contact("Dana Scully", "not a phone"),                  // Invalid phone
+        Contact("J. Smith", "+1 555 1111", "john@corp.com"),    // Merged into row 0
+        Contact("Maximilian Oberhausen", "555-1000"),
+        Contact("Maximillian Oberhausen", "555-2000"),         // Similar name only
+    };
+    
+    const MergePlan plan = manager.planImport(incoming);
+    ASSERT_EQ(plan.groups.size(), 2);
+    EXPECT_EQ(plan.rowsToImport(), QList<int>({0, 1, 3, 4}));
+    
+    const ImportReport report = manager.applyMergePlan(incoming, plan);
+    EXPECT_EQ(report.total, 5);
+    EXPECT_EQ(report.added, 3);
+    EXPECT_EQ(report.invalid, 1);
+    EXPECT_EQ(report.duplicates, 1);
+    
+    // Rows of the incoming list, not of the survivors
+    ASSERT_EQ(report.rejections.size(), 2);
+    EXPECT_EQ(report.rejections[0].row, 1);
+    EXPECT_EQ(report.rejections[0].reason, ImportReport::InvalidContact);
+    EXPECT_EQ(report.rejections[1].row, 2);
+    EXPECT_EQ(report.rejections[1].reason, ImportReport::DuplicateContact);
+    
+    ASSERT_NE(manager.findContact("John Smith", "555-1111"), nullptr);
+    EXPECT_EQ(manager.findContact("John Smith", "555-1111")->getEmail(), "john@corp.com");
+    EXPECT_NE(manager.findContact("Maximilian Oberhausen", "555-1000"), nullptr);
+    EXPECT_NE(manager.findContact("Maximillian Oberhausen", "555-2000"), nullptr);
+}
+
+namespace {
+    // Applies a batch the way MainWindow applies it to its table
+    void replay(QList<Contact>& view, const QList<ContactChange>& changes, const ContactManager& manager) {
+        for (const ContactChange& change : changes) {
+            switch (change.type) {
+                case ContactChange::Inserted:
+                    ASSERT_LE(change.row, view.size());
+                    view.insert(change.row, change.contact);
+                    break;
+                case ContactChange::Removed:
+                    ASSERT_LT(change.row, view.size());
+                    view.removeAt(change.row);
+                    break;
+                case ContactChange::Moved:
+                    ASSERT_LT(change.row, view.size());
+                    view.removeAt(change.row);
+                    ASSERT_LE(change.toRow, view.size());
+                    view.insert(change.toRow, change.contact);
+                    break;
+                case ContactChange::Reset:
+                    view = manager.getSortedContacts();
+                    return;
+            }
+        }
+    }
+}
+
+TEST_F(ContactManagerTest, ContactsChangedRowsReplayOntoSortedList) {
+    QList<Contact> view;
+    QList<QList<ContactChange>> batches;
+    QObject::connect(&manager, &ContactManager::contactsChanged, [&](const QList<ContactChange>& changes) {
+        batches.append(changes);
+        replay(view, changes, manager);
+    });
+    
+    ASSERT_TRUE(manager.addContact(contact2));
+    ASSERT_TRUE(manager.addContact(contact3));
+    ASSERT_TRUE(manager.addContact(contact1));
+    Contact renamed("Zed Smith", contact2.getPhone(), contact2.getEmail());
+    ASSERT_TRUE(manager.updateContact(contact2, renamed));
+    ASSERT_TRUE(manager.removeContact(contact3));
+    EXPECT_TRUE(batches.isEmpty());    // Delivered from the event loop
+    
+    QCoreApplication::processEvents();
+    ASSERT_EQ(batches.size(), 1);
+    const QList<ContactChange>& changes = batches[0];
+    ASSERT_EQ(changes.size(), 5);
+    EXPECT_EQ(changes[0].row, 0);                               // Bob
+    EXPECT_EQ(changes[1].row, 1);                               // Charlie after Bob
+    EXPECT_EQ(changes[2].row, 0);                               // Alice first
+    EXPECT_EQ(changes[3].type, ContactChange::Moved);
+    EXPECT_EQ(changes[3].row, 1);
+    EXPECT_EQ(changes[3].toRow, 2);                             // Bob renamed to Zed
+    EXPECT_EQ(changes[4].type, ContactChange::Removed);
+    EXPECT_EQ(changes[4].row, 1);                               // Charlie
+    EXPECT_EQ(view, manager.getSortedContacts());
+}
+
+TEST_F(ContactManagerTest, SetSortKeyResetsViewsOnce) {
+    ASSERT_TRUE(manager.addContact(contact1));
+    ASSERT_TRUE(manager.addContact(contact2));
+    QCoreApplication::processEvents();
+    
+    int orderSignals = 0;
+    QList<QList<ContactChange>> batches;
+    QObject::connect(&manager, &ContactManager::sortOrderChanged, [&](ContactManager::SortKey key) {
+        orderSignals++;
+        EXPECT_EQ(key, ContactManager::SortByPhone);
+    });
+    QObject::connect(&manager, &ContactManager::contactsChanged, [&](const QList<ContactChange>& changes) {
+        batches.append(changes);
+    });
+    
+    // A pending change would refer to rows of the old order; the reset replaces it
+    ASSERT_TRUE(manager.addContact(contact3));
+    manager.setSortKey(ContactManager::SortByPhone);
+    manager.setSortKey(ContactManager::SortByPhone);
+    EXPECT_EQ(orderSignals, 1);
+    
+    QCoreApplication::processEvents();
+    ASSERT_EQ(batches.size(), 1);
+    ASSERT_EQ(batches[0].size(), 1);
+    EXPECT_EQ(batches[0][0].type, ContactChange::Reset);
+    EXPECT_EQ(manager.sortKey(), ContactManager::SortByPhone);
+}
+
+TEST_F(ContactManagerTest, RowOfAndPagesFollowSortOrder) {
+    ASSERT_TRUE(manager.addContact(contact1));
+    ASSERT_TRUE(manager.addContact(contact2));
+    ASSERT_TRUE(manager.addContact(contact3));
+    
+    EXPECT_EQ(manager.rowOf(contact1), 0);
+    EXPECT_EQ(manager.rowOf(contact3), 2);
+    EXPECT_EQ(manager.rowOf(Contact("Nobody", "555-0000")), -1);
+    
+    // 123-... < 555-... < 987-...
+    manager.setSortKey(ContactManager::SortByPhone);
+    EXPECT_EQ(manager.rowOf(contact3), 1);
+    EXPECT_EQ(manager.rowOf(contact2), 2);
+    const QList<Contact> page = manager.getContactsPage(1, 5);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0].getName(), "Charlie Brown");
+    EXPECT_EQ(page[1].getName(), "Bob Smith");
+    EXPECT_EQ(manager.getContactsPage(0, 3), manager.getSortedContacts());
+    EXPECT_TRUE(manager.getContactsPage(3, 1).isEmpty());
+    EXPECT_TRUE(manager.getContactsPage(-1, 2).isEmpty());
+    EXPECT_TRUE(manager.getContactsPage(0, 0).isEmpty());
+    
+    manager.setSortKey(ContactManager::SortByEmail);
+    EXPECT_EQ(manager.rowOf(contact3), 2);
+    EXPECT_EQ(manager.getContactsPage(0, 1)[0].getName(), "Alice Johnson");
+}
+
+TEST_F(ContactManagerTest, ResyncDropsUndeliveredChanges) {
+    int deliveries = 0;
+    QObject::connect(&manager, &ContactManager::contactsChanged, [&](const QList<ContactChange>&) {
+        deliveries++;
+    });
+    
+    ASSERT_TRUE(manager.addContact(contact1));
+    ASSERT_TRUE(manager.addContact(contact2));
+    
+    // The snapshot already holds both; replaying the inserts would add them twice
+    const QList<Contact> snapshot = manager.resyncSortedContacts();
+    EXPECT_EQ(snapshot.size(), 2);
+    QCoreApplication::processEvents();
+    EXPECT_EQ(deliveries, 0);
+    
+    // Later changes are delivered as usual
+    ASSERT_TRUE(manager.addContact(contact3));
+    QCoreApplication::processEvents();
+    EXPECT_EQ(deliveries, 1);
+}
+
+TEST_F(ContactManagerTest, AsyncReadsMatchSyncReads) {
+    ASSERT_TRUE(manager.addContact(contact1));
+    ASSERT_TRUE(manager.addContact(contact2));
+    ASSERT_TRUE(manager.addContact(contact3));
+    
+    QFuture<QList<Contact>> all = manager.getAllContactsAsync();
+    EXPECT_EQ(all.result(), manager.getAllContacts());
+    EXPECT_EQ(all.progressMinimum(), 0);
+    EXPECT_EQ(all.progressMaximum(), 1);
+    EXPECT_EQ(all.progressValue(), 1);
+    
+    QFuture<QList<Contact>> found = manager.searchContactsAsync("BOB");
+    ASSERT_EQ(found.result().size(), 1);
+    EXPECT_EQ(found.result()[0].getName(), "Bob Smith");
+    EXPECT_EQ(found.progressMaximum(), 3);
+    EXPECT_EQ(found.progressValue(), 3);
+    
+    // An empty query returns everything, like searchContacts()
+    EXPECT_EQ(manager.searchContactsAsync(QString()).result(), manager.getAllContacts());
+}
+
+TEST_F(ContactManagerTest, AsyncImportReportsProgressOnManagerThread) {
+    // Several work units, with invalid rows and a duplicate among them
+    QList<Contact> contacts;
+    for (int i = 0; i < 10000; ++i) {
+        contacts.append(i % 1000 == 0 ? Contact(QString("Person %1").arg(i), "")
+                                      : Contact(QString("Person %1").arg(i), QString("555-%1").arg(i)));
+    }
+    contacts.append(Contact("Person 1", "555-1"));
+    
+    int deliveries = 0;
+    QThread* signalThread = nullptr;
+    QObject::connect(&manager, &ContactManager::contactsImported, [&](int count, int skipped) {
+        deliveries++;
+        signalThread = QThread::currentThread();
+        EXPECT_EQ(count, 9990);
+        EXPECT_EQ(skipped, 11);
+    });
+    
+    QFuture<ImportReport> future = manager.importContactsAsync(contacts);
+    const ImportReport report = future.result();
+    EXPECT_EQ(report.total, 10001);
+    EXPECT_EQ(report.added, 9990);
+    EXPECT_EQ(report.invalid, 10);
+    EXPECT_EQ(report.duplicates, 1);
+    EXPECT_EQ(future.progressMinimum(), 0);
+    EXPECT_EQ(future.progressMaximum(), 10001);
+    EXPECT_EQ(future.progressValue(), 10001);
+    EXPECT_EQ(manager.getContactCount(), 9990);
+    
+    // Delivered by the manager's event loop, not the pool thread
+    EXPECT_EQ(deliveries, 0);
+    QCoreApplication::processEvents();
+    EXPECT_EQ(deliveries, 1);
+    EXPECT_EQ(signalThread, manager.thread());
+}
+
+TEST_F(ContactManagerTest, AsyncCallsCancelledBeforeStartDoNothing) {
+    // Hold the only pool thread so the calls below stay queued
+    const int threads = ThreadPool::instance().maxThreadCount();
+    ThreadPool::instance().setMaxThreadCount(1);
+    QSemaphore started, release;
+    QFuture<void> blocker = ThreadPool::instance().execute([&]() {
+        started.release();
+        release.acquire();
+    });
+    started.acquire();
+    
+    QFuture<ImportReport> import = manager.importContactsAsync({contact1, contact2});
+    QFuture<QList<Contact>> search = manager.searchContactsAsync("alice");
+    import.cancel();
+    search.cancel();
+    
+    release.release();
+    blocker.waitForFinished();
+    import.waitForFinished();
+    search.waitForFinished();
+    ThreadPool::instance().setMaxThreadCount(threads);
+    
+    EXPECT_TRUE(import.isCanceled());
+    EXPECT_TRUE(search.isCanceled());
+    EXPECT_EQ(import.resultCount(), 0);
+    EXPECT_EQ(manager.getContactCount(), 0);
+}
+
+int main(int argc, char **argv) {
+    // Queued signals need an event loop to deliver to
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,7 +1,18 @@
 #include <gtest/gtest.h>
 #include <QTemporaryFile>
+#include <QTemporaryDir>
 #include <QDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThread>
+#include <QAtomicInt>
+#include <algorithm>
 #include "db/Database.h"
+#include "db/DatabaseWriter.h"
+#include "db/ContactSync.h"
+#include "db/DatabaseBackup.h"
+#include "core/ContactManager.h"
+#include "core/FileHandler.h"
 #include "core/Contact.h"
 
 class DatabaseTest : public ::testing::Test {
@@ -109,6 +120,768 @@ TEST_F(DatabaseTest, ClearAllContacts) {
     EXPECT_EQ(database->getContactCount(), 0);
 }
 
+TEST_F(DatabaseTest, BulkSaveUpdateDelete) {
+    QList<Contact> contacts;
+    for (int i = 0; i < 500; ++i) {
+        contacts.append(Contact(QString("Bulk Contact %1").arg(i), QString("555-%1").arg(i, 4, 10, QChar('0'))));
+    }
+    
+    BulkWriteResult saved = database->saveContacts(contacts);
+    EXPECT_TRUE(saved.success);
+    EXPECT_EQ(saved.rowsAffected, 500);
+    EXPECT_GT(saved.rowsPerSecond(), 0.0);
+    EXPECT_EQ(database->getContactCount(), 500);
+    
+    QList<Contact> stored = database->getAllContacts();
+    QList<Contact> changed;
+    QList<int> ids;
+    for (int i = 0; i < 10; ++i) {
+        Contact contact = stored[i];
+        contact.setEmail(QString("bulk%1@example.com").arg(i));
+        changed.append(contact);
+        ids.append(contact.getId());
+    }
+    
+    BulkWriteResult updated = database->updateContacts(changed);
+    EXPECT_TRUE(updated.success);
+    EXPECT_EQ(updated.rowsAffected, 10);
+    EXPECT_EQ(database->getContact(ids[3]).getEmail(), "bulk3@example.com");
+    
+    ids.append(-1);  // Unknown ids are not counted
+    BulkWriteResult deleted = database->deleteContacts(ids);
+    EXPECT_TRUE(deleted.success);
+    EXPECT_EQ(deleted.rowsAffected, 10);
+    EXPECT_EQ(database->getContactCount(), 490);
+}
+
+TEST_F(DatabaseTest, TransactionRollsBack) {
+    EXPECT_FALSE(database->runInTransaction([this]() {
+        database->saveContact(contact1);
+        return false;
+    }));
+    EXPECT_EQ(database->getContactCount(), 0);
+    
+    EXPECT_TRUE(database->runInTransaction([this]() {
+        // Nested calls join the outer transaction
+        return database->saveContacts({contact1, contact2}).success && database->saveContact(contact3);
+    }));
+    EXPECT_EQ(database->getContactCount(), 3);
+    
+    // A failed nested call rolls the outer transaction back, even if the
+    // outer work ignores the failure
+    EXPECT_FALSE(database->runInTransaction([this]() {
+        database->saveContact(Contact("Dana Scully", "555-0004"));
+        database->runInTransaction([]() { return false; });
+        return true;
+    }));
+    EXPECT_EQ(database->getContactCount(), 3);
+    
+    // And the next transaction starts clean
+    EXPECT_TRUE(database->runInTransaction([this]() {
+        return database->saveContact(Contact("Dana Scully", "555-0004"));
+    }));
+    EXPECT_EQ(database->getContactCount(), 4);
+}
+
+TEST_F(DatabaseTest, PerformanceProfileApplied) {
+    // The default profile is durable: WAL with full syncs
+    EXPECT_EQ(database->pragmaValue("journal_mode").toString().toLower(), "wal");
+    EXPECT_EQ(database->pragmaValue("synchronous").toInt(), 2);
+    
+    database->close();
+    database->setPerformanceProfile(PerformanceProfile::fast());
+    ASSERT_TRUE(database->initialize(tempFile->fileName()));
+    EXPECT_EQ(database->pragmaValue("synchronous").toInt(), 1);
+    EXPECT_EQ(database->pragmaValue("temp_store").toInt(), 2);
+    EXPECT_EQ(database->pragmaValue("cache_size").toInt(), -65536);
+}
+
+TEST_F(DatabaseTest, FullTextSearch) {
+    if (!database->hasFullTextSearch()) {
+        GTEST_SKIP() << "SQLite build lacks FTS5 trigram support";
+    }
+    
+    database->saveContact(contact1);
+    database->saveContact(contact2);
+    database->saveContact(contact3);
+    
+    QList<Contact> results = database->searchContacts("JOHNS");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].getName(), "Alice Johnson");
+    
+    // Below the trigram length the LIKE path answers
+    results = database->searchContacts("Bo");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].getName(), "Bob Smith");
+    
+    // Triggers keep the index in step with updates and deletes
+    Contact bob = database->getAllContacts()[1];
+    bob.setName("Robert Smith");
+    ASSERT_TRUE(database->updateContact(bob));
+    EXPECT_EQ(database->searchContacts("Robert").size(), 1);
+    EXPECT_TRUE(database->searchContacts("Bob Smith").isEmpty());
+    
+    ASSERT_TRUE(database->deleteContact(bob.getId()));
+    EXPECT_TRUE(database->searchContacts("Robert").isEmpty());
+}
+
+TEST_F(DatabaseTest, FullTextIndexBuiltForExistingDatabase) {
+    database->close();
+    
+    // A database written before the index existed
+    {
+        QSqlDatabase legacy = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+        legacy.setDatabaseName(tempFile->fileName());
+        ASSERT_TRUE(legacy.open());
+        QSqlQuery query(legacy);
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contacts_fts_insert"));
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contacts_fts_delete"));
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contacts_fts_update"));
+        ASSERT_TRUE(query.exec("DROP TABLE IF EXISTS contacts_fts"));
+        ASSERT_TRUE(query.exec("INSERT INTO contacts (name, phone, email) "
+                               "VALUES ('Legacy Person', '555-0000', 'legacy@example.com')"));
+        legacy.close();
+    }
+    QSqlDatabase::removeDatabase("legacy");
+    
+    ASSERT_TRUE(database->initialize(tempFile->fileName()));
+    if (!database->hasFullTextSearch()) {
+        GTEST_SKIP() << "SQLite build lacks FTS5 trigram support";
+    }
+    EXPECT_EQ(database->searchContacts("legacy").size(), 1);
+}
+
+TEST_F(DatabaseTest, FullTextIndexRepairedWhenTriggersMissing) {
+    if (!database->hasFullTextSearch()) {
+        GTEST_SKIP() << "SQLite build lacks FTS5 trigram support";
+    }
+    database->close();
+    
+    // The table survived but a trigger did not, so a row went unindexed
+    {
+        QSqlDatabase partial = QSqlDatabase::addDatabase("QSQLITE", "partial");
+        partial.setDatabaseName(tempFile->fileName());
+        ASSERT_TRUE(partial.open());
+        QSqlQuery query(partial);
+        ASSERT_TRUE(query.exec("DROP TRIGGER contacts_fts_insert"));
+        ASSERT_TRUE(query.exec("INSERT INTO contacts (name, phone, email) "
+                               "VALUES ('Unindexed Person', '555-0000', 'unindexed@example.com')"));
+        partial.close();
+    }
+    QSqlDatabase::removeDatabase("partial");
+    
+    ASSERT_TRUE(database->initialize(tempFile->fileName()));
+    ASSERT_TRUE(database->hasFullTextSearch());
+    EXPECT_EQ(database->searchContacts("unindexed").size(), 1);
+    
+    ASSERT_TRUE(database->saveContact(contact1));
+    EXPECT_EQ(database->searchContacts("alice").size(), 1);
+}
+
+TEST_F(DatabaseTest, ContactStatsFollowWrites) {
+    database->saveContacts({contact1, contact2, contact3});
+    database->saveContact(Contact("alan Turing", "555-0101", "alan@Work.org"));
+    
+    EXPECT_EQ(database->getContactCount(), 4);
+    QMap<QString, int> letters = database->getLetterCounts();
+    EXPECT_EQ(letters.value("A"), 2);
+    EXPECT_EQ(letters.value("B"), 1);
+    QMap<QString, int> domains = database->getDomainCounts();
+    EXPECT_EQ(domains.value("example.com"), 3);
+    EXPECT_EQ(domains.value("work.org"), 1);
+    
+    // Renames and new addresses move counts between keys
+    QList<Contact> bobs = database->searchContacts("Bob Smith");
+    ASSERT_EQ(bobs.size(), 1);
+    Contact bob = bobs.first();
+    bob.setName("Robert Smith");
+    bob.setEmail("robert@work.org");
+    ASSERT_TRUE(database->updateContact(bob));
+    
+    letters = database->getLetterCounts();
+    EXPECT_FALSE(letters.contains("B"));
+    EXPECT_EQ(letters.value("R"), 1);
+    domains = database->getDomainCounts();
+    EXPECT_EQ(domains.value("example.com"), 2);
+    EXPECT_EQ(domains.value("work.org"), 2);
+    
+    ASSERT_TRUE(database->deleteContact(bob.getId()));
+    EXPECT_EQ(database->getContactCount(), 3);
+    EXPECT_FALSE(database->getLetterCounts().contains("R"));
+    
+    ASSERT_TRUE(database->clearAllContacts());
+    EXPECT_EQ(database->getContactCount(), 0);
+    EXPECT_TRUE(database->getLetterCounts().isEmpty());
+    EXPECT_TRUE(database->getDomainCounts().isEmpty());
+}
+
+TEST_F(DatabaseTest, ContactStatsBuiltForExistingDatabase) {
+    database->saveContacts({contact1, contact2});
+    database->close();
+    
+    // A database written before the counters existed
+    {
+        QSqlDatabase legacy = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+        legacy.setDatabaseName(tempFile->fileName());
+        ASSERT_TRUE(legacy.open());
+        QSqlQuery query(legacy);
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contact_stats_insert"));
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contact_stats_delete"));
+        ASSERT_TRUE(query.exec("DROP TRIGGER IF EXISTS contact_stats_update"));
+        ASSERT_TRUE(query.exec("DROP TABLE IF EXISTS contact_stats"));
+        ASSERT_TRUE(query.exec("PRAGMA user_version = 2"));
+        ASSERT_TRUE(query.exec("INSERT INTO contacts (name, phone, email) "
+                               "VALUES ('Legacy Person', '555-0000', 'legacy@old.example.com')"));
+        legacy.close();
+    }
+    QSqlDatabase::removeDatabase("legacy");
+    
+    ASSERT_TRUE(database->initialize(tempFile->fileName()));
+    EXPECT_EQ(database->getContactCount(), 3);
+    EXPECT_EQ(database->getDomainCounts().value("old.example.com"), 1);
+    EXPECT_EQ(database->getLetterCounts().value("L"), 1);
+}
+
+TEST_F(DatabaseTest, MigrationsApplyOnce) {
+    EXPECT_GT(Database::latestSchemaVersion(), 0);
+    EXPECT_EQ(database->schemaVersion(), Database::latestSchemaVersion());
+    
+    // A warm start finds nothing to do and keeps the data
+    database->saveContact(contact1);
+    database->close();
+    ASSERT_TRUE(database->initialize(tempFile->fileName()));
+    EXPECT_EQ(database->schemaVersion(), Database::latestSchemaVersion());
+    EXPECT_EQ(database->getContactCount(), 1);
+}
+
+TEST_F(DatabaseTest, MigratesUnversionedDatabase) {
+    database->close();
+    
+    // The schema as it was before versioning: plain indexes, user_version 0
+    QTemporaryFile legacyFile;
+    ASSERT_TRUE(legacyFile.open());
+    legacyFile.close();
+    {
+        QSqlDatabase legacy = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+        legacy.setDatabaseName(legacyFile.fileName());
+        ASSERT_TRUE(legacy.open());
+        QSqlQuery query(legacy);
+        ASSERT_TRUE(query.exec("CREATE TABLE contacts (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                               "name TEXT NOT NULL, phone TEXT NOT NULL, email TEXT, "
+                               "created_at DATETIME DEFAULT CURRENT_TIMESTAMP, "
+                               "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP)"));
+        ASSERT_TRUE(query.exec("CREATE INDEX idx_contacts_name ON contacts (name)"));
+        ASSERT_TRUE(query.exec("INSERT INTO contacts (name, phone, email) "
+                               "VALUES ('Old Timer', '555-0000', 'old@example.com')"));
+        legacy.close();
+    }
+    QSqlDatabase::removeDatabase("legacy");
+    
+    ASSERT_TRUE(database->initialize(legacyFile.fileName()));
+    EXPECT_EQ(database->schemaVersion(), Database::latestSchemaVersion());
+    EXPECT_EQ(database->getContactCount(), 1);
+    EXPECT_EQ(database->getDomainCounts().value("example.com"), 1);
+    EXPECT_FALSE(database->explainQueryPlan("SELECT id FROM contacts ORDER BY name COLLATE NOCASE, id")
+                 .join(' ').contains("idx_contacts_name "));
+}
+
+TEST(SqlScriptTest, SplitsStatementsKeepingTriggerBodies) {
+    const QString script = R"(
+        -- leading comment; not a statement
+        CREATE TABLE t (a TEXT);
+        INSERT INTO t VALUES ('semi;colon'), ("quoted;id");  /* block ; comment */
+        CREATE TRIGGER t_insert AFTER INSERT ON t BEGIN
+            UPDATE t SET a = CASE WHEN new.a = 'x' THEN 'y' ELSE new.a END;
+            DELETE FROM t WHERE a = 'it''s;';
+        END;
+        SELECT 1
+    )";
+    
+    const QStringList statements = Database::splitSqlStatements(script);
+    ASSERT_EQ(statements.size(), 4);
+    EXPECT_TRUE(statements[0].startsWith("CREATE TABLE t"));
+    EXPECT_TRUE(statements[1].contains("'semi;colon'"));
+    EXPECT_FALSE(statements[1].contains("block"));
+    EXPECT_TRUE(statements[2].startsWith("CREATE TRIGGER t_insert"));
+    EXPECT_TRUE(statements[2].endsWith("END"));
+    EXPECT_TRUE(statements[2].contains("'it''s;'"));
+    EXPECT_EQ(statements[3], "SELECT 1");
+}
+
+TEST_F(DatabaseTest, KeysetPagination) {
+    QList<Contact> contacts;
+    for (int i = 0; i < 25; ++i) {
+        contacts.append(Contact(QString("Person %1").arg(i, 2, 10, QChar('0')), "555-0000"));
+    }
+    contacts.append(Contact("Person 05", "555-1111"));  // Duplicate name, later id
+    ASSERT_TRUE(database->saveContacts(contacts).success);
+    
+    QList<Contact> all;
+    PageKey key;
+    int pages = 0;
+    forever {
+        QList<Contact> page = database->getContactsPage(key, 10, &key);
+        if (page.isEmpty()) {
+            break;
+        }
+        all.append(page);
+        pages++;
+    }
+    
+    EXPECT_EQ(pages, 3);
+    ASSERT_EQ(all.size(), 26);
+    EXPECT_EQ(all[5].getName(), "Person 05");
+    EXPECT_EQ(all[6].getName(), "Person 05");
+    EXPECT_LT(all[5].getId(), all[6].getId());
+    EXPECT_EQ(all, database->getAllContacts());
+    
+    // Past the end the key stays on the last row instead of starting over
+    EXPECT_FALSE(key.isStart());
+    EXPECT_EQ(key.id, all.last().getId());
+    EXPECT_TRUE(database->getContactsPage(key, 10, &key).isEmpty());
+    EXPECT_EQ(key.id, all.last().getId());
+    
+    // Following the contract from a fresh key ends after the last page
+    PageKey following;
+    int fetched = 0;
+    for (int i = 0; i < 10; ++i) {
+        fetched += database->getContactsPage(following, 10, &following).size();
+    }
+    EXPECT_EQ(fetched, 26);
+}
+
+TEST_F(DatabaseTest, NamesOrderCaseInsensitively) {
+    database->saveContacts({Contact("bob", "555-0002"), Contact("Alice", "555-0001"),
+                            Contact("carol", "555-0003"), Contact("Bobby", "555-0004")});
+    
+    QStringList names;
+    for (const Contact& contact : database->getAllContacts()) {
+        names << contact.getName();
+    }
+    EXPECT_EQ(names, QStringList({"Alice", "bob", "Bobby", "carol"}));
+    
+    PageKey next;
+    QList<Contact> page = database->getContactsPage(PageKey(), 2, &next);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[1].getName(), "bob");
+    page = database->getContactsPage(next, 2);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0].getName(), "Bobby");
+    
+    ASSERT_EQ(database->getContactsByPhone("555-0003").size(), 1);
+    EXPECT_EQ(database->getContactsByPhone("555-0003").first().getName(), "carol");
+}
+
+TEST_F(DatabaseTest, OrderedScansAndPhoneLookupsUseCoveringIndexes) {
+    auto expectCovered = [this](const QString& sql, const QVariantList& bindValues, const QString& index) {
+        QString plan = database->explainQueryPlan(sql, bindValues).join('\n');
+        EXPECT_TRUE(plan.contains("USING COVERING INDEX " + index)) << qPrintable(sql) << "\n" << qPrintable(plan);
+        EXPECT_FALSE(plan.contains("TEMP B-TREE")) << qPrintable(sql) << "\n" << qPrintable(plan);
+    };
+    
+    expectCovered("SELECT id, name, phone, email FROM contacts ORDER BY name COLLATE NOCASE, id",
+                  {}, "idx_contacts_name_nocase");
+    const QString pageQuery = "SELECT id, name, phone, email FROM contacts "
+                              "WHERE name COLLATE NOCASE >= ? AND (name COLLATE NOCASE, id) > (?, ?) "
+                              "ORDER BY name COLLATE NOCASE, id LIMIT ?";
+    expectCovered(pageQuery, {"m", "m", 0, 50}, "idx_contacts_name_nocase");
+    EXPECT_TRUE(database->explainQueryPlan(pageQuery, {"m", "m", 0, 50}).join(' ').startsWith("SEARCH"));
+    expectCovered("SELECT id, name, phone, email FROM contacts WHERE phone = ? ORDER BY name COLLATE NOCASE",
+                  {"555-0000"}, "idx_contacts_phone_covering");
+}
+
+TEST_F(DatabaseTest, ForEachContactStopsEarly) {
+    database->saveContacts({contact1, contact2, contact3});
+    
+    QStringList names;
+    EXPECT_TRUE(database->forEachContact([&names](const Contact& contact) {
+        names.append(contact.getName());
+        return names.size() < 2;
+    }));
+    EXPECT_EQ(names, QStringList({"Alice Johnson", "Bob Smith"}));
+}
+
+TEST_F(DatabaseTest, ReadsFromWorkerThreads) {
+    database->saveContacts({contact1, contact2, contact3});
+    
+    QList<QThread*> threads;
+    QAtomicInt found = 0;
+    for (int i = 0; i < 4; ++i) {
+        threads.append(QThread::create([this, &found]() {
+            found.fetchAndAddRelaxed(database->getContactCount());
+            found.fetchAndAddRelaxed(database->searchContacts("Smith").size());
+        }));
+        threads.last()->start();
+    }
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    
+    EXPECT_EQ(found.loadRelaxed(), 4 * (3 + 1));
+    // Each connection is released when its thread finishes
+    EXPECT_EQ(database->readerConnectionCount(), 0);
+}
+
+TEST_F(DatabaseTest, PreparedStatementsAreReused) {
+    EXPECT_EQ(database->cachedStatementCount(), 0);
+    
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(database->saveContact(Contact(QString("Contact %1").arg(i), "555-0000")));
+    }
+    QList<Contact> stored = database->getAllContacts();
+    ASSERT_EQ(stored.size(), 3);
+    
+    for (Contact contact : stored) {
+        EXPECT_EQ(database->getContact(contact.getId()).getName(), contact.getName());
+        contact.setPhone("555-1111");
+        EXPECT_TRUE(database->updateContact(contact));
+        EXPECT_EQ(database->getContact(contact.getId()).getPhone(), "555-1111");
+    }
+    EXPECT_TRUE(database->deleteContact(stored[0].getId()));
+    EXPECT_FALSE(database->deleteContact(stored[0].getId()));
+    EXPECT_TRUE(database->deleteContact(stored[1].getId()));
+    
+    // One statement each for insert, select, update and delete
+    EXPECT_EQ(database->cachedStatementCount(), 4);
+    EXPECT_EQ(database->getContactCount(), 1);
+    
+    // Reader threads prepare their own copies on their own connection
+    int readerStatements = 0;
+    QThread* reader = QThread::create([this, &stored, &readerStatements]() {
+        database->getContact(stored[2].getId());
+        database->getContact(stored[2].getId());
+        readerStatements = database->cachedStatementCount();
+    });
+    reader->start();
+    reader->wait();
+    delete reader;
+    EXPECT_EQ(readerStatements, 1);
+}
+
+TEST_F(DatabaseTest, WriteBehindCoalescesAndFlushes) {
+    database->saveContacts({contact1, contact2});
+    QList<Contact> stored = database->getAllContacts();
+    ASSERT_EQ(stored.size(), 2);
+    
+    DatabaseWriter writer;
+    DatabaseWriter::Options options;
+    options.commitIntervalMs = 10000;  // Only flush() commits in this test
+    ASSERT_TRUE(writer.start(tempFile->fileName(), options));
+    
+    Contact alice = stored[0];
+    for (int i = 0; i < 5; ++i) {
+        alice.setEmail(QString("alice%1@example.com").arg(i));
+        writer.updateContact(alice);
+    }
+    writer.updateContact(stored[1]);
+    writer.deleteContact(stored[1].getId());
+    writer.saveContact(contact3);
+    
+    ASSERT_TRUE(writer.flush(5000));
+    EXPECT_EQ(writer.pendingOperations(), 0);
+    EXPECT_EQ(database->getContact(alice.getId()).getEmail(), "alice4@example.com");
+    EXPECT_EQ(database->getContactCount(), 2);
+    
+    DatabaseWriter::Stats stats = writer.stats();
+    EXPECT_EQ(stats.enqueued, 8u);
+    EXPECT_EQ(stats.coalesced, 5u);
+    EXPECT_EQ(stats.committed, 8u);
+    EXPECT_EQ(stats.failedBatches, 0u);
+    
+    writer.stop();
+    EXPECT_FALSE(writer.isRunning());
+}
+
+TEST_F(DatabaseTest, SyncPersistsOnlyDirtyContacts) {
+    database->saveContacts({contact1, contact2});
+    
+    ContactManager manager;
+    ContactSync sync(&manager, database);
+    ASSERT_TRUE(sync.loadAll());
+    EXPECT_EQ(manager.getContactCount(), 2);
+    EXPECT_FALSE(sync.hasUnsavedChanges());
+    
+    const int aliceId = database->getAllContacts()[0].getId();
+    const Contact* found = manager.findContactById(aliceId);
+    ASSERT_NE(found, nullptr);
+    const Contact alice = *found;
+    EXPECT_EQ(alice.getName(), "Alice Johnson");
+    Contact editedAlice = alice;
+    editedAlice.setEmail("alice@work.example.com");
+    
+    ASSERT_TRUE(manager.updateContact(alice, editedAlice));
+    ASSERT_TRUE(manager.removeContact(contact2));
+    ASSERT_TRUE(manager.addContact(contact3));
+    EXPECT_TRUE(sync.hasUnsavedChanges());
+    
+    // Two upserts and one delete; the untouched rows are not rewritten
+    BulkWriteResult result = sync.persist();
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.rowsAffected, 3);
+    EXPECT_FALSE(sync.hasUnsavedChanges());
+    
+    EXPECT_EQ(database->getContactCount(), 2);
+    EXPECT_EQ(database->getContact(aliceId).getEmail(), "alice@work.example.com");
+    
+    // The new contact was inserted under an id from the table and took it
+    const Contact* charlie = manager.findContact("Charlie Brown", "555-1234");
+    ASSERT_NE(charlie, nullptr);
+    EXPECT_EQ(database->getContact(charlie->getId()).getName(), "Charlie Brown");
+    
+    // Nothing left to write
+    result = sync.persist();
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.rowsAffected, 0);
+}
+
+TEST_F(DatabaseTest, SyncReloadsRowsChangedElsewhere) {
+    database->saveContacts({contact1, contact2});
+    
+    ContactManager manager;
+    ContactSync sync(&manager, database);
+    ASSERT_TRUE(sync.loadAll());
+    EXPECT_FALSE(sync.watermark().isEmpty());
+    
+    // Another writer edits one row and adds one
+    Contact bob = database->getAllContacts()[1];
+    bob.setPhone("111-222-3333");
+    ASSERT_TRUE(database->updateContact(bob));
+    ASSERT_TRUE(database->saveContact(contact3));
+    
+    // Rows from the watermark's second come back too but are unchanged
+    EXPECT_EQ(sync.reload(), 2);
+    EXPECT_EQ(manager.getContactCount(), 3);
+    const Contact* reloadedBob = manager.findContactById(bob.getId());
+    ASSERT_NE(reloadedBob, nullptr);
+    EXPECT_EQ(reloadedBob->getPhone(), "111-222-3333");
+    EXPECT_FALSE(sync.hasUnsavedChanges());
+    
+    // Unsaved local edits win over stored rows
+    Contact localBob = bob;
+    localBob.setPhone("999-999-9999");
+    ASSERT_TRUE(manager.updateContact(bob, localBob));
+    EXPECT_EQ(manager.mergeStoredContacts({bob}), 0);
+    ASSERT_NE(manager.findContactById(bob.getId()), nullptr);
+    EXPECT_EQ(manager.findContactById(bob.getId())->getPhone(), "999-999-9999");
+}
+
+TEST_F(DatabaseTest, SyncNeverWritesUnderClientIds) {
+    ContactManager manager;
+    ContactSync sync(&manager, database);
+    ASSERT_TRUE(sync.loadAll());
+    
+    // An unsaved contact, and another writer whose row takes the same id
+    ASSERT_TRUE(manager.addContact(contact3));
+    const int localId = contact3.getId();
+    Contact dana("Dana Scully", "555-0004");
+    dana.setId(localId);
+    ASSERT_TRUE(database->upsertContacts({dana}).success);
+    
+    // The stored row keeps the id; the local contact moves aside
+    EXPECT_EQ(sync.reload(), 1);
+    ASSERT_NE(manager.findContactById(localId), nullptr);
+    EXPECT_EQ(manager.findContactById(localId)->getName(), "Dana Scully");
+    const Contact* charlie = manager.findContact("Charlie Brown", "555-1234");
+    ASSERT_NE(charlie, nullptr);
+    EXPECT_NE(charlie->getId(), localId);
+    
+    // Persisting inserts Charlie as a new row instead of overwriting Dana
+    ASSERT_TRUE(sync.persist().success);
+    EXPECT_EQ(database->getContactCount(), 2);
+    EXPECT_EQ(database->getContact(localId).getName(), "Dana Scully");
+    charlie = manager.findContact("Charlie Brown", "555-1234");
+    ASSERT_NE(charlie, nullptr);
+    EXPECT_EQ(database->getContact(charlie->getId()).getName(), "Charlie Brown");
+    EXPECT_FALSE(sync.hasUnsavedChanges());
+    
+    // Edits to it now update that row
+    const Contact storedCharlie = *charlie;
+    Contact editedCharlie = storedCharlie;
+    editedCharlie.setEmail("charlie@work.example.com");
+    ASSERT_TRUE(manager.updateContact(storedCharlie, editedCharlie));
+    ASSERT_TRUE(sync.persist().success);
+    EXPECT_EQ(database->getContactCount(), 2);
+    EXPECT_EQ(database->getContact(editedCharlie.getId()).getEmail(), "charlie@work.example.com");
+}
+
+TEST_F(DatabaseTest, SyncImportKeepsStoredRows) {
+    database->saveContacts({contact1, contact2});
+    const QList<Contact> stored = database->getAllContacts();
+    ASSERT_EQ(stored.size(), 2);
+    
+    ContactManager manager;
+    ContactSync sync(&manager, database);
+    ASSERT_TRUE(sync.loadAll());
+    
+    // A file written elsewhere whose ids overlap the table's
+    Contact dana("Dana Scully", "555-0004");
+    dana.setId(stored[0].getId());
+    Contact fox("Fox Mulder", "555-0005");
+    fox.setId(stored[1].getId());
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    file.close();
+    FileHandler fileHandler;
+    ASSERT_TRUE(fileHandler.exportToCsv({dana, fox}, file.fileName()));
+    
+    const ImportReport report = manager.importContactsBatch(fileHandler.importFromCsv(file.fileName()));
+    EXPECT_EQ(report.added, 2);
+    ASSERT_NE(manager.findContactById(stored[0].getId()), nullptr);
+    EXPECT_EQ(manager.findContactById(stored[0].getId())->getName(), "Alice Johnson");
+    
+    // Both are inserted as new rows; neither stored row is overwritten
+    ASSERT_TRUE(sync.persist().success);
+    EXPECT_EQ(database->getContactCount(), 4);
+    EXPECT_EQ(database->getContact(stored[0].getId()).getName(), "Alice Johnson");
+    EXPECT_EQ(database->getContact(stored[1].getId()).getName(), "Bob Smith");
+    const Contact* importedDana = manager.findContact("Dana Scully", "555-0004");
+    ASSERT_NE(importedDana, nullptr);
+    EXPECT_EQ(database->getContact(importedDana->getId()).getName(), "Dana Scully");
+}
+
+TEST_F(DatabaseTest, BackupAndRestore) {
+    database->saveContacts({contact1, contact2, contact3});
+    
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString backupPath = dir.filePath("phonebook.bak");
+    
+    DatabaseBackup backup;
+    DatabaseBackup::Options options;
+    options.pagesPerStep = 1;    // Many small steps
+    options.stepDelayMs = 0;
+    
+    int lastCopied = -1;
+    int lastTotal = -1;
+    bool succeeded = false;
+    QObject::connect(&backup, &DatabaseBackup::progress, [&](int pagesCopied, int pageCount) {
+        lastCopied = pagesCopied;
+        lastTotal = pageCount;
+    });
+    QObject::connect(&backup, &DatabaseBackup::finished, [&](bool success, const QString&) {
+        succeeded = success;
+    });
+    
+    // The live connection stays open throughout
+    ASSERT_TRUE(backup.backup(database->databasePath(), backupPath, options));
+    ASSERT_TRUE(backup.wait(10000));
+    EXPECT_TRUE(succeeded);
+    EXPECT_GT(lastTotal, 0);
+    EXPECT_EQ(lastCopied, lastTotal);
+    EXPECT_TRUE(QFile::exists(backupPath));
+    EXPECT_FALSE(QFile::exists(backupPath + ".part"));
+    
+    // Lose everything, then restore
+    ASSERT_TRUE(database->clearAllContacts());
+    const QString databasePath = database->databasePath();
+    database->close();
+    
+    succeeded = false;
+    ASSERT_TRUE(backup.restore(backupPath, databasePath, options));
+    ASSERT_TRUE(backup.wait(10000));
+    EXPECT_TRUE(succeeded);
+    
+    ASSERT_TRUE(database->initialize(databasePath));
+    EXPECT_EQ(database->getContactCount(), 3);
+    EXPECT_EQ(database->searchContacts("Charlie").size(), 1);
+}
+
+TEST_F(DatabaseTest, BackupCancelLeavesNoFile) {
+#ifndef PHONEBOOK_HAVE_SQLITE3
+    GTEST_SKIP() << "VACUUM INTO fallback copies in one step and cannot be cancelled";
+#endif
+    QList<Contact> contacts;
+    for (int i = 0; i < 2000; ++i) {
+        contacts.append(Contact(QString("Person %1").arg(i), "555-0000", "person@example.com"));
+    }
+    database->saveContacts(contacts);
+    
+    QTemporaryDir dir;
+    const QString backupPath = dir.filePath("cancelled.bak");
+    
+    DatabaseBackup backup;
+    DatabaseBackup::Options options;
+    options.pagesPerStep = 1;
+    options.stepDelayMs = 20;
+    
+    ASSERT_TRUE(backup.backup(database->databasePath(), backupPath, options));
+    EXPECT_FALSE(backup.backup(database->databasePath(), backupPath, options));    // One job at a time
+    backup.cancel();
+    ASSERT_TRUE(backup.wait(10000));
+    
+    EXPECT_FALSE(QFile::exists(backupPath));
+    EXPECT_FALSE(QFile::exists(backupPath + ".part"));
+}
+
+TEST_F(DatabaseTest, ChangeLogRecordsWritesInOrder) {
+    const qint64 start = database->lastChangeSeq();
+    
+    database->saveContact(Contact("Ann Lee", "555-0001", "ann@example.com"));
+    database->saveContact(Contact("Ben Ray", "555-0002"));
+    QList<Contact> stored = database->searchContacts("Ann Lee");
+    ASSERT_EQ(stored.size(), 1);
+    Contact ann = stored.first();
+    ann.setEmail("ann@work.example.com");
+    ASSERT_TRUE(database->updateContact(ann));
+    ASSERT_TRUE(database->deleteContact(ann.getId()));
+    
+    const QList<ChangeLogEntry> changes = database->getChangesSince(start);
+    ASSERT_EQ(changes.size(), 4);
+    EXPECT_EQ(changes[0].operation, ChangeLogEntry::Insert);
+    EXPECT_EQ(changes[1].operation, ChangeLogEntry::Insert);
+    EXPECT_EQ(changes[2].operation, ChangeLogEntry::Update);
+    EXPECT_EQ(changes[2].contact.getEmail(), "ann@work.example.com");
+    EXPECT_EQ(changes[3].operation, ChangeLogEntry::Delete);
+    EXPECT_EQ(changes[3].contact.getId(), ann.getId());
+    EXPECT_EQ(changes[3].contact.getName(), "Ann Lee");    // Deletes carry the removed row
+    EXPECT_EQ(database->lastChangeSeq(), changes.last().seq);
+    
+    // Reading in batches from the last applied seq sees every entry once
+    QList<qint64> seqs;
+    qint64 after = start;
+    QList<ChangeLogEntry> batch;
+    while (!(batch = database->getChangesSince(after, 3)).isEmpty()) {
+        for (const ChangeLogEntry& entry : batch) {
+            seqs.append(entry.seq);
+        }
+        after = batch.last().seq;
+    }
+    ASSERT_EQ(seqs.size(), 4);
+    EXPECT_TRUE(std::is_sorted(seqs.begin(), seqs.end()));
+}
+
+TEST_F(DatabaseTest, ChangeLogCompactsAndTruncates) {
+    const qint64 start = database->lastChangeSeq();
+    
+    database->saveContact(Contact("Cara Diaz", "555-0003"));
+    database->saveContact(Contact("Dev Shah", "555-0004"));
+    Contact cara = database->searchContacts("Cara Diaz").first();
+    for (int i = 0; i < 5; ++i) {
+        cara.setEmail(QString("cara%1@example.com").arg(i));
+        ASSERT_TRUE(database->updateContact(cara));
+    }
+    const qint64 last = database->lastChangeSeq();
+    EXPECT_EQ(database->getChangesSince(start).size(), 7);
+    
+    // Only the newest entry per contact survives, so replay still ends in
+    // the current state
+    EXPECT_EQ(database->compactChangeLog(last), 5);
+    const QList<ChangeLogEntry> compacted = database->getChangesSince(start);
+    ASSERT_EQ(compacted.size(), 2);
+    EXPECT_EQ(compacted[0].contact.getName(), "Dev Shah");
+    EXPECT_EQ(compacted[1].contact.getEmail(), "cara4@example.com");
+    EXPECT_EQ(compacted[1].seq, last);
+    
+    const int remaining = database->getChangesSince(0).size();
+    EXPECT_EQ(database->truncateChangeLog(last), remaining);
+    EXPECT_TRUE(database->getChangesSince(0).isEmpty());
+    
+    // AUTOINCREMENT never hands out a truncated seq again
+    database->saveContact(Contact("Eve Park", "555-0005"));
+    EXPECT_GT(database->lastChangeSeq(), last);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
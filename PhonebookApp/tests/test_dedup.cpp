@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "core/Deduplicator.h"
+#include "core/BloomFilter.h"
+#include "core/Contact.h"
+
+class DeduplicatorTest : public ::testing::Test {
+protected:
+    Deduplicator dedup;
+};
+
+TEST_F(DeduplicatorTest, NormalizePhone) {
+    EXPECT_EQ(dedup.phoneKey("+1 555-1234"), "5551234");
+    EXPECT_EQ(dedup.phoneKey("001 (555) 1234"), "5551234");
+    EXPECT_EQ(dedup.phoneKey("555.1234"), "5551234");
+    EXPECT_EQ(dedup.phoneKey("+44 20 7946 0000"), "+442079460000");
+    EXPECT_TRUE(dedup.phoneKey("123").isEmpty());
+}
+
+TEST_F(DeduplicatorTest, NormalizeEmailAndName) {
+    EXPECT_EQ(Deduplicator::emailKey(" John.Doe+work@GoogleMail.com"), "johndoe@gmail.com");
+    EXPECT_EQ(Deduplicator::emailKey("j.doe+x@corp.com"), "j.doe@corp.com");
+    EXPECT_TRUE(Deduplicator::emailKey("not-an-email").isEmpty());
+    EXPECT_EQ(Deduplicator::nameKey("Smith,  John"), Deduplicator::nameKey("john smith"));
+}
+
+TEST_F(DeduplicatorTest, BloomFilterHasNoFalseNegatives) {
+    BloomFilter filter(1000);
+    for (int i = 0; i < 1000; ++i) {
+        filter.add(QString::number(i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filter.mightContain(QString::number(i)));
+    }
+
+    int falsePositives = 0;
+    for (int i = 1000; i < 11000; ++i) {
+        falsePositives += filter.mightContain(QString::number(i)) ? 1 : 0;
+    }
+    EXPECT_LT(falsePositives, 500);
+    EXPECT_FALSE(filter.testAndAdd("fresh"));
+    EXPECT_TRUE(filter.testAndAdd("fresh"));
+}
+
+TEST_F(DeduplicatorTest, GroupsExactDuplicates) {
+    QList<Contact> incoming = {
+        Contact("John Smith", "+1 555-1234"),
+        Contact("Jane Doe", "555-9876", "jane@corp.com"),
+        Contact("J. Smith", "5551234", "john@corp.com"),
+        Contact("Doe Jane", "555-0000"),
+        Contact("Unrelated Person", "555-4444")
+    };
+
+    MergePlan plan = dedup.plan(incoming);
+    ASSERT_EQ(plan.groups.size(), 2);
+    EXPECT_EQ(plan.groups[0].rows, QList<int>({0, 2}));
+    EXPECT_EQ(plan.groups[0].reasons, MergePlan::SamePhone);
+    EXPECT_EQ(plan.groups[0].merged.getName(), "John Smith");
+    EXPECT_EQ(plan.groups[0].merged.getEmail(), "john@corp.com");
+    EXPECT_EQ(plan.groups[1].rows, QList<int>({1, 3}));
+    EXPECT_EQ(plan.groups[1].reasons, MergePlan::SameName);
+    EXPECT_EQ(plan.uniqueRows, QList<int>({4}));
+    EXPECT_EQ(plan.duplicateRows(), 2);
+    EXPECT_GT(plan.bloomSkipped, 0);
+
+    QList<Contact> survivors = plan.contactsToImport(incoming);
+    ASSERT_EQ(survivors.size(), 3);
+    EXPECT_EQ(survivors[0].getName(), "John Smith");
+    EXPECT_EQ(survivors[1].getName(), "Jane Doe");
+    EXPECT_EQ(survivors[2].getName(), "Unrelated Person");
+}
+
+TEST_F(DeduplicatorTest, MatchesExistingContacts) {
+    QList<Contact> existing = {
+        Contact("Alice Johnson", "555-1111"),
+        Contact("Bob Brown", "555-2222", "bob@corp.com")
+    };
+    QList<Contact> incoming = {
+        Contact("Alice J", "+1 555 1111", "alice@corp.com"),
+        Contact("Carol White", "555-3333")
+    };
+
+    MergePlan plan = dedup.plan(incoming, existing);
+    ASSERT_EQ(plan.groups.size(), 1);
+    EXPECT_EQ(plan.groups[0].existingIndex, 0);
+    EXPECT_TRUE(plan.groups[0].updatesExisting);
+    EXPECT_EQ(plan.groups[0].merged.getName(), "Alice Johnson");
+    EXPECT_EQ(plan.groups[0].merged.getEmail(), "alice@corp.com");
+
+    QList<Contact> survivors = plan.contactsToImport(incoming);
+    ASSERT_EQ(survivors.size(), 1);
+    EXPECT_EQ(survivors[0].getName(), "Carol White");
+}
+
+TEST_F(DeduplicatorTest, ClustersSimilarNames) {
+    QList<Contact> incoming = {
+        Contact("Maximilian Oberhausen", "555-1000"),
+        Contact("Maximillian Oberhausen", "555-2000"),
+        Contact("Completely Different", "555-3000")
+    };
+
+    MergePlan plan = dedup.plan(incoming);
+    ASSERT_EQ(plan.groups.size(), 1);
+    EXPECT_EQ(plan.groups[0].rows, QList<int>({0, 1}));
+    EXPECT_TRUE(plan.groups[0].needsReview());
+
+    // Left for review: nothing is merged away
+    EXPECT_EQ(plan.duplicateRows(), 0);
+    EXPECT_EQ(plan.rowsToImport(), QList<int>({0, 1, 2}));
+    EXPECT_EQ(plan.contactsToImport(incoming).size(), 3);
+
+    Deduplicator::Options options;
+    options.similarNames = false;
+    EXPECT_TRUE(Deduplicator(options).plan(incoming).groups.isEmpty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,8 +1,16 @@
 #include <gtest/gtest.h>
 #include <QTemporaryFile>
+#include <QTemporaryDir>
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QJsonObject>
+#include <QBuffer>
+#include <QSet>
 #include "core/FileHandler.h"
+#include "core/CsvReader.h"
+#include "core/JsonStreamWriter.h"
+#include "core/JsonPullParser.h"
+#include "core/ContactManager.h"
 #include "core/Contact.h"
 
 class FileHandlerTest : public ::testing::Test {
@@ -47,6 +55,76 @@ TEST_F(FileHandlerTest, ExportToJson) {
     EXPECT_EQ(array.size(), 3);
 }
 
+TEST_F(FileHandlerTest, StreamingJsonEscapesLikeQJson) {
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    
+    Contact awkward(QString::fromUtf8("Zo\u00eb \"Q\" O'Neil \\ \U0001F600"), "555\t0100",
+                    QString("line\nbreak\x01@example.com"));
+    {
+        JsonStreamWriter writer(&buffer, 256);    // Small buffer: several flushes
+        writer.beginArray();
+        for (int i = 0; i < 50; ++i) {
+            writer.writeContact(awkward);
+        }
+        writer.endArray();
+        EXPECT_FALSE(writer.hasError());
+        EXPECT_EQ(writer.contactsWritten(), 50);
+        EXPECT_EQ(writer.bytesWritten(), buffer.size());
+    }
+    
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(buffer.data(), &error);
+    ASSERT_EQ(error.error, QJsonParseError::NoError) << error.errorString().toStdString();
+    ASSERT_EQ(doc.array().size(), 50);
+    
+    QJsonObject last = doc.array().last().toObject();
+    EXPECT_EQ(last["id"].toInt(), awkward.getId());
+    EXPECT_EQ(last["name"].toString(), awkward.getName());
+    EXPECT_EQ(last["phone"].toString(), awkward.getPhone());
+    EXPECT_EQ(last["email"].toString(), awkward.getEmail());
+}
+
+TEST_F(FileHandlerTest, ExportToJsonFromCallbackSource) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    // Contacts are generated on demand, so no list ever exists
+    constexpr int count = 20000;
+    FileHandler::ContactSource source = [](const FileHandler::ContactVisitor& visit) {
+        for (int i = 0; i < count; ++i) {
+            if (!visit(Contact(QString("Person %1").arg(i), QString("555-%1").arg(i)))) {
+                break;
+            }
+        }
+        return true;
+    };
+    ASSERT_TRUE(fileHandler->exportToJson(source, fileName));
+    
+    QList<Contact> imported = fileHandler->importFromJson(fileName);
+    ASSERT_EQ(imported.size(), count);
+    EXPECT_EQ(imported.last().getName(), QString("Person %1").arg(count - 1));
+    
+    // An empty source still writes a valid document
+    ASSERT_TRUE(fileHandler->exportToJson(QList<Contact>(), fileName));
+    QFile file(fileName);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_TRUE(QJsonDocument::fromJson(file.readAll()).array().isEmpty());
+}
+
+TEST_F(FileHandlerTest, ExportToJsonDropsFileWhenSourceFails) {
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("failed.json");
+    
+    EXPECT_FALSE(fileHandler->exportToJson([this](const FileHandler::ContactVisitor& visit) {
+        visit(contacts.first());
+        return false;
+    }, fileName));
+    EXPECT_FALSE(QFile::exists(fileName));
+}
+
 TEST_F(FileHandlerTest, ExportToCsv) {
     QTemporaryFile tempFile;
     tempFile.open();
@@ -121,6 +199,413 @@ TEST_F(FileHandlerTest, ImportFromCsv) {
     EXPECT_EQ(importedContacts[2].getName(), "Charlie Brown");
 }
 
+TEST_F(FileHandlerTest, PullParserHandlesChunkBoundaries) {
+    QByteArray json = "[";
+    for (int i = 0; i < 500; ++i) {
+        json += QString("%1{\"id\":%2,\"name\":\"P\\u00e9rson \\\"%2\\\"\",\"tags\":[true,null,-1.5e2]}")
+                    .arg(i ? ",\n" : "").arg(i).toUtf8();
+    }
+    json += "]";
+    
+    // A tiny chunk size splits every kind of token across reads
+    QBuffer buffer(&json);
+    buffer.open(QIODevice::ReadOnly);
+    JsonPullParser parser(&buffer, 64);
+    
+    ASSERT_EQ(parser.next(), JsonPullParser::BeginArray);
+    int objects = 0;
+    QString lastName;
+    JsonPullParser::Token token;
+    while ((token = parser.next()) == JsonPullParser::BeginObject) {
+        while (parser.next() == JsonPullParser::Key) {
+            const QString key = parser.stringValue();
+            parser.next();
+            if (key == "name") {
+                lastName = parser.stringValue();
+            } else {
+                ASSERT_TRUE(parser.skipValue());
+            }
+        }
+        ++objects;
+    }
+    EXPECT_EQ(token, JsonPullParser::EndArray);
+    EXPECT_EQ(parser.next(), JsonPullParser::EndOfInput);
+    EXPECT_EQ(objects, 500);
+    EXPECT_EQ(lastName, QString::fromUtf8("P\u00e9rson \"499\""));
+    EXPECT_EQ(parser.bytesConsumed(), json.size());
+}
+
+TEST_F(FileHandlerTest, PullParserRejectsMalformedInput) {
+    const QList<QByteArray> malformed = {"[1,]", "[1 2]", "{\"a\" 1}", "[01]", "[tru]", "[1]]", "[\"abc", "[\"\\x\"]"};
+    for (QByteArray json : malformed) {
+        QBuffer buffer(&json);
+        buffer.open(QIODevice::ReadOnly);
+        JsonPullParser parser(&buffer);
+        
+        JsonPullParser::Token token;
+        do {
+            token = parser.next();
+        } while (token != JsonPullParser::Invalid && token != JsonPullParser::EndOfInput);
+        EXPECT_EQ(token, JsonPullParser::Invalid) << json.toStdString();
+        EXPECT_FALSE(parser.errorString().isEmpty());
+    }
+}
+
+TEST_F(FileHandlerTest, ImportFromJsonStreamsBatches) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    QList<Contact> many;
+    for (int i = 0; i < 1000; ++i) {
+        many.append(Contact(QString("Person %1").arg(i), QString("555-%1").arg(i)));
+    }
+    ASSERT_TRUE(fileHandler->exportToJson(many, fileName));
+    
+    qint64 lastProgress = 0;
+    qint64 total = 0;
+    QObject::connect(fileHandler, &FileHandler::importProgress, [&](qint64 bytesRead, qint64 totalBytes) {
+        EXPECT_GE(bytesRead, lastProgress);
+        lastProgress = bytesRead;
+        total = totalBytes;
+    });
+    
+    QList<int> batchSizes;
+    ASSERT_TRUE(fileHandler->importFromJson(fileName, [&batchSizes](const QList<Contact>& batch) {
+        batchSizes.append(batch.size());
+        return true;
+    }, 300));
+    EXPECT_EQ(batchSizes, QList<int>({300, 300, 300, 100}));
+    EXPECT_EQ(lastProgress, total);
+    
+    // A sink can stop the import early
+    int delivered = 0;
+    EXPECT_FALSE(fileHandler->importFromJson(fileName, [&delivered](const QList<Contact>& batch) {
+        delivered += batch.size();
+        return false;
+    }, 300));
+    EXPECT_EQ(delivered, 300);
+}
+
+TEST_F(FileHandlerTest, ImportFromJsonKeepsBatchesBeforeDamage) {
+    QTemporaryFile tempFile;
+    ASSERT_TRUE(tempFile.open());
+    tempFile.write("[{\"name\":\"Ann\",\"phone\":\"555-0001\"},\n"
+                   " {\"name\":\"Ben\",\"phone\":\"555-0002\",\"extra\":{\"nested\":[1,2]}},\n"
+                   " {\"name\":\"Cut");
+    tempFile.close();
+    
+    int delivered = 0;
+    EXPECT_FALSE(fileHandler->importFromJson(tempFile.fileName(), [&delivered](const QList<Contact>& batch) {
+        delivered += batch.size();
+        return true;
+    }, 1));
+    EXPECT_EQ(delivered, 2);
+    EXPECT_TRUE(fileHandler->importFromJson(tempFile.fileName()).isEmpty());
+}
+
+TEST_F(FileHandlerTest, StreamedImportFeedsContactManager) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    QList<Contact> many = contacts;
+    many.append(Contact("", "555-0000"));    // Invalid: no name
+    ASSERT_TRUE(fileHandler->exportToJson(many, fileName));
+    
+    ContactManager manager;
+    QFuture<ImportReport> future = manager.importStreamAsync(
+        [fileName](const ContactManager::BatchSink& sink, const std::function<void(qint64, qint64)>& progress) {
+            FileHandler handler;
+            QObject::connect(&handler, &FileHandler::importProgress, progress);
+            return handler.importFromJson(fileName, sink, 2);
+        });
+    
+    const ImportReport report = future.result();
+    EXPECT_TRUE(report.error.isEmpty());
+    EXPECT_EQ(report.total, 4);
+    EXPECT_EQ(report.added, 3);
+    EXPECT_EQ(report.invalid, 1);
+    EXPECT_EQ(manager.getContactCount(), 3);
+    EXPECT_EQ(future.progressValue(), ContactManager::STREAM_PROGRESS_STEPS);
+}
+
+TEST_F(FileHandlerTest, CsvReaderFollowsRfc4180) {
+    const QByteArray csv = "\xEF\xBB\xBFid,name\r\n"
+                           "1,\"Smith, Ann\"\r\n"
+                           "2,\"Says \"\"hi\"\"\"\r\n"
+                           "\r\n"
+                           "3,\"two\nlines\",\n"
+                           "4,last";
+    
+    for (bool simd : {false, true}) {
+        CsvReader::Options options;
+        options.useSimd = simd;
+        CsvReader reader(QByteArrayView(csv), options);
+        
+        QList<QStringList> records;
+        while (reader.readRecord()) {
+            QStringList fields;
+            for (int i = 0; i < reader.fieldCount(); ++i) {
+                fields.append(reader.field(i).toString());
+            }
+            records.append(fields);
+        }
+        
+        ASSERT_EQ(records.size(), 5) << "simd " << simd;
+        EXPECT_EQ(records[0], QStringList({"id", "name"}));    // BOM skipped
+        EXPECT_EQ(records[1], QStringList({"1", "Smith, Ann"}));
+        EXPECT_EQ(records[2], QStringList({"2", "Says \"hi\""}));
+        EXPECT_EQ(records[3], QStringList({"3", "two\nlines", ""}));
+        EXPECT_EQ(records[4], QStringList({"4", "last"}));
+        EXPECT_EQ(reader.malformedRecords(), 0);
+        EXPECT_EQ(reader.position(), csv.size());
+    }
+}
+
+TEST_F(FileHandlerTest, CsvReaderScannersAgree) {
+    // Long fields so the 16-byte SIMD path runs, with every special byte
+    // landing at varying offsets within a block
+    QByteArray csv;
+    for (int i = 0; i < 300; ++i) {
+        const QByteArray filler(i % 37, 'x');
+        csv += filler + "," + "\"" + filler + ",\"\"\n" + filler + "\"" + (i % 2 ? "\r\n" : "\n");
+    }
+    csv += "a,\"unterminated";
+    
+    auto dump = [&csv](bool simd) {
+        CsvReader::Options options;
+        options.useSimd = simd;
+        CsvReader reader(QByteArrayView(csv), options);
+        QList<QByteArray> fields;
+        while (reader.readRecord()) {
+            for (int i = 0; i < reader.fieldCount(); ++i) {
+                fields.append(reader.field(i).toString().toUtf8());
+            }
+            fields.append("|");
+        }
+        fields.append(QByteArray::number(reader.malformedRecords()));
+        return fields;
+    };
+    
+    const QList<QByteArray> scalar = dump(false);
+    EXPECT_EQ(scalar.size(), 300 * 3 + 3 + 1);
+    EXPECT_EQ(scalar.last(), "1");
+    EXPECT_EQ(dump(true), scalar);
+}
+
+TEST_F(FileHandlerTest, CsvRoundTripsAwkwardFields) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    QList<Contact> awkward;
+    awkward.append(Contact("Smith, \"Ann\"", "555-0100", "ann@example.com"));
+    awkward.append(Contact("Two\r\nLines", "(555) 0101"));
+    awkward.append(Contact(QString::fromUtf8("Zo\u00eb"), "+1 555 0102", "zoe@example.com"));
+    ASSERT_TRUE(fileHandler->exportToCsv(awkward, fileName));
+    
+    QList<Contact> imported = fileHandler->importFromCsv(fileName);
+    ASSERT_EQ(imported.size(), 3);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(imported[i].getId(), awkward[i].getId());
+        EXPECT_EQ(imported[i].getName(), awkward[i].getName());
+        EXPECT_EQ(imported[i].getPhone(), awkward[i].getPhone());
+        EXPECT_EQ(imported[i].getEmail(), awkward[i].getEmail());
+    }
+}
+
+namespace {
+    QStringList namesOf(const QList<Contact>& contacts) {
+        QStringList names;
+        for (const Contact& contact : contacts) {
+            names.append(contact.getName());
+        }
+        return names;
+    }
+}
+
+TEST_F(FileHandlerTest, ParallelCsvMatchesSerial) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    // Quoted commas, doubled quotes and line breaks put quote state at
+    // stake at many chunk cuts
+    QList<Contact> many;
+    for (int i = 0; i < 2000; ++i) {
+        const QString name = i % 3 == 0 ? QString("Last, \"First\" %1\nSecond line").arg(i)
+                                        : QString("Person %1").arg(i);
+        many.append(Contact(name, QString("555-%1").arg(i)));
+    }
+    ASSERT_TRUE(fileHandler->exportToCsv(many, fileName));
+    
+    const QList<Contact> serial = fileHandler->importFromCsv(fileName);
+    ASSERT_EQ(serial.size(), 2000);
+    
+    for (int chunks : {1, 7, 64}) {
+        QList<int> batchSizes;
+        ASSERT_TRUE(fileHandler->importParallel(fileName, FileHandler::CSV, [&batchSizes](const QList<Contact>& batch) {
+            batchSizes.append(batch.size());
+            return true;
+        }, chunks));
+        EXPECT_GT(batchSizes.size(), chunks / 2) << "chunks " << chunks;
+        
+        EXPECT_EQ(namesOf(fileHandler->importParallel(fileName, FileHandler::CSV)), namesOf(serial));
+    }
+}
+
+TEST_F(FileHandlerTest, ParallelJsonMatchesSerial) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    QList<Contact> many;
+    for (int i = 0; i < 2000; ++i) {
+        many.append(Contact(QString("Person \"%1\" },{ \\").arg(i), QString("555-%1").arg(i)));
+    }
+    ASSERT_TRUE(fileHandler->exportToJson(many, fileName));
+    
+    const QList<Contact> serial = fileHandler->importFromJson(fileName);
+    ASSERT_EQ(serial.size(), 2000);
+    
+    int batches = 0;
+    ASSERT_TRUE(fileHandler->importParallel(fileName, FileHandler::JSON, [&batches](const QList<Contact>&) {
+        ++batches;
+        return true;
+    }, 16));
+    EXPECT_GT(batches, 8);
+    EXPECT_EQ(namesOf(fileHandler->importParallel(fileName, FileHandler::JSON)), namesOf(serial));
+}
+
+TEST_F(FileHandlerTest, ParallelJsonFallsBackOnMisplacedCuts) {
+    // Indented, with nested arrays of objects whose "}, {" looks like a
+    // boundary between contacts
+    QJsonArray array;
+    for (int i = 0; i < 500; ++i) {
+        QJsonObject contact;
+        contact["name"] = QString("Person %1").arg(i);
+        contact["phone"] = QString("555-%1").arg(i);
+        contact["history"] = QJsonArray({QJsonObject({{"at", i}}), QJsonObject({{"at", i + 1}})});
+        array.append(contact);
+    }
+    
+    QTemporaryFile tempFile;
+    ASSERT_TRUE(tempFile.open());
+    tempFile.write(QJsonDocument(array).toJson(QJsonDocument::Indented));
+    tempFile.close();
+    
+    const QList<Contact> serial = fileHandler->importFromJson(tempFile.fileName());
+    ASSERT_EQ(serial.size(), 500);
+    
+    QList<Contact> parallel;
+    ASSERT_TRUE(fileHandler->importParallel(tempFile.fileName(), FileHandler::JSON, [&parallel](const QList<Contact>& batch) {
+        parallel.append(batch);
+        return true;
+    }, 32));
+    EXPECT_EQ(namesOf(parallel), namesOf(serial));
+}
+
+TEST_F(FileHandlerTest, ParallelImportKeepsBatchesBounded) {
+    auto largestBatch = [this](const QString& fileName, FileHandler::FileFormat format, int chunks, int* total) {
+        int largest = 0;
+        *total = 0;
+        EXPECT_TRUE(fileHandler->importParallel(fileName, format, [&](const QList<Contact>& batch) {
+            largest = qMax(largest, static_cast<int>(batch.size()));
+            *total += batch.size();
+            return true;
+        }, chunks));
+        return largest;
+    };
+    
+    // Compact JSON on one line offers no cut, so it streams serially
+    QJsonArray array;
+    for (int i = 0; i < 10000; ++i) {
+        QJsonObject contact;
+        contact["name"] = QString("Person %1").arg(i);
+        contact["phone"] = QString("555-%1").arg(i);
+        array.append(contact);
+    }
+    QTemporaryFile jsonFile;
+    ASSERT_TRUE(jsonFile.open());
+    jsonFile.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+    jsonFile.close();
+    
+    int total = 0;
+    EXPECT_LE(largestBatch(jsonFile.fileName(), FileHandler::JSON, 2, &total), FileHandler::DEFAULT_IMPORT_BATCH_SIZE);
+    EXPECT_EQ(total, 10000);
+    
+    // A malformed record fails the first chunk; the rest streams in batches
+    QTemporaryFile csvFile;
+    ASSERT_TRUE(csvFile.open());
+    QByteArray csv = "ID,Name,Phone,Email\n";
+    for (int i = 0; i < 10000; ++i) {
+        const QByteArray n = QByteArray::number(i);
+        csv += i == 5 ? QByteArray("5,\"Stray\"quote,555-5,\n")
+                      : n + ",Person " + n + ",555-" + n + ",\n";
+    }
+    csvFile.write(csv);
+    csvFile.close();
+    
+    EXPECT_LE(largestBatch(csvFile.fileName(), FileHandler::CSV, 2, &total), FileHandler::DEFAULT_IMPORT_BATCH_SIZE);
+    EXPECT_EQ(total, fileHandler->importFromCsv(csvFile.fileName()).size());
+    EXPECT_EQ(total, 10000);
+}
+
+TEST_F(FileHandlerTest, ParallelJsonReportsTruncation) {
+    QTemporaryFile tempFile;
+    tempFile.open();
+    QString fileName = tempFile.fileName();
+    tempFile.close();
+    
+    QList<Contact> many;
+    for (int i = 0; i < 1000; ++i) {
+        many.append(Contact(QString("Person %1").arg(i), QString("555-%1").arg(i)));
+    }
+    ASSERT_TRUE(fileHandler->exportToJson(many, fileName));
+    
+    QFile file(fileName);
+    ASSERT_TRUE(file.resize(file.size() - 10));
+    
+    EXPECT_FALSE(fileHandler->importParallel(fileName, FileHandler::JSON, [](const QList<Contact>&) {
+        return true;
+    }, 8));
+    EXPECT_TRUE(fileHandler->importParallel(fileName, FileHandler::JSON).isEmpty());
+}
+
+TEST_F(FileHandlerTest, ParallelImportHandsOutUniqueIds) {
+    // No ids in the file, so every chunk parser allocates them concurrently
+    QTemporaryFile tempFile;
+    ASSERT_TRUE(tempFile.open());
+    QByteArray csv = "ID,Name,Phone,Email\n";
+    for (int i = 0; i < 20000; ++i) {
+        const QByteArray n = QByteArray::number(i);
+        csv += ",Person " + n + ",555-" + n + ",\n";
+    }
+    tempFile.write(csv);
+    tempFile.close();
+    
+    QSet<int> ids;
+    int total = 0;
+    ASSERT_TRUE(fileHandler->importParallel(tempFile.fileName(), FileHandler::CSV, [&](const QList<Contact>& batch) {
+        for (const Contact& contact : batch) {
+            ids.insert(contact.getId());
+        }
+        total += batch.size();
+        return true;
+    }, 16));
+    EXPECT_EQ(total, 20000);
+    EXPECT_EQ(ids.size(), total);
+    
+    // Nor may a later contact reuse one of them
+    EXPECT_FALSE(ids.contains(Contact().getId()));
+}
+
 TEST_F(FileHandlerTest, DetectFileFormat) {
     EXPECT_EQ(FileHandler::detectFileFormat("test.json"), FileHandler::JSON);
     EXPECT_EQ(FileHandler::detectFileFormat("test.csv"), FileHandler::CSV);
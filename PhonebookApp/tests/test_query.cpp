@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "core/ContactQuery.h"
+#include "core/ContactIndex.h"
+#include "core/Contact.h"
+
+class ContactQueryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        index.insert(Contact("Alice Johnson", "555-1234", "alice@corp.com"));
+        index.insert(Contact("Alicia Keys", "(555) 987-6543", "alicia@music.org"));
+        index.insert(Contact("Bob Smith", "987-654-3210", "bob@corp.com"));
+        index.insert(Contact("Charlie Brown", "123-456-7890", "charlie@example.com"));
+    }
+
+    ContactIndex index;
+};
+
+TEST_F(ContactQueryTest, ParseFieldTerms) {
+    ContactQuery query = ContactQuery::compile("name:ali phone:555* email:@corp.com");
+    ASSERT_TRUE(query.isValid());
+    ASSERT_EQ(query.terms().size(), 3);
+
+    EXPECT_EQ(query.terms()[0].field, ContactQuery::NameField);
+    EXPECT_EQ(query.terms()[0].mode, ContactQuery::Contains);
+    EXPECT_EQ(query.terms()[1].field, ContactQuery::PhoneField);
+    EXPECT_EQ(query.terms()[1].mode, ContactQuery::Prefix);
+    EXPECT_EQ(query.terms()[1].value, "555");
+    EXPECT_EQ(query.terms()[2].field, ContactQuery::EmailField);
+    EXPECT_EQ(query.terms()[2].value, "@corp.com");
+}
+
+TEST_F(ContactQueryTest, ParseQuotedAndPlainWords) {
+    ContactQuery query = ContactQuery::compile("name:\"alice j\" Smith");
+    ASSERT_EQ(query.terms().size(), 2);
+    EXPECT_EQ(query.terms()[0].value, "alice j");
+    EXPECT_EQ(query.terms()[1].field, ContactQuery::AnyField);
+    EXPECT_EQ(query.terms()[1].value, "smith");
+}
+
+TEST_F(ContactQueryTest, PhoneTermWithoutDigitsIsInvalid) {
+    ContactQuery query = ContactQuery::compile("phone:abc");
+    EXPECT_FALSE(query.isValid());
+    EXPECT_TRUE(index.execute(query).isEmpty());
+}
+
+TEST_F(ContactQueryTest, ExecuteFieldQuery) {
+    QList<Contact> results = index.execute(ContactQuery::compile("name:ali phone:555*"));
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0].getName(), "Alice Johnson");
+    EXPECT_EQ(results[1].getName(), "Alicia Keys");
+
+    results = index.execute(ContactQuery::compile("name:ali email:@corp.com"));
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].getName(), "Alice Johnson");
+}
+
+TEST_F(ContactQueryTest, PlannerPicksSelectiveIndex) {
+    ContactQuery query = ContactQuery::compile("name:a* phone:123*");
+    ContactIndex::QueryPlan plan = index.plan(query);
+    EXPECT_EQ(plan.path, ContactIndex::PhoneIndex);
+    EXPECT_EQ(plan.estimatedRows, 1);
+    EXPECT_EQ(plan.totalRows, 4);
+
+    plan = index.plan(ContactQuery::compile("email:*music.org"));
+    EXPECT_EQ(plan.path, ContactIndex::EmailSuffixIndex);
+
+    plan = index.plan(ContactQuery::compile("ab"));
+    EXPECT_EQ(plan.path, ContactIndex::FullScan);
+    EXPECT_TRUE(plan.describe(ContactQuery::compile("ab")).startsWith("Full scan"));
+}
+
+TEST_F(ContactQueryTest, IndexMatchesFullScan) {
+    const QStringList queries = {"ali", "555", "corp", "name:*son", "email:bob*", "phone:654", "-1"};
+    for (const QString& text : queries) {
+        ContactQuery query = ContactQuery::compile(text);
+        ContactIndex::QueryPlan scan;
+        scan.totalRows = index.size();
+        EXPECT_EQ(index.execute(query), index.execute(query, scan)) << text.toStdString();
+    }
+}
+
+TEST_F(ContactQueryTest, RemoveUpdatesIndexes) {
+    EXPECT_TRUE(index.remove(Contact("Bob Smith", "987-654-3210")));
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_TRUE(index.execute(ContactQuery::compile("email:bob*")).isEmpty());
+    EXPECT_FALSE(index.remove(Contact("Bob Smith", "987-654-3210")));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
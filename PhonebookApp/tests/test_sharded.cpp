@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <algorithm>
+#include <random>
+#include "core/ShardedContactManager.h"
+#include "core/SearchSort.h"
+#include "core/ContactQuery.h"
+#include "core/Contact.h"
+
+class ShardedContactManagerTest : public ::testing::Test {
+protected:
+    ShardedContactManagerTest() : manager(4) {}
+    
+    // First "<prefix> N" whose shard differs from (or matches) shard
+    QString nameInShard(const QString& prefix, int shard, bool same) const {
+        for (int i = 0;; ++i) {
+            const QString name = QString("%1 %2").arg(prefix).arg(i);
+            if ((manager.shardFor(Contact(name, "")) == shard) == same) {
+                return name;
+            }
+        }
+    }
+    
+    ShardedContactManager manager;
+};
+
+TEST_F(ShardedContactManagerTest, AddRemoveAndFindAcrossShards) {
+    QStringList names;
+    for (int i = 0; i < 100; ++i) {
+        names.append(QString("Person %1").arg(i, 3, 10, QChar('0')));
+        ASSERT_TRUE(manager.addContact(Contact(names.last(), QString("555-%1").arg(i))));
+    }
+    EXPECT_EQ(manager.getContactCount(), 100);
+    
+    // Every shard got some, and merged reads come back in name order
+    QList<int> perShard(manager.shardCount());
+    for (const QString& name : names) {
+        perShard[manager.shardFor(Contact(name, ""))]++;
+    }
+    EXPECT_EQ(std::count(perShard.begin(), perShard.end(), 0), 0);
+    
+    QStringList merged;
+    for (const Contact& contact : manager.getAllContacts()) {
+        merged.append(contact.getName());
+    }
+    EXPECT_EQ(merged, names);
+    
+    // The name is the key, whatever the case
+    EXPECT_FALSE(manager.addContact(Contact("PERSON 042", "555-9999")));
+    EXPECT_FALSE(manager.addContact(Contact("", "555-9999")));
+    
+    ASSERT_EQ(manager.searchContacts("person 042").size(), 1);
+    EXPECT_EQ(manager.query(ContactQuery::compile("name:\"Person 042\"")).size(), 1);
+    
+    EXPECT_TRUE(manager.removeContact(Contact("Person 042", "")));
+    EXPECT_FALSE(manager.removeContact(Contact("Person 042", "")));
+    EXPECT_EQ(manager.getContactCount(), 99);
+    EXPECT_TRUE(manager.searchContacts("Person 042").isEmpty());
+    EXPECT_TRUE(manager.query(ContactQuery::compile("name:\"Person 042\"")).isEmpty());
+    
+    manager.clearAllContacts();
+    EXPECT_TRUE(manager.isEmpty());
+}
+
+TEST_F(ShardedContactManagerTest, UpdateMovesAcrossShards) {
+    const Contact original("Alice 0", "555-0001");
+    ASSERT_TRUE(manager.addContact(original));
+    const int home = manager.shardFor(original);
+    
+    const Contact renamed(nameInShard("Alicia", home, false), "555-0001");
+    ASSERT_NE(manager.shardFor(renamed), home);
+    ASSERT_TRUE(manager.updateContact(original, renamed));
+    
+    EXPECT_EQ(manager.getContactCount(), 1);
+    EXPECT_TRUE(manager.searchContacts("Alice 0").isEmpty());
+    ASSERT_EQ(manager.getAllContacts().size(), 1);
+    EXPECT_EQ(manager.getAllContacts()[0].getName(), renamed.getName());
+    EXPECT_EQ(manager.query(ContactQuery::compile("name:alicia")).size(), 1);
+    EXPECT_TRUE(manager.query(ContactQuery::compile("name:\"Alice 0\"")).isEmpty());
+}
+
+TEST_F(ShardedContactManagerTest, UpdateRollsBackWhenNameTaken) {
+    const Contact moving("Bob 0", "555-0002");
+    ASSERT_TRUE(manager.addContact(moving));
+    
+    // The name it is renamed to already lives in another shard
+    const Contact occupant(nameInShard("Carol", manager.shardFor(moving), false), "555-0003");
+    ASSERT_TRUE(manager.addContact(occupant));
+    
+    EXPECT_FALSE(manager.updateContact(moving, Contact(occupant.getName(), "555-0004")));
+    
+    // Both are where they were, in the trees and in the indexes
+    EXPECT_EQ(manager.getContactCount(), 2);
+    const QList<Contact> bobs = manager.searchContacts("Bob 0");
+    ASSERT_EQ(bobs.size(), 1);
+    EXPECT_EQ(bobs[0].getPhone(), "555-0002");
+    const QList<Contact> carols = manager.query(ContactQuery::compile("name:carol"));
+    ASSERT_EQ(carols.size(), 1);
+    EXPECT_EQ(carols[0].getPhone(), "555-0003");
+    EXPECT_EQ(manager.query(ContactQuery::compile("name:bob")).size(), 1);
+}
+
+TEST_F(ShardedContactManagerTest, ImportBatchReportsRejectionsInRowOrder) {
+    // Duplicates land in different shards; the invalid row comes last
+    QList<Contact> batch;
+    for (int i = 0; i < 8; ++i) {
+        batch.append(Contact(QString("Person %1").arg(i), QString("555-%1").arg(i)));
+    }
+    for (int i = 7; i >= 0; --i) {
+        batch.append(Contact(QString("person %1").arg(i), "555-0000"));
+    }
+    batch.append(Contact("No Phone", ""));
+    
+    const ImportReport report = manager.importContactsBatch(batch);
+    EXPECT_EQ(report.added, 8);
+    EXPECT_EQ(report.duplicates, 8);
+    EXPECT_EQ(report.invalid, 1);
+    ASSERT_EQ(report.rejections.size(), 9);
+    for (int i = 0; i < report.rejections.size(); ++i) {
+        EXPECT_EQ(report.rejections[i].row, 8 + i);
+    }
+    EXPECT_EQ(report.rejections.last().reason, ImportReport::InvalidContact);
+}
+
+TEST(KWayMergeTest, MatchesSortedConcatenation) {
+    std::mt19937 random(42);
+    auto less = [](const int& a, const int& b) { return a < b; };
+    
+    for (int lists : {0, 1, 2, 7, 16}) {
+        QList<QList<int>> sortedLists;
+        QList<int> expected;
+        for (int i = 0; i < lists; ++i) {
+            // Some lists empty, values overlapping across lists
+            QList<int> list;
+            const int size = static_cast<int>(random() % 50);
+            for (int j = 0; j < size; ++j) {
+                list.append(static_cast<int>(random() % 100));
+            }
+            std::sort(list.begin(), list.end());
+            expected.append(list);
+            sortedLists.append(list);
+        }
+        std::sort(expected.begin(), expected.end());
+        
+        EXPECT_EQ(SearchSort::kWayMerge<int>(sortedLists, less), expected) << lists << " lists";
+    }
+}
+
+TEST(KWayMergeTest, MergesContactsByName) {
+    const QList<QList<Contact>> perShard = {
+        {Contact("alice", "1"), Contact("Dave", "4")},
+        {},
+        {Contact("Bob", "2"), Contact("carol", "3"), Contact("Eve", "5")},
+    };
+    
+    const QList<Contact> merged = SearchSort::kWayMerge<Contact>(perShard, [](const Contact& a, const Contact& b) {
+        return a < b;
+    });
+    
+    QStringList phones;
+    for (const Contact& contact : merged) {
+        phones.append(contact.getPhone());
+    }
+    EXPECT_EQ(phones, QStringList({"1", "2", "3", "4", "5"}));
+}
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}